@@ -1,5 +1,8 @@
 #pragma once
 
+class TaskGroup;
+class FrameSnapshot;
+
 class GameComponent
 {
 public:
@@ -11,5 +14,11 @@ public:
     virtual void imgui() = 0;
     virtual void reload() = 0;
     virtual void update() = 0;
+    // optional parallel part of update: schedule tasks into group, they are finished before update() call
+    virtual void update_jobs(TaskGroup&) {}
+    // simulation side, after update(): store everything draw() needs into snapshot
+    virtual void write_snapshot(FrameSnapshot&) const {}
+    // render side, before draw(): take state from snapshot, upload constant buffers here
+    virtual void read_snapshot(const FrameSnapshot&) {}
     virtual void destroy_resources() = 0;
 };
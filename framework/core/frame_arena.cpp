@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cassert>
+#include "frame_arena.h"
+
+namespace
+{
+thread_local FrameArena* tls_frame_arena = nullptr;
+
+uintptr_t align_up(uintptr_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~uintptr_t(alignment - 1);
+}
+}
+
+FrameArena::FrameArena(size_t capacity) : block_{ new uint8_t[capacity] }, capacity_{ capacity }
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for (uint8_t* block : overflow_blocks_) {
+        delete[] block;
+    }
+    delete[] block_;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    uintptr_t begin = uintptr_t(block_);
+    uintptr_t position = align_up(begin + offset_, alignment);
+    if (position + size <= begin + capacity_) {
+        offset_ = size_t(position + size - begin);
+        peak_ = std::max(peak_, offset_ + overflow_bytes_);
+        return reinterpret_cast<void*>(position);
+    }
+
+    // out of block - heap until next reset
+    uint8_t* block = new uint8_t[size + alignment];
+    overflow_blocks_.push_back(block);
+    overflow_bytes_ += size + alignment;
+    peak_ = std::max(peak_, offset_ + overflow_bytes_);
+    return reinterpret_cast<void*>(align_up(uintptr_t(block), alignment));
+}
+
+void FrameArena::reset()
+{
+    for (uint8_t* block : overflow_blocks_) {
+        delete[] block;
+    }
+    overflow_blocks_.clear();
+
+    if (overflow_bytes_ > 0)
+    {
+        // grow to fit the biggest frame seen
+        size_t capacity = std::max<size_t>(capacity_, 1);
+        while (capacity < peak_) {
+            capacity *= 2;
+        }
+        delete[] block_;
+        block_ = new uint8_t[capacity];
+        capacity_ = capacity;
+    }
+
+    offset_ = 0;
+    overflow_bytes_ = 0;
+}
+
+size_t FrameArena::used() const
+{
+    return offset_ + overflow_bytes_;
+}
+
+size_t FrameArena::peak() const
+{
+    return peak_;
+}
+
+size_t FrameArena::capacity() const
+{
+    return capacity_;
+}
+
+// static
+FrameArena* FrameArena::current()
+{
+    return tls_frame_arena;
+}
+
+// static
+void FrameArena::set_current(FrameArena* arena)
+{
+    tls_frame_arena = arena;
+}
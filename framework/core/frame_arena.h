@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Non-owning view of contiguous values
+template<typename T>
+class Span
+{
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_{ data }, size_{ size } {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+    T& operator[](size_t index) const { return data_[index]; }
+
+private:
+    T* data_{ nullptr };
+    size_t size_{ 0 };
+};
+
+// Linear allocator for temporaries which live until end of frame.
+// Allocation is a pointer bump, reset() frees everything at once.
+// If frame needs more than capacity, extra blocks are taken from heap
+// and arena grows on next reset, so steady state does not touch the heap.
+class FrameArena final
+{
+public:
+    constexpr static size_t default_capacity = 1 << 20;
+
+    explicit FrameArena(size_t capacity = default_capacity);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // destructors are never called - only trivially destructible types
+    template<typename T>
+    Span<T> allocate_span(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena does not call destructors");
+        T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; ++i) {
+            new (data + i) T();
+        }
+        return Span<T>(data, count);
+    }
+
+    void reset();
+
+    size_t used() const;     // bytes allocated in current frame
+    size_t peak() const;     // max bytes allocated in one frame
+    size_t capacity() const;
+
+    // arena of the frame which runs on calling thread (simulation or render), nullptr outside of frame
+    static FrameArena* current();
+    static void set_current(FrameArena* arena);
+
+private:
+    uint8_t* block_{ nullptr };
+    size_t capacity_{ 0 };
+    size_t offset_{ 0 };
+
+    std::vector<uint8_t*> overflow_blocks_;
+    size_t overflow_bytes_{ 0 };
+    size_t peak_{ 0 };
+};
+
+// std allocator over frame arena: containers must not outlive the frame
+template<typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    explicit FrameAllocator(FrameArena& arena) : arena_{ &arena } {}
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena_{ other.arena() } {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(arena_->allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+        // freed on arena reset
+    }
+
+    FrameArena* arena() const { return arena_; }
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>& other) const { return arena_ == other.arena(); }
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    FrameArena* arena_;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,46 @@
+#include <cassert>
+#include "frame_snapshot.h"
+
+namespace
+{
+constexpr size_t entry_alignment = 16; // enough for SimpleMath types
+}
+
+void FrameSnapshot::clear()
+{
+    frame_index = 0;
+    delta_time = 0.f;
+    input_time = {};
+    camera = {};
+    entries_.clear();
+    data_.clear();
+}
+
+void FrameSnapshot::store_bytes(const void* owner, const void* data, size_t size)
+{
+#ifndef NDEBUG
+    size_t stored_size = 0;
+    assert(load_bytes(owner, stored_size) == nullptr); // one entry per owner
+#endif
+
+    size_t offset = (data_.size() + entry_alignment - 1) & ~(entry_alignment - 1);
+    data_.resize(offset + size);
+    if (size > 0) {
+        memcpy(data_.data() + offset, data, size);
+    }
+    entries_.push_back({ owner, offset, size });
+}
+
+const void* FrameSnapshot::load_bytes(const void* owner, size_t& size) const
+{
+    // few owners per frame - linear search is fine
+    for (const auto& entry : entries_)
+    {
+        if (entry.owner == owner) {
+            size = entry.size;
+            return data_.data() + entry.offset;
+        }
+    }
+    size = 0;
+    return nullptr;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <SimpleMath.h>
+using namespace DirectX::SimpleMath;
+
+// Immutable copy of simulation state for one rendered frame.
+// Written by simulation thread, read by render thread (see TripleBuffer).
+// Components store plain structs keyed by any owner pointer (usually this),
+// storage is reused between frames, so steady state does not allocate.
+class FrameSnapshot final
+{
+public:
+    struct CameraState
+    {
+        Matrix view;
+        Matrix proj;
+        Matrix view_proj;
+        Vector3 position;
+        Vector3 direction;
+    };
+
+    uint64_t frame_index{ 0 }; // 0 - nothing simulated yet
+    float delta_time{ 0.f };
+    // time of the newest input event used by this frame
+    std::chrono::steady_clock::time_point input_time{};
+    CameraState camera{};
+
+    void clear();
+
+    template<typename T>
+    void store(const void* owner, const T* values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot stores only plain data");
+        store_bytes(owner, values, sizeof(T) * count);
+    }
+
+    template<typename T>
+    void store(const void* owner, const T& value)
+    {
+        store(owner, &value, 1);
+    }
+
+    // values stored by owner, nullptr if owner stored nothing
+    template<typename T>
+    const T* load(const void* owner, size_t* count = nullptr) const
+    {
+        size_t size = 0;
+        const void* data = load_bytes(owner, size);
+        if (count != nullptr) {
+            *count = size / sizeof(T);
+        }
+        return static_cast<const T*>(data);
+    }
+
+private:
+    void store_bytes(const void* owner, const void* data, size_t size);
+    const void* load_bytes(const void* owner, size_t& size) const;
+
+    struct Entry
+    {
+        const void* owner;
+        size_t offset;
+        size_t size;
+    };
+    std::vector<Entry> entries_;
+    std::vector<uint8_t> data_;
+};
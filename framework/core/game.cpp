@@ -1,16 +1,33 @@
 #include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 #include "game.h"
+#include "job_system.h"
+#include "frame_arena.h"
+#include "heap_tracker.h"
+#include "profiler.h"
+#include "triple_buffer.h"
+#include "frame_snapshot.h"
 #include "win32/win.h"
 #include "win32/input.h"
+#include "win32/input_record.h"
 #include "render/render.h"
 #include "render/annotation.h"
 #include "render/camera.h"
+#include "render/scene/asset_loader.h"
 #include "component/game_component.h"
 
 Game::Game()
 {
     win_ = std::make_unique<Win>();
     render_ = std::make_unique<Render>();
+    jobs_ = std::make_unique<JobSystem>();
+    assets_ = std::make_unique<AssetLoader>();
+    snapshots_ = std::make_unique<TripleBuffer<FrameSnapshot>>();
+    simulation_arena_ = std::make_unique<FrameArena>();
+    render_arena_ = std::make_unique<FrameArena>();
 }
 
 // static
@@ -45,8 +62,81 @@ bool Game::initialize(uint32_t w, uint32_t h)
     return animating_;
 }
 
+bool Game::initialize_headless(uint32_t w, uint32_t h)
+{
+    headless_ = true;
+
+    win_->initialize_headless(w, h);
+    render_->initialize_headless();
+
+    for (auto game_component : game_components_)
+    {
+        game_component->initialize();
+    }
+
+    animating_ = true; // initialized
+    return animating_;
+}
+
+void Game::set_threaded(bool threaded, float max_update_rate)
+{
+    threaded_ = threaded;
+    max_update_rate_ = max_update_rate;
+}
+
+bool Game::record_input(const std::string& filename)
+{
+    auto recorder = std::make_unique<InputRecorder>();
+    if (!recorder->open(filename)) {
+        OutputDebugString(("Can not open input record " + filename + "\n").c_str());
+        return false;
+    }
+    // models which become resident mid-session change simulation (radius, position callbacks)
+    // on whatever frame loading finishes: record and replay both start with everything resident
+    assets_->flush();
+    input_recorder_ = std::move(recorder);
+    return true;
+}
+
+bool Game::replay_input(const std::string& filename)
+{
+    auto player = std::make_unique<InputPlayer>();
+    if (!player->open(filename)) {
+        OutputDebugString(("Can not open input replay " + filename + "\n").c_str());
+        return false;
+    }
+    assets_->flush(); // as before record
+    input_player_ = std::move(player);
+    return true;
+}
+
+void Game::parse_command_line(const char* command_line)
+{
+    std::istringstream stream(command_line != nullptr ? command_line : "");
+    std::string option;
+    while (stream >> std::quoted(option))
+    {
+        std::string filename;
+        if (option == "-record" && stream >> std::quoted(filename)) {
+            record_input(filename);
+        } else if (option == "-replay" && stream >> std::quoted(filename)) {
+            replay_input(filename);
+        }
+    }
+}
+
+const InputPlayer* Game::input_player() const
+{
+    return input_player_.get();
+}
+
 void Game::run()
 {
+    if (threaded_) {
+        run_threaded();
+        return;
+    }
+
     while (!destroy_)
     {
         // handle win messages
@@ -62,77 +152,263 @@ void Game::run()
             continue;
         }
 
+        frame();
+    }
+    // next step - destroy
+}
+
+void Game::run_threaded()
+{
+    // window messages and rendering stay on this thread, update goes to simulation thread
+    Profiler::set_thread_name("render");
+    std::thread simulation_thread([this] {
+        Profiler::set_thread_name("simulation");
+        auto next_update = std::chrono::steady_clock::now();
+        while (!destroy_)
         {
-            // prepares
-            {
-                Annotation annotation("prepare resources");
-                render_->prepare_frame();
-                render_->prepare_resources();
+            if (!animating_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
             }
 
-            { // update components
-                for (auto game_component : game_components_)
-                {
-                    game_component->update();
-                }
-            }
+            win_->input()->process_win_input();
+
+            simulate(snapshots_->write_buffer());
+            snapshots_->publish();
 
+            if (max_update_rate_ > 0.f)
             {
-                Annotation annotation("draw components");
-                for (auto game_component : game_components_)
-                {
-                    game_component->draw();
+                next_update += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.f / max_update_rate_));
+                auto now = std::chrono::steady_clock::now();
+                if (next_update < now) {
+                    next_update = now; // too slow - don't try to catch up
                 }
+                std::this_thread::sleep_until(next_update);
             }
+        }
+    });
+
+    while (!destroy_)
+    {
+        // handle win messages
+        win_->run();
+
+        if (!animating_) {
+            continue;
+        }
+
+        // take newest snapshot, render the previous one again if simulation is slower
+        snapshots_->acquire();
+        const FrameSnapshot& snapshot = snapshots_->read_buffer();
+        if (snapshot.frame_index == 0) {
+            std::this_thread::yield(); // nothing simulated yet
+            continue;
+        }
+
+        render_frame(snapshot);
+    }
+
+    simulation_thread.join();
+    // next step - destroy
+}
+
+void Game::frame()
+{
+    simulate(snapshots_->write_buffer());
+    snapshots_->publish();
+
+    snapshots_->acquire();
+    render_frame(snapshots_->read_buffer());
+}
 
-            // Handle components imgui
+void Game::simulate(FrameSnapshot& snapshot)
+{
+    ProfileScope simulate_scope("simulate");
+    FrameArena::set_current(simulation_arena_.get());
+
+    Input* input = win_->input();
+    if (input_player_)
+    {
+        InputFrame input_frame;
+        if (input_player_->read(input_frame)) {
+            input->set_state(input_frame.keyboard, input_frame.mouse);
+            delta_time_ = input_frame.delta_time;
+        } else {
+            // replay is over
+            animating_ = false;
+            destroy_ = true;
+        }
+    }
+    if (input_recorder_) {
+        input_recorder_->write({ delta_time_, input->keyboard(), input->mouse() });
+    }
+
+    // models loaded since last step become resident
+    assets_->update();
+
+    render_->update_camera();
+
+    { // update components
+        {
+            ProfileScope update_jobs_scope("update jobs");
+            TaskGroup update_group(*jobs_);
+            for (auto game_component : game_components_)
             {
-                Annotation annotation("draw imgui for components");
-                render_->prepare_imgui();
-                for (auto game_component : game_components_)
-                {
-                    game_component->imgui();
-                }
-                render_->end_imgui();
+                game_component->update_jobs(update_group);
             }
+            update_group.wait();
+        }
+
+        ProfileScope update_scope("update");
+        for (auto game_component : game_components_)
+        {
+            game_component->update();
+        }
+    }
+
+    { // store state for render
+        ProfileScope snapshot_scope("write snapshot");
+        snapshot.clear();
+        snapshot.frame_index = ++simulated_frames_;
+        snapshot.delta_time = delta_time_;
+        snapshot.input_time = input->last_event_time();
+
+        auto camera = render_->camera();
+        snapshot.camera.view = camera->view();
+        snapshot.camera.proj = camera->proj();
+        snapshot.camera.view_proj = snapshot.camera.view * snapshot.camera.proj;
+        snapshot.camera.position = camera->position();
+        snapshot.camera.direction = camera->direction();
+
+        for (auto game_component : game_components_)
+        {
+            game_component->write_snapshot(snapshot);
+        }
+    }
+
+    // clear keyboard
+    {
+        input->clear_after_process();
+    }
+
+    // handle simulation step
+    {
+        static auto prev_time {
+            std::chrono::steady_clock::now()
+        };
+        auto cur_time = std::chrono::steady_clock::now();
+        if (!input_player_) { // replay sets recorded step
+            delta_time_ = std::chrono::duration_cast<std::chrono::microseconds>(cur_time - prev_time).count() / 1e6f;
+        }
+        prev_time = cur_time;
+
+        update_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    simulation_arena_->reset();
+    FrameArena::set_current(nullptr);
+}
+
+void Game::render_frame(const FrameSnapshot& snapshot)
+{
+    {
+        ProfileScope render_scope("render frame");
+        FrameArena::set_current(render_arena_.get());
+
+        // prepares
+        {
+            Annotation annotation("prepare resources");
+            render_->prepare_frame();
+            render_->prepare_resources();
+            assets_->upload();
+
+            for (auto game_component : game_components_)
             {
-                Annotation annotation("after draw");
-                render_->restore_targets();
-                render_->end_frame();
+                game_component->read_snapshot(snapshot);
             }
         }
 
-        // clear keyboard
         {
-            win_->input()->clear_after_process();
+            Annotation annotation("draw components");
+            for (auto game_component : game_components_)
+            {
+                game_component->draw();
+            }
         }
 
-        // handle FPS
+        // Handle components imgui
+        if (!headless_) {
+            Annotation annotation("draw imgui for components");
+            render_->prepare_imgui();
+            for (auto game_component : game_components_)
+            {
+                game_component->imgui();
+            }
+            render_->end_imgui();
+        }
         {
-            static auto prev_time {
-                std::chrono::steady_clock::now()
-            };
-            static float total_time = 0;
-            static uint32_t frame_count = 0;
-            auto cur_time = std::chrono::steady_clock::now();
-            delta_time_ = std::chrono::duration_cast<std::chrono::microseconds>(cur_time - prev_time).count() / 1e6f;
-            prev_time = cur_time;
+            Annotation annotation("after draw");
+            render_->restore_targets();
+            render_->end_frame();
+        }
+
+        render_arena_->reset();
+        FrameArena::set_current(nullptr);
+        HeapTracker::end_frame();
+    }
 
-            total_time += delta_time_;
-            frame_count++;
+    // handle FPS, update rate and input latency
+    {
+        static auto prev_time {
+            std::chrono::steady_clock::now()
+        };
+        static float total_time = 0;
+        static uint32_t frame_count = 0;
+        static std::chrono::steady_clock::time_point measured_input_time{};
+        static float latency_sum = 0.f;
+        static uint32_t latency_count = 0;
+
+        auto cur_time = std::chrono::steady_clock::now();
+        float frame_time = std::chrono::duration_cast<std::chrono::microseconds>(cur_time - prev_time).count() / 1e6f;
+        prev_time = cur_time;
+
+        // input event -> present of the first frame which used it
+        if (snapshot.input_time != std::chrono::steady_clock::time_point{} && snapshot.input_time != measured_input_time) {
+            measured_input_time = snapshot.input_time;
+            latency_sum += std::chrono::duration_cast<std::chrono::microseconds>(cur_time - snapshot.input_time).count() / 1e3f;
+            latency_count++;
+        }
 
-            if (total_time > 1.0f) {
-                OutputDebugString(("FPS: " + std::to_string(frame_count / total_time) + "\n").c_str());
-                total_time -= 1.0f;
-                frame_count = 0;
+        total_time += frame_time;
+        frame_count++;
+
+        if (total_time > 1.0f) {
+            // formatted on stack: frame loop does not allocate
+            char info[128];
+            int length = std::snprintf(info, sizeof(info), "FPS: %f, updates: %f",
+                                       frame_count / total_time, update_count_.exchange(0) / total_time);
+            if (latency_count > 0) {
+                length += std::snprintf(info + length, sizeof(info) - length, ", input latency: %f ms", latency_sum / latency_count);
+            }
+            if (HeapTracker::available()) {
+                length += std::snprintf(info + length, sizeof(info) - length, ", heap allocations: %llu",
+                                        (unsigned long long)HeapTracker::last_frame().count);
             }
+            std::snprintf(info + length, sizeof(info) - length, "\n");
+            OutputDebugString(info);
+            total_time -= 1.0f;
+            frame_count = 0;
+            latency_sum = 0.f;
+            latency_count = 0;
         }
     }
-    // next step - destroy
 }
 
 void Game::destroy()
 {
+    // loader jobs write into models of components
+    assets_->destroy();
+
     for (auto game_component : game_components_)
     {
         game_component->destroy_resources();
@@ -141,6 +417,13 @@ void Game::destroy()
 
     render_->destroy_resources();
     win_->destroy();
+
+    // finalize record header
+    input_recorder_.reset();
+    input_player_.reset();
+
+    // join workers before static destruction
+    jobs_.reset();
 }
 
 float Game::delta_time() const
@@ -178,3 +461,13 @@ const Render& Game::render() const
 {
     return *render_;
 }
+
+JobSystem& Game::jobs() const
+{
+    return *jobs_;
+}
+
+AssetLoader& Game::assets() const
+{
+    return *assets_;
+}
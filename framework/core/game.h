@@ -1,27 +1,60 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <unordered_set>
 
 class Win;
 class Render;
 class GameComponent;
+class JobSystem;
+class AssetLoader;
+class FrameSnapshot;
+class FrameArena;
+class InputRecorder;
+class InputPlayer;
+template<typename T> class TripleBuffer;
 
 class Game
 {
 private:
     std::unique_ptr<Win> win_;
     std::unique_ptr<Render> render_;
+    std::unique_ptr<JobSystem> jobs_;
+    std::unique_ptr<AssetLoader> assets_;
 
-    float delta_time_{ 0.f };
+    // simulation -> render state
+    std::unique_ptr<TripleBuffer<FrameSnapshot>> snapshots_;
+    uint64_t simulated_frames_{ 0 };
+    std::atomic<uint32_t> update_count_{ 0 }; // for update rate statistics
 
-    bool destroy_{ false };
-    bool animating_{ false };
+    // temporaries of one simulation step / rendered frame
+    std::unique_ptr<FrameArena> simulation_arena_;
+    std::unique_ptr<FrameArena> render_arena_;
+
+    float delta_time_{ 0.f }; // simulation step
+
+    // deterministic sessions: input and delta time go to / come from file
+    std::unique_ptr<InputRecorder> input_recorder_;
+    std::unique_ptr<InputPlayer> input_player_;
+
+    std::atomic<bool> destroy_{ false };
+    std::atomic<bool> animating_{ false };
     bool fullscreen_{ false };
+    bool headless_{ false };
+    bool threaded_{ false };
+    float max_update_rate_{ 0.f };
 
     std::unordered_set<GameComponent*> game_components_;
 
+    void run_threaded();
+    // update components and store their state into snapshot
+    void simulate(FrameSnapshot& snapshot);
+    // draw components from snapshot and present
+    void render_frame(const FrameSnapshot& snapshot);
+
     Game();
     Game(Game&) = delete;
     Game(const Game&&) = delete;
@@ -32,7 +65,25 @@ public:
     virtual void add_component(GameComponent*);
 
     virtual bool initialize(uint32_t, uint32_t);
+    // without window and GPU: render calls go to null backend
+    virtual bool initialize_headless(uint32_t, uint32_t);
+    // Run update on separate simulation thread, window thread only renders newest snapshot.
+    // max_update_rate limits simulation frequency (0 - unlimited). Call before run().
+    void set_threaded(bool threaded, float max_update_rate = 0.f);
+    // Write processed input and delta time of every simulated frame to file.
+    // Loads queued assets synchronously first, call before run() / first frame().
+    bool record_input(const std::string& filename);
+    // Take input and delta time from recorded file instead of window and clock,
+    // game stops when record is over. Loads queued assets synchronously first,
+    // so replay starts from the same resident models as record. Call before run() / first frame().
+    bool replay_input(const std::string& filename);
+    // handles "-record <file>" and "-replay <file>"
+    void parse_command_line(const char* command_line);
+    const InputPlayer* input_player() const; // nullptr without replay
+
     virtual void run();
+    // update and draw all components once on calling thread
+    virtual void frame();
     virtual void destroy();
 
     float delta_time() const;
@@ -44,4 +95,6 @@ public:
 
     const Win& win() const;
     const Render& render() const;
+    JobSystem& jobs() const;
+    AssetLoader& assets() const;
 };
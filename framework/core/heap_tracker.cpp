@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "heap_tracker.h"
+#include "profiler.h"
+
+namespace
+{
+struct ScopeCounters
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> peak_bytes;
+};
+
+// slot 0 - outside of any scope, last slot - scopes which do not fit
+ScopeCounters scope_counters[HeapTracker::max_scopes];
+constexpr uint32_t no_scope_slot = 0;
+constexpr uint32_t other_slot = HeapTracker::max_scopes - 1;
+constexpr uint32_t untracked_slot = ~0u;
+
+std::atomic<bool> tracker_enabled{ true };
+
+// tracker's own reports are not attributed to user scopes
+thread_local bool tls_suspended = false;
+
+// counters at the end of previous frame
+uint64_t frame_base_count[HeapTracker::max_scopes];
+uint64_t frame_base_bytes[HeapTracker::max_scopes];
+HeapTracker::FrameReport last_frame_report;
+
+std::string slot_name(uint32_t slot)
+{
+    if (slot == no_scope_slot) {
+        return "(no scope)";
+    }
+    if (slot == other_slot) {
+        return "(other)";
+    }
+    return Profiler::scope_name(slot - 1);
+}
+
+HeapTracker::Stats slot_stats(uint32_t slot)
+{
+    const ScopeCounters& counters = scope_counters[slot];
+    HeapTracker::Stats stats;
+    stats.scope = slot_name(slot);
+    stats.count = counters.count.load(std::memory_order_relaxed);
+    stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+    stats.live_bytes = uint64_t(std::max<int64_t>(0, counters.live_bytes.load(std::memory_order_relaxed)));
+    stats.peak_bytes = uint64_t(counters.peak_bytes.load(std::memory_order_relaxed));
+    return stats;
+}
+
+// RAII: allocations of tracker itself go untracked
+class SuspendScope
+{
+public:
+    SuspendScope() : previous_{ tls_suspended } { tls_suspended = true; }
+    ~SuspendScope() { tls_suspended = previous_; }
+private:
+    bool previous_;
+};
+}
+
+bool HeapTracker::available()
+{
+#ifdef FRAMEWORK_HEAP_TRACKER
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HeapTracker::set_enabled(bool enabled)
+{
+    tracker_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool HeapTracker::enabled()
+{
+    return tracker_enabled.load(std::memory_order_relaxed);
+}
+
+HeapTracker::Stats HeapTracker::total()
+{
+    SuspendScope suspend;
+    Stats res{ "(total)", 0, 0, 0, 0 };
+    for (uint32_t slot = 0; slot < max_scopes; ++slot)
+    {
+        const ScopeCounters& counters = scope_counters[slot];
+        res.count += counters.count.load(std::memory_order_relaxed);
+        res.bytes += counters.bytes.load(std::memory_order_relaxed);
+        res.live_bytes += uint64_t(std::max<int64_t>(0, counters.live_bytes.load(std::memory_order_relaxed)));
+        res.peak_bytes += uint64_t(counters.peak_bytes.load(std::memory_order_relaxed)); // upper bound: scope peaks are not simultaneous
+    }
+    return res;
+}
+
+std::vector<HeapTracker::Stats> HeapTracker::top(size_t n)
+{
+    SuspendScope suspend;
+    std::vector<Stats> res;
+    for (uint32_t slot = 0; slot < max_scopes; ++slot)
+    {
+        if (scope_counters[slot].count.load(std::memory_order_relaxed) > 0) {
+            res.push_back(slot_stats(slot));
+        }
+    }
+    std::sort(res.begin(), res.end(), [](const Stats& a, const Stats& b) { return a.bytes > b.bytes; });
+    if (res.size() > n) {
+        res.resize(n);
+    }
+    return res;
+}
+
+void HeapTracker::end_frame()
+{
+    SuspendScope suspend;
+    FrameReport& report = last_frame_report;
+    report.frame++;
+    report.count = 0;
+    report.bytes = 0;
+    report.scopes.clear();
+
+    for (uint32_t slot = 0; slot < max_scopes; ++slot)
+    {
+        uint64_t count = scope_counters[slot].count.load(std::memory_order_relaxed);
+        uint64_t bytes = scope_counters[slot].bytes.load(std::memory_order_relaxed);
+        uint64_t frame_count = count - frame_base_count[slot];
+        uint64_t frame_bytes = bytes - frame_base_bytes[slot];
+        frame_base_count[slot] = count;
+        frame_base_bytes[slot] = bytes;
+        if (frame_count == 0) {
+            continue;
+        }
+
+        Stats stats = slot_stats(slot);
+        stats.count = frame_count;
+        stats.bytes = frame_bytes;
+        report.scopes.push_back(stats);
+        report.count += frame_count;
+        report.bytes += frame_bytes;
+    }
+    std::sort(report.scopes.begin(), report.scopes.end(), [](const Stats& a, const Stats& b) { return a.bytes > b.bytes; });
+}
+
+const HeapTracker::FrameReport& HeapTracker::last_frame()
+{
+    return last_frame_report;
+}
+
+#ifdef FRAMEWORK_HEAP_TRACKER
+namespace
+{
+// right before user memory, keeps it 16 bytes aligned
+struct alignas(16) AllocationHeader
+{
+    uint64_t size;
+    uint32_t slot;
+    uint32_t offset; // of user memory from malloc block
+};
+
+uint32_t current_slot()
+{
+    if (tls_suspended || !tracker_enabled.load(std::memory_order_relaxed)) {
+        return untracked_slot;
+    }
+    uint32_t scope = Profiler::current_scope();
+    if (scope == Profiler::no_scope) {
+        return no_scope_slot;
+    }
+    return scope + 1 < other_slot ? scope + 1 : other_slot;
+}
+
+// alignment: power of two, over-aligned memory gets padding in front of the header
+void* tracked_allocate(size_t size, size_t alignment = alignof(AllocationHeader))
+{
+    const size_t padding = alignment > alignof(AllocationHeader) ? alignment - alignof(AllocationHeader) : 0;
+    auto block = static_cast<char*>(std::malloc(sizeof(AllocationHeader) + padding + size));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    const uintptr_t user = (uintptr_t(block) + sizeof(AllocationHeader) + padding) & ~(uintptr_t(alignment) - 1);
+    auto header = reinterpret_cast<AllocationHeader*>(user) - 1;
+
+    header->offset = uint32_t(user - uintptr_t(block));
+    header->size = size;
+    header->slot = current_slot();
+    if (header->slot != untracked_slot)
+    {
+        ScopeCounters& counters = scope_counters[header->slot];
+        counters.count.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(size, std::memory_order_relaxed);
+        int64_t live = counters.live_bytes.fetch_add(int64_t(size), std::memory_order_relaxed) + int64_t(size);
+        int64_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+    return header + 1;
+}
+
+void tracked_free(void* ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    auto header = static_cast<AllocationHeader*>(ptr) - 1;
+    if (header->slot != untracked_slot) {
+        scope_counters[header->slot].live_bytes.fetch_sub(int64_t(header->size), std::memory_order_relaxed);
+    }
+    std::free(static_cast<char*>(ptr) - header->offset);
+}
+}
+
+void* operator new(size_t size)
+{
+    if (void* ptr = tracked_allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (void* ptr = tracked_allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    tracked_free(ptr);
+}
+
+// over-aligned types (C++17 aligned new)
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = tracked_allocate(size, size_t(alignment))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = tracked_allocate(size, size_t(alignment))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size, size_t(alignment));
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    tracked_free(ptr);
+}
+#endif
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Global operator new/delete instrumentation (built with FRAMEWORK_HEAP_TRACKER),
+// aligned overloads as well when the compiler has aligned new (C++17).
+// Every allocation is attributed to the innermost profiler scope (ProfileScope / Annotation)
+// of the allocating thread. Counters are relaxed atomics indexed by scope id, no locks
+// and no allocations on the hot path.
+class HeapTracker final
+{
+public:
+    constexpr static uint32_t max_scopes = 1024; // later scopes are reported as "(other)"
+
+    struct Stats
+    {
+        std::string scope;
+        uint64_t count;        // allocations
+        uint64_t bytes;        // allocated bytes
+        uint64_t live_bytes;   // allocated - freed
+        uint64_t peak_bytes;   // max live_bytes
+    };
+
+    struct FrameReport
+    {
+        uint64_t frame{ 0 };
+        uint64_t count{ 0 };
+        uint64_t bytes{ 0 };
+        std::vector<Stats> scopes; // scopes which allocated in the frame, by bytes
+    };
+
+    // false if operators are not replaced in this build
+    static bool available();
+
+    static void set_enabled(bool enabled);
+    static bool enabled();
+
+    // totals since start
+    static Stats total();
+
+    // n scopes with most allocated bytes since start
+    static std::vector<Stats> top(size_t n);
+
+    // close current frame: its counters go to last_frame()
+    static void end_frame();
+    static const FrameReport& last_frame(); // call on thread which calls end_frame
+};
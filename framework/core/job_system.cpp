@@ -0,0 +1,569 @@
+#include <cassert>
+#include <algorithm>
+#include "job_system.h"
+#include "profiler.h"
+
+namespace
+{
+// worker identity of current thread
+thread_local JobSystem* tls_job_system = nullptr;
+thread_local uint32_t tls_worker_index = 0;
+// current thread executes a background job
+thread_local bool tls_background = false;
+
+constexpr uint32_t work_queue_capacity = 4096; // must be power of two
+constexpr uint32_t spin_count = 64;
+}
+
+class Job
+{
+public:
+    JobSystem::Task task;
+    Job* parent{ nullptr };
+
+    std::atomic<int32_t> unfinished{ 1 };   // self + unfinished children
+    std::atomic<int32_t> dependencies{ 1 }; // unfinished dependencies + not submitted yet
+    std::atomic<int32_t> references{ 1 };
+    std::atomic<bool> done{ false };
+    bool background{ false };
+
+    std::mutex continuation_mutex;
+    std::vector<Job*> continuations; // guarded by continuation_mutex
+    bool finished{ false };          // guarded by continuation_mutex
+
+    void add_ref()
+    {
+        references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release();
+};
+
+namespace
+{
+// Finished jobs are recycled: steady state frame loop does not touch the heap for jobs.
+class JobPool
+{
+public:
+    Job* acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_jobs_.empty()) {
+                Job* job = free_jobs_.back();
+                free_jobs_.pop_back();
+                return job;
+            }
+        }
+        return new Job();
+    }
+
+    void recycle(Job* job)
+    {
+        job->task = nullptr; // release captures now
+        job->parent = nullptr;
+        job->unfinished.store(1, std::memory_order_relaxed);
+        job->dependencies.store(1, std::memory_order_relaxed);
+        job->references.store(1, std::memory_order_relaxed);
+        job->done.store(false, std::memory_order_relaxed);
+        job->background = false;
+        job->continuations.clear();
+        job->finished = false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_jobs_.push_back(job);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<Job*> free_jobs_;
+};
+
+JobPool& job_pool()
+{
+    static JobPool* pool = new JobPool(); // jobs may be released during static destruction
+    return *pool;
+}
+}
+
+void Job::release()
+{
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        job_pool().recycle(this);
+    }
+}
+
+// Chase-Lev deque with fixed capacity
+// "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al.
+class JobSystem::WorkQueue
+{
+public:
+    WorkQueue() : buffer_(work_queue_capacity)
+    {
+    }
+
+    // owner only
+    bool push(Job* job)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= int64_t(work_queue_capacity)) {
+            return false;
+        }
+        buffer_[bottom & mask_].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // owner only
+    Job* pop()
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        Job* job = nullptr;
+        if (top <= bottom) {
+            job = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // last element - race with stealers
+                if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    job = nullptr;
+                }
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // any thread
+    Job* steal()
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top < bottom) {
+            Job* job = buffer_[top & mask_].load(std::memory_order_relaxed);
+            if (top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    static constexpr int64_t mask_ = work_queue_capacity - 1;
+
+    alignas(64) std::atomic<int64_t> top_{ 0 };
+    alignas(64) std::atomic<int64_t> bottom_{ 0 };
+    std::vector<std::atomic<Job*>> buffer_;
+};
+
+// JobHandle
+JobHandle::JobHandle(Job* job) : job_{ job }
+{
+}
+
+JobHandle::JobHandle(const JobHandle& other) : job_{ other.job_ }
+{
+    if (job_ != nullptr) {
+        job_->add_ref();
+    }
+}
+
+JobHandle::JobHandle(JobHandle&& other) noexcept : job_{ other.job_ }
+{
+    other.job_ = nullptr;
+}
+
+JobHandle& JobHandle::operator=(const JobHandle& other)
+{
+    if (this != &other) {
+        if (other.job_ != nullptr) {
+            other.job_->add_ref();
+        }
+        if (job_ != nullptr) {
+            job_->release();
+        }
+        job_ = other.job_;
+    }
+    return *this;
+}
+
+JobHandle& JobHandle::operator=(JobHandle&& other) noexcept
+{
+    if (this != &other) {
+        if (job_ != nullptr) {
+            job_->release();
+        }
+        job_ = other.job_;
+        other.job_ = nullptr;
+    }
+    return *this;
+}
+
+JobHandle::~JobHandle()
+{
+    if (job_ != nullptr) {
+        job_->release();
+    }
+}
+
+bool JobHandle::valid() const
+{
+    return job_ != nullptr;
+}
+
+bool JobHandle::finished() const
+{
+    return job_ == nullptr || job_->done.load(std::memory_order_acquire);
+}
+
+// JobSystem
+JobSystem::JobSystem(uint32_t thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(2u, std::thread::hardware_concurrency());
+    }
+
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+
+    // creator thread is worker 0
+    tls_job_system = this;
+    tls_worker_index = 0;
+
+    for (uint32_t i = 1; i < thread_count; ++i) {
+        workers_.emplace_back(&JobSystem::worker_main, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    // drain detached jobs
+    while (pending_jobs_.load() > 0)
+    {
+        if (!execute_one(true)) {
+            std::this_thread::yield();
+        }
+    }
+
+    stop_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    assert(pending_jobs_.load() == 0);
+
+    if (tls_job_system == this) {
+        tls_job_system = nullptr;
+    }
+}
+
+uint32_t JobSystem::thread_count() const
+{
+    return static_cast<uint32_t>(queues_.size());
+}
+
+JobHandle JobSystem::create(Task task, const JobHandle& parent)
+{
+    Job* job = job_pool().acquire();
+    job->task = std::move(task);
+    job->background = tls_background && tls_job_system == this;
+    if (parent.job_ != nullptr) {
+        assert(!parent.finished());
+        job->parent = parent.job_;
+        job->parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+        job->parent->add_ref(); // released when child is finished
+    }
+    return JobHandle(job);
+}
+
+void JobSystem::depend(const JobHandle& job, const JobHandle& dependency)
+{
+    assert(job.valid() && dependency.valid());
+    assert(job.job_->dependencies.load() > 0); // not submitted yet
+
+    Job* dep = dependency.job_;
+    std::lock_guard<std::mutex> lock(dep->continuation_mutex);
+    if (!dep->finished) {
+        job.job_->dependencies.fetch_add(1, std::memory_order_relaxed);
+        job.job_->add_ref(); // released when dependency is finished
+        dep->continuations.push_back(job.job_);
+    }
+}
+
+void JobSystem::submit(const JobHandle& job)
+{
+    assert(job.valid());
+    job.job_->add_ref(); // scheduler reference, released after execution
+    if (job.job_->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        push(job.job_);
+    }
+}
+
+JobHandle JobSystem::run(Task task, const JobHandle& parent)
+{
+    JobHandle job = create(std::move(task), parent);
+    submit(job);
+    return job;
+}
+
+JobHandle JobSystem::run_background(Task task)
+{
+    JobHandle job = create(std::move(task));
+    job.job_->background = true;
+    submit(job);
+    return job;
+}
+
+JobHandle JobSystem::then(const JobHandle& dependency, Task task)
+{
+    JobHandle job = create(std::move(task));
+    depend(job, dependency);
+    submit(job);
+    return job;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    const bool background = tls_background || (job.valid() && job.job_->background);
+    while (!job.finished())
+    {
+        if (!execute_one(background)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& func)
+{
+    if (count == 0) {
+        return;
+    }
+    grain = std::max(1u, grain);
+    if (count <= grain) {
+        func(0, count);
+        return;
+    }
+
+    JobHandle root = create([] {});
+    for (uint32_t begin = 0; begin < count; begin += grain)
+    {
+        uint32_t end = std::min(count, begin + grain);
+        run([&func, begin, end] { func(begin, end); }, root);
+    }
+    submit(root);
+    wait(root);
+}
+
+void JobSystem::push(Job* job)
+{
+    pending_jobs_.fetch_add(1);
+
+    bool pushed = false;
+    if (job->background)
+    {
+        std::lock_guard<std::mutex> lock(background_mutex_);
+        background_jobs_.push_back(job);
+        pushed = true;
+    }
+    else if (tls_job_system == this) {
+        pushed = queues_[tls_worker_index]->push(job);
+    }
+    if (!pushed)
+    {
+        if (tls_job_system == this)
+        {
+            // local queue is full - run in place
+            pending_jobs_.fetch_sub(1);
+            execute(job);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        injected_jobs_.push_back(job);
+    }
+
+    if (sleeping_workers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+}
+
+Job* JobSystem::pop(bool background)
+{
+    if (pending_jobs_.load(std::memory_order_relaxed) <= 0) {
+        return nullptr;
+    }
+
+    Job* job = nullptr;
+    const bool is_worker = (tls_job_system == this);
+    const uint32_t own_index = is_worker ? tls_worker_index : 0;
+
+    if (is_worker) {
+        job = queues_[own_index]->pop();
+    }
+
+    if (job == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        if (!injected_jobs_.empty()) {
+            job = injected_jobs_.front();
+            injected_jobs_.pop_front();
+        }
+    }
+
+    if (job == nullptr)
+    {
+        // steal starting from the next worker to spread contention
+        const uint32_t count = thread_count();
+        for (uint32_t i = 1; i <= count && job == nullptr; ++i)
+        {
+            uint32_t victim = (own_index + i) % count;
+            if (is_worker && victim == own_index) {
+                continue;
+            }
+            job = queues_[victim]->steal();
+        }
+    }
+
+    if (job == nullptr && background)
+    {
+        std::lock_guard<std::mutex> lock(background_mutex_);
+        if (!background_jobs_.empty()) {
+            job = background_jobs_.front();
+            background_jobs_.pop_front();
+        }
+    }
+
+    if (job != nullptr) {
+        pending_jobs_.fetch_sub(1);
+    }
+    return job;
+}
+
+bool JobSystem::execute_one(bool background)
+{
+    Job* job = pop(background);
+    if (job == nullptr) {
+        return false;
+    }
+    execute(job);
+    return true;
+}
+
+void JobSystem::execute(Job* job)
+{
+    ProfileScope job_scope("job");
+    const bool background = tls_background;
+    tls_background = job->background;
+    if (job->task) {
+        job->task();
+    }
+    tls_background = background;
+    finish(job);
+    job->release(); // scheduler reference
+}
+
+void JobSystem::finish(Job* job)
+{
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->continuation_mutex);
+        job->finished = true;
+        continuations.swap(job->continuations);
+    }
+    job->done.store(true, std::memory_order_release);
+
+    for (Job* continuation : continuations)
+    {
+        if (continuation->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push(continuation);
+        }
+        continuation->release();
+    }
+
+    if (job->parent != nullptr)
+    {
+        Job* parent = job->parent;
+        job->parent = nullptr;
+        finish(parent);
+        parent->release();
+    }
+}
+
+void JobSystem::worker_main(uint32_t index)
+{
+    tls_job_system = this;
+    tls_worker_index = index;
+    Profiler::set_thread_name("worker " + std::to_string(index));
+
+    uint32_t idle = 0;
+    while (!stop_.load(std::memory_order_relaxed))
+    {
+        // idle worker: background jobs after everything else
+        if (execute_one(true)) {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < spin_count) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleeping_workers_.fetch_add(1);
+        sleep_cv_.wait(lock, [this] { return pending_jobs_.load() > 0 || stop_.load(); });
+        sleeping_workers_.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+// TaskGroup
+TaskGroup::TaskGroup(JobSystem& jobs) : jobs_{ jobs }, root_{ jobs.create([] {}) }
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+JobSystem& TaskGroup::jobs() const
+{
+    return jobs_;
+}
+
+JobHandle TaskGroup::run(JobSystem::Task task)
+{
+    assert(!submitted_);
+    return jobs_.run(std::move(task), root_);
+}
+
+const JobHandle& TaskGroup::handle() const
+{
+    return root_;
+}
+
+void TaskGroup::wait()
+{
+    if (!submitted_) {
+        jobs_.submit(root_);
+        submitted_ = true;
+    }
+    jobs_.wait(root_);
+}
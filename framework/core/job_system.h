@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Job; // opaque task node, defined in job_system.cpp
+
+// Reference counted handle to a job. Job memory lives until last handle is dropped.
+class JobHandle
+{
+public:
+    JobHandle() = default;
+    JobHandle(const JobHandle&);
+    JobHandle(JobHandle&&) noexcept;
+    JobHandle& operator=(const JobHandle&);
+    JobHandle& operator=(JobHandle&&) noexcept;
+    ~JobHandle();
+
+    bool valid() const;
+    bool finished() const;
+
+private:
+    friend class JobSystem;
+    explicit JobHandle(Job* job); // takes ownership of one reference
+
+    Job* job_{ nullptr };
+};
+
+// Work-stealing job system.
+// Every worker owns a Chase-Lev deque: owner pushes and pops from the bottom,
+// idle workers steal from the top. Thread which created the job system is worker 0
+// and executes jobs only while it waits for something (JobSystem::wait, TaskGroup::wait).
+// Background jobs (long loading work) wait in a separate queue: workers take them only when
+// idle, and waits help with them only when they wait for a background job themselves, so
+// frame jobs waiting for their children never run a multi-frame task.
+class JobSystem final
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 - use all hardware threads, at least one worker besides creator thread
+    // (otherwise background jobs run only when waited for)
+    explicit JobSystem(uint32_t thread_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t thread_count() const;
+
+    // Create job without scheduling. Parent (if any) is not finished until this job is finished.
+    JobHandle create(Task task, const JobHandle& parent = {});
+    // Job will not start until dependency is finished. Call before submit.
+    void depend(const JobHandle& job, const JobHandle& dependency);
+    // Schedule created job. Job starts as soon as all its dependencies are finished.
+    void submit(const JobHandle& job);
+
+    // create + submit
+    JobHandle run(Task task, const JobHandle& parent = {});
+    // Continuation: run task after dependency is finished
+    JobHandle then(const JobHandle& dependency, Task task);
+    // Low priority: see above. Jobs created while it runs (children, parallel_for chunks)
+    // are background jobs as well.
+    JobHandle run_background(Task task);
+
+    // Execute other jobs until job (and all its children) is finished,
+    // background ones only when job is a background job or caller runs one
+    void wait(const JobHandle& job);
+
+    // Split [0; count) into chunks of at most grain elements and process them in parallel.
+    // Blocks until all chunks are processed.
+    void parallel_for(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& func);
+
+private:
+    class WorkQueue;
+
+    void push(Job* job);
+    Job* pop(bool background);
+    bool execute_one(bool background);
+    void execute(Job* job);
+    void finish(Job* job);
+    void worker_main(uint32_t index);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    // jobs submitted from non-worker threads
+    std::mutex injected_mutex_;
+    std::deque<Job*> injected_jobs_;
+
+    std::mutex background_mutex_;
+    std::deque<Job*> background_jobs_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int32_t> pending_jobs_{ 0 };
+    std::atomic<int32_t> sleeping_workers_{ 0 };
+    std::atomic<bool> stop_{ false };
+};
+
+// Group of jobs which can be waited together
+class TaskGroup final
+{
+public:
+    explicit TaskGroup(JobSystem& jobs);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    JobSystem& jobs() const;
+
+    JobHandle run(JobSystem::Task task);
+
+    // func(begin, end) is copied into every chunk job: keep captures small (e.g. [this])
+    // so chunk tasks fit std::function inline storage and do not allocate
+    template<typename Func>
+    void parallel_for(uint32_t count, uint32_t grain, Func func)
+    {
+        grain = grain > 0 ? grain : 1;
+        for (uint32_t begin = 0; begin < count; begin += grain)
+        {
+            uint32_t end = count - begin > grain ? begin + grain : count;
+            run([func, begin, end] { func(begin, end); });
+        }
+    }
+
+    // root job of the group: use it as dependency for continuations
+    const JobHandle& handle() const;
+
+    void wait();
+
+private:
+    JobSystem& jobs_;
+    JobHandle root_;
+    bool submitted_{ false };
+};
@@ -0,0 +1,51 @@
+#include <cctype>
+#include <vector>
+
+#include "path.h"
+
+std::string normalize_path(const std::string& path)
+{
+    std::string lower = path;
+    for (auto& c : lower)
+    {
+        c = c == '\\' ? '/' : char(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    const bool absolute = !lower.empty() && lower[0] == '/';
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= lower.size())
+    {
+        size_t end = lower.find('/', begin);
+        if (end == std::string::npos) {
+            end = lower.size();
+        }
+        std::string part = lower.substr(begin, end - begin);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else if (!absolute) {
+                parts.push_back(part);
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        begin = end + 1;
+    }
+
+    std::string normalized = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        if (i > 0) {
+            normalized += '/';
+        }
+        normalized += parts[i];
+    }
+    return normalized;
+}
+
+std::string directory_of(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+// lowercase, forward slashes, "." and "dir/.." removed: one spelling per file on Windows
+std::string normalize_path(const std::string& path);
+// directory part with trailing slash, empty for bare file name
+std::string directory_of(const std::string& path);
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "profiler.h"
+
+namespace
+{
+struct ProfileEvent
+{
+    uint32_t name;
+    uint32_t depth;
+    int64_t start; // ns since profiler epoch
+    int64_t end;
+};
+
+// ring slot, relaxed atomics let readers copy slots while owner overwrites them
+struct ProfileSlot
+{
+    std::atomic<uint64_t> name_depth;
+    std::atomic<int64_t> start;
+    std::atomic<int64_t> end;
+};
+
+std::atomic<bool> profiler_enabled{ true };
+
+thread_local uint32_t tls_current_scope = Profiler::no_scope;
+
+const auto profiler_epoch = std::chrono::steady_clock::now();
+}
+
+// events of one thread
+class ProfileThread
+{
+public:
+    uint32_t id{ 0 };
+    std::string name;                  // guarded by registry mutex
+    uint32_t depth{ 0 };               // owner thread only
+    std::atomic<uint64_t> head{ 0 };   // written by owner thread
+    std::atomic<uint64_t> tail{ 0 };   // first event to report, moved by clear()
+    ProfileSlot events[Profiler::ring_capacity];
+
+    // copy of recorded events, drops slots overwritten while copying
+    std::vector<ProfileEvent> read() const
+    {
+        uint64_t end = head.load(std::memory_order_acquire);
+        uint64_t begin = std::max(tail.load(std::memory_order_relaxed), end > Profiler::ring_capacity ? end - Profiler::ring_capacity : 0);
+
+        std::vector<ProfileEvent> result;
+        result.reserve(size_t(end - begin));
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            const ProfileSlot& slot = events[i & (Profiler::ring_capacity - 1)];
+            uint64_t name_depth = slot.name_depth.load(std::memory_order_relaxed);
+            result.push_back({ uint32_t(name_depth), uint32_t(name_depth >> 32),
+                               slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed) });
+        }
+
+        // owner could overwrite oldest slots (and the one it writes now) meanwhile
+        uint64_t new_head = head.load(std::memory_order_acquire);
+        uint64_t valid_begin = new_head + 1 > Profiler::ring_capacity ? new_head + 1 - Profiler::ring_capacity : 0;
+        if (valid_begin > begin) {
+            result.erase(result.begin(), result.begin() + size_t(std::min(valid_begin, end) - begin));
+        }
+        return result;
+    }
+};
+
+namespace
+{
+struct ProfileRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileThread>> threads; // never freed, threads may exit before export
+    std::unordered_map<std::string, uint32_t> name_ids;
+    std::deque<std::string> names;
+};
+
+ProfileRegistry& registry()
+{
+    static ProfileRegistry* instance = new ProfileRegistry(); // outlives static destructors of other threads
+    return *instance;
+}
+
+ProfileThread* current_thread()
+{
+    thread_local ProfileThread* thread = nullptr;
+    if (thread == nullptr) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.push_back(std::make_unique<ProfileThread>());
+        thread = reg.threads.back().get();
+        thread->id = uint32_t(reg.threads.size());
+        thread->name = "thread " + std::to_string(thread->id);
+    }
+    return thread;
+}
+
+std::string json_escape(const std::string& str)
+{
+    std::string res;
+    res.reserve(str.size());
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\') {
+            res.push_back('\\');
+            res.push_back(c);
+        } else if (uint8_t(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            res += code;
+        } else {
+            res.push_back(c);
+        }
+    }
+    return res;
+}
+
+double percentile(const std::vector<int64_t>& sorted, double p)
+{
+    size_t index = size_t(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)] / 1e6;
+}
+}
+
+void Profiler::set_enabled(bool enabled)
+{
+    profiler_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::enabled()
+{
+    return profiler_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::set_thread_name(const std::string& name)
+{
+    ProfileThread* thread = current_thread();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    thread->name = name;
+}
+
+void Profiler::clear()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& thread : reg.threads) {
+        thread->tail.store(thread->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+std::vector<Profiler::ScopeStats> Profiler::scope_stats()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::vector<std::vector<int64_t>> durations(reg.names.size());
+    for (auto& thread : reg.threads)
+    {
+        for (const auto& event : thread->read()) {
+            durations[event.name].push_back(event.end - event.start);
+        }
+    }
+
+    std::vector<ScopeStats> result;
+    for (uint32_t name = 0; name < durations.size(); ++name)
+    {
+        auto& values = durations[name];
+        if (values.empty()) {
+            continue;
+        }
+        std::sort(values.begin(), values.end());
+
+        int64_t total = 0;
+        for (int64_t value : values) {
+            total += value;
+        }
+
+        ScopeStats stats;
+        stats.name = reg.names[name];
+        stats.count = values.size();
+        stats.total_ms = total / 1e6;
+        stats.mean_ms = stats.total_ms / values.size();
+        stats.p50_ms = percentile(values, 0.50);
+        stats.p95_ms = percentile(values, 0.95);
+        stats.p99_ms = percentile(values, 0.99);
+        stats.max_ms = values.back() / 1e6;
+        result.push_back(stats);
+    }
+
+    std::sort(result.begin(), result.end(), [](const ScopeStats& a, const ScopeStats& b) { return a.total_ms > b.total_ms; });
+    return result;
+}
+
+bool Profiler::export_chrome_trace(const std::string& filename)
+{
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (auto& thread : reg.threads)
+    {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",\n", thread->id, json_escape(thread->name).c_str());
+        first = false;
+
+        for (const auto& event : thread->read())
+        {
+            // microseconds with fractional part keep ns precision
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+                         json_escape(reg.names[event.name]).c_str(), thread->id,
+                         event.start / 1e3, (event.end - event.start) / 1e3, event.depth);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+
+    return std::fclose(file) == 0;
+}
+
+uint32_t Profiler::current_scope()
+{
+    return tls_current_scope;
+}
+
+std::string Profiler::scope_name(uint32_t scope)
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return scope < reg.names.size() ? reg.names[scope] : std::string();
+}
+
+uint32_t Profiler::name_id(const std::string& name)
+{
+    // names repeat every frame - cache them per thread to avoid registry lock
+    thread_local std::unordered_map<std::string, uint32_t> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    auto& reg = registry();
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto reg_it = reg.name_ids.find(name);
+        if (reg_it == reg.name_ids.end()) {
+            id = uint32_t(reg.names.size());
+            reg.names.push_back(name);
+            reg.name_ids.emplace(name, id);
+        } else {
+            id = reg_it->second;
+        }
+    }
+    cache.emplace(name, id);
+    return id;
+}
+
+uint32_t Profiler::name_id(const char* name)
+{
+    // literals have stable address - cheaper lookup than by string
+    thread_local std::unordered_map<const char*, uint32_t> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    uint32_t id = name_id(std::string(name));
+    cache.emplace(name, id);
+    return id;
+}
+
+int64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count();
+}
+
+void Profiler::begin(ProfileThread*& thread, uint32_t name, uint32_t& parent)
+{
+    thread = current_thread();
+    thread->depth++;
+    parent = tls_current_scope;
+    tls_current_scope = name;
+}
+
+void Profiler::end(ProfileThread* thread, uint32_t name, int64_t start, uint32_t parent)
+{
+    int64_t end_time = now();
+    thread->depth--;
+    tls_current_scope = parent;
+
+    uint64_t head = thread->head.load(std::memory_order_relaxed);
+    ProfileSlot& slot = thread->events[head & (ring_capacity - 1)];
+    slot.name_depth.store(uint64_t(name) | (uint64_t(thread->depth) << 32), std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end_time, std::memory_order_relaxed);
+    thread->head.store(head + 1, std::memory_order_release);
+}
+
+// ProfileScope
+ProfileScope::ProfileScope(const char* name)
+{
+    if (Profiler::enabled()) {
+        name_ = Profiler::name_id(name);
+        Profiler::begin(thread_, name_, parent_);
+        start_ = Profiler::now();
+    }
+}
+
+ProfileScope::ProfileScope(const std::string& name)
+{
+    if (Profiler::enabled()) {
+        name_ = Profiler::name_id(name);
+        Profiler::begin(thread_, name_, parent_);
+        start_ = Profiler::now();
+    }
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (thread_ != nullptr) {
+        Profiler::end(thread_, name_, start_, parent_);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU profiler. Scopes are recorded into per-thread ring buffers without locks:
+// only owner thread writes its buffer, readers (stats, export) validate what they copied.
+// Old events are overwritten, so stats and traces cover the last ring_capacity scopes of each thread.
+class Profiler final
+{
+public:
+    constexpr static uint32_t ring_capacity = 1 << 14; // events per thread, power of two
+    constexpr static uint32_t no_scope = ~0u;
+
+    struct ScopeStats
+    {
+        std::string name;
+        uint64_t count;
+        double total_ms;
+        double mean_ms;
+        double p50_ms;
+        double p95_ms;
+        double p99_ms;
+        double max_ms;
+    };
+
+    static void set_enabled(bool enabled);
+    static bool enabled();
+
+    // name shown in trace for current thread
+    static void set_thread_name(const std::string& name);
+
+    // drop all recorded events
+    static void clear();
+
+    // per scope name statistics over recorded events, sorted by total time
+    static std::vector<ScopeStats> scope_stats();
+
+    // Chrome trace event format, open with chrome://tracing or ui.perfetto.dev
+    static bool export_chrome_trace(const std::string& filename);
+
+    // innermost active scope of calling thread (no_scope if none), does not allocate
+    static uint32_t current_scope();
+    static std::string scope_name(uint32_t scope);
+
+private:
+    friend class ProfileScope;
+
+    static uint32_t name_id(const std::string& name);
+    static uint32_t name_id(const char* name);
+    static int64_t now();
+    static void begin(class ProfileThread*& thread, uint32_t name, uint32_t& parent);
+    static void end(class ProfileThread* thread, uint32_t name, int64_t start, uint32_t parent);
+};
+
+// use in scope, does not touch GPU (see Annotation for GPU marked scopes)
+class ProfileScope
+{
+public:
+    ProfileScope(const char* name); // string literal: names are cached by address
+    ProfileScope(const std::string& name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    class ProfileThread* thread_{ nullptr };
+    uint32_t name_{ 0 };
+    uint32_t parent_{ Profiler::no_scope };
+    int64_t start_{ 0 };
+};
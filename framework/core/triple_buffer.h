@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer.
+// Producer fills write_buffer() and publishes it, consumer takes the newest published buffer.
+// Neither side ever waits: producer always has a free slot, consumer skips stale frames.
+template<typename T>
+class TripleBuffer final
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // producer
+    T& write_buffer()
+    {
+        return buffers_[write_index_];
+    }
+
+    void publish()
+    {
+        // swap written slot with shared one and mark it fresh
+        uint32_t previous = shared_.exchange(write_index_ | fresh_bit, std::memory_order_acq_rel);
+        write_index_ = previous & index_mask;
+    }
+
+    // consumer: returns false if nothing was published since last acquire
+    bool acquire()
+    {
+        if ((shared_.load(std::memory_order_relaxed) & fresh_bit) == 0) {
+            return false;
+        }
+        uint32_t previous = shared_.exchange(read_index_, std::memory_order_acq_rel);
+        read_index_ = previous & index_mask;
+        return true;
+    }
+
+    const T& read_buffer() const
+    {
+        return buffers_[read_index_];
+    }
+
+private:
+    constexpr static uint32_t index_mask = 3;
+    constexpr static uint32_t fresh_bit = 4;
+
+    T buffers_[3];
+
+    alignas(64) std::atomic<uint32_t> shared_{ 1 };
+    alignas(64) uint32_t write_index_{ 0 }; // producer only
+    alignas(64) uint32_t read_index_{ 2 };  // consumer only
+};
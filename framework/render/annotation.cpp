@@ -1,16 +1,33 @@
+#include <cstring>
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "annotation.h"
-#include <sstream>
 
-Annotation::Annotation(const std::string& annotation)
+Annotation::Annotation(const char* annotation) : profile_scope_{ annotation }
 {
-    std::wstringstream wannotation;
-    wannotation << annotation.c_str();
-    Game::inst()->render().user_defined_annotation()->BeginEvent(wannotation.str().c_str());
+    begin_event(annotation, strlen(annotation));
+}
+
+Annotation::Annotation(const std::string& annotation) : profile_scope_{ annotation }
+{
+    begin_event(annotation.c_str(), annotation.size());
 }
 
 Annotation::~Annotation()
 {
-    Game::inst()->render().user_defined_annotation()->EndEvent();
+    Game::inst()->render().backend()->end_event();
+}
+
+void Annotation::begin_event(const char* annotation, size_t length)
+{
+    // widen on stack: annotation is created for every scope of every frame
+    constexpr size_t max_length = 127;
+    wchar_t wannotation[max_length + 1];
+    length = length < max_length ? length : max_length;
+    for (size_t i = 0; i < length; ++i) {
+        wannotation[i] = wchar_t(uint8_t(annotation[i]));
+    }
+    wannotation[length] = L'\0';
+    Game::inst()->render().backend()->begin_event(wannotation);
 }
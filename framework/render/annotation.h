@@ -2,10 +2,18 @@
 
 #include <string>
 
-// use in scope
+#include "core/profiler.h"
+
+// use in scope: GPU debug marker + CPU profiler scope
 class Annotation
 {
 public:
-    Annotation(const std::string& annomation);
+    Annotation(const char* annotation); // string literal
+    Annotation(const std::string& annotation);
     ~Annotation();
+
+private:
+    void begin_event(const char* annotation, size_t length);
+
+    ProfileScope profile_scope_;
 };
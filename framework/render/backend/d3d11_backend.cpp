@@ -0,0 +1,332 @@
+#include "render/d3d11_common.h"
+#include "d3d11_backend.h"
+
+D3D11Backend::D3D11Backend(ID3D11Device* device, ID3D11DeviceContext* context, IDXGISwapChain* swapchain) :
+    device_{ device }, context_{ context }, swapchain_{ swapchain }
+{
+    // initialize debug annotations
+    context_->QueryInterface(__uuidof(ID3DUserDefinedAnnotation), reinterpret_cast<void**>(&user_defined_annotation_));
+
+    // constant buffer ranges
+    if (SUCCEEDED(context_.As(&context1_)))
+    {
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+        if (SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+            constant_buffer_offsets_ = options.ConstantBufferOffsetting == TRUE;
+        }
+    }
+}
+
+D3D11Backend::~D3D11Backend()
+{
+    SAFE_RELEASE(user_defined_annotation_);
+}
+
+RenderBackend::Type D3D11Backend::type() const
+{
+    return Type::d3d11;
+}
+
+ID3D11Device* D3D11Backend::device() const
+{
+    return device_.Get();
+}
+
+ID3D11DeviceContext* D3D11Backend::context() const
+{
+    return context_.Get();
+}
+
+HRESULT D3D11Backend::create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer)
+{
+    return device_->CreateBuffer(desc, data, buffer);
+}
+
+HRESULT D3D11Backend::create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture)
+{
+    return device_->CreateTexture2D(desc, data, texture);
+}
+
+HRESULT D3D11Backend::create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view)
+{
+    return device_->CreateShaderResourceView(resource, desc, view);
+}
+
+HRESULT D3D11Backend::create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view)
+{
+    return device_->CreateRenderTargetView(resource, desc, view);
+}
+
+HRESULT D3D11Backend::create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view)
+{
+    return device_->CreateDepthStencilView(resource, desc, view);
+}
+
+HRESULT D3D11Backend::create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state)
+{
+    return device_->CreateSamplerState(desc, state);
+}
+
+HRESULT D3D11Backend::create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state)
+{
+    return device_->CreateRasterizerState(desc, state);
+}
+
+HRESULT D3D11Backend::create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state)
+{
+    return device_->CreateBlendState(desc, state);
+}
+
+HRESULT D3D11Backend::create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state)
+{
+    return device_->CreateDepthStencilState(desc, state);
+}
+
+HRESULT D3D11Backend::create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader)
+{
+    return device_->CreateVertexShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11Backend::create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader)
+{
+    return device_->CreateGeometryShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11Backend::create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader)
+{
+    return device_->CreatePixelShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11Backend::create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader)
+{
+    return device_->CreateComputeShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11Backend::create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout)
+{
+    return device_->CreateInputLayout(inputs, count, bytecode, size, layout);
+}
+
+void D3D11Backend::clear_state()
+{
+    context_->ClearState();
+}
+
+HRESULT D3D11Backend::map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped)
+{
+    return context_->Map(resource, subresource, map_type, flags, mapped);
+}
+
+void D3D11Backend::unmap(ID3D11Resource* resource, UINT subresource)
+{
+    context_->Unmap(resource, subresource);
+}
+
+void D3D11Backend::update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch)
+{
+    context_->UpdateSubresource(resource, subresource, box, data, row_pitch, depth_pitch);
+}
+
+void D3D11Backend::update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags)
+{
+    if (context1_ != nullptr) {
+        context1_->UpdateSubresource1(resource, subresource, box, data, row_pitch, depth_pitch, copy_flags);
+    } else {
+        context_->UpdateSubresource(resource, subresource, box, data, row_pitch, depth_pitch);
+    }
+}
+
+void D3D11Backend::copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                           ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box)
+{
+    context_->CopySubresourceRegion(destination, destination_subresource, x, y, z, source, source_subresource, source_box);
+}
+
+void D3D11Backend::ia_set_input_layout(ID3D11InputLayout* layout)
+{
+    context_->IASetInputLayout(layout);
+}
+
+void D3D11Backend::ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+{
+    context_->IASetVertexBuffers(slot, count, buffers, strides, offsets);
+}
+
+void D3D11Backend::ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    context_->IASetIndexBuffer(buffer, format, offset);
+}
+
+void D3D11Backend::ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    context_->IASetPrimitiveTopology(topology);
+}
+
+void D3D11Backend::vs_set_shader(ID3D11VertexShader* shader)
+{
+    context_->VSSetShader(shader, nullptr, 0);
+}
+
+void D3D11Backend::gs_set_shader(ID3D11GeometryShader* shader)
+{
+    context_->GSSetShader(shader, nullptr, 0);
+}
+
+void D3D11Backend::ps_set_shader(ID3D11PixelShader* shader)
+{
+    context_->PSSetShader(shader, nullptr, 0);
+}
+
+void D3D11Backend::cs_set_shader(ID3D11ComputeShader* shader)
+{
+    context_->CSSetShader(shader, nullptr, 0);
+}
+
+void D3D11Backend::vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    context_->VSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3D11Backend::gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    context_->GSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3D11Backend::ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    context_->PSSetConstantBuffers(slot, count, buffers);
+}
+
+bool D3D11Backend::supports_constant_buffer_offsets() const
+{
+    return constant_buffer_offsets_;
+}
+
+void D3D11Backend::vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    context1_->VSSetConstantBuffers1(slot, count, buffers, first_constant, constant_count);
+}
+
+void D3D11Backend::gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    context1_->GSSetConstantBuffers1(slot, count, buffers, first_constant, constant_count);
+}
+
+void D3D11Backend::ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    context1_->PSSetConstantBuffers1(slot, count, buffers, first_constant, constant_count);
+}
+
+void D3D11Backend::vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    context_->VSSetShaderResources(slot, count, views);
+}
+
+void D3D11Backend::gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    context_->GSSetShaderResources(slot, count, views);
+}
+
+void D3D11Backend::ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    context_->PSSetShaderResources(slot, count, views);
+}
+
+void D3D11Backend::ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers)
+{
+    context_->PSSetSamplers(slot, count, samplers);
+}
+
+void D3D11Backend::rs_set_state(ID3D11RasterizerState* state)
+{
+    context_->RSSetState(state);
+}
+
+void D3D11Backend::rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports)
+{
+    context_->RSSetViewports(count, viewports);
+}
+
+void D3D11Backend::om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view)
+{
+    context_->OMSetRenderTargets(count, views, depth_view);
+}
+
+void D3D11Backend::om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask)
+{
+    context_->OMSetBlendState(state, blend_factor, sample_mask);
+}
+
+void D3D11Backend::om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref)
+{
+    context_->OMSetDepthStencilState(state, stencil_ref);
+}
+
+void D3D11Backend::clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4])
+{
+    context_->ClearRenderTargetView(view, color);
+}
+
+void D3D11Backend::clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    context_->ClearDepthStencilView(view, flags, depth, stencil);
+}
+
+void D3D11Backend::draw(UINT vertex_count, UINT start_vertex)
+{
+    context_->Draw(vertex_count, start_vertex);
+}
+
+void D3D11Backend::draw_indexed(UINT index_count, UINT start_index, INT base_vertex)
+{
+    context_->DrawIndexed(index_count, start_index, base_vertex);
+}
+
+void D3D11Backend::draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance)
+{
+    context_->DrawIndexedInstanced(index_count, instance_count, start_index, base_vertex, start_instance);
+}
+
+std::unique_ptr<RenderBackend> D3D11Backend::create_deferred_context()
+{
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferred;
+    if (FAILED(device_->CreateDeferredContext(0, &deferred))) {
+        return nullptr;
+    }
+    return std::make_unique<D3D11Backend>(device_.Get(), deferred.Get(), nullptr);
+}
+
+void D3D11Backend::finish_command_list()
+{
+    assert(context_->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED && command_list_ == nullptr);
+    // deferred context state is reset to default, like state of immediate context after execute
+    D3D11_CHECK(context_->FinishCommandList(FALSE, &command_list_));
+}
+
+void D3D11Backend::execute_command_list(RenderBackend* deferred)
+{
+    auto list = static_cast<D3D11Backend*>(deferred);
+    assert(list->command_list_ != nullptr);
+    context_->ExecuteCommandList(list->command_list_.Get(), FALSE);
+    list->command_list_.Reset();
+}
+
+void D3D11Backend::begin_event(const wchar_t* name)
+{
+    if (user_defined_annotation_ != nullptr) {
+        user_defined_annotation_->BeginEvent(name);
+    }
+}
+
+void D3D11Backend::end_event()
+{
+    if (user_defined_annotation_ != nullptr) {
+        user_defined_annotation_->EndEvent();
+    }
+}
+
+void D3D11Backend::present(UINT sync_interval, UINT flags)
+{
+    assert(swapchain_ != nullptr);
+    D3D11_CHECK(swapchain_->Present(sync_interval, flags));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d11_1.h>
+
+#include "render_backend.h"
+
+// Forwards every call to D3D11 context and device.
+// Context is immediate one, or deferred for backends made by create_deferred_context.
+class D3D11Backend final : public RenderBackend
+{
+public:
+    D3D11Backend(ID3D11Device* device, ID3D11DeviceContext* context, IDXGISwapChain* swapchain);
+    ~D3D11Backend();
+
+    Type type() const override;
+
+    ID3D11Device* device() const override;
+    ID3D11DeviceContext* context() const override;
+
+    HRESULT create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) override;
+    HRESULT create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) override;
+    HRESULT create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view) override;
+    HRESULT create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view) override;
+    HRESULT create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view) override;
+
+    HRESULT create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) override;
+    HRESULT create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) override;
+    HRESULT create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) override;
+    HRESULT create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) override;
+
+    HRESULT create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader) override;
+    HRESULT create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader) override;
+    HRESULT create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader) override;
+    HRESULT create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader) override;
+    HRESULT create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout) override;
+
+    void clear_state() override;
+
+    HRESULT map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) override;
+    void unmap(ID3D11Resource* resource, UINT subresource) override;
+    void update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch) override;
+    void update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags) override;
+    void copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                 ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box) override;
+
+    void ia_set_input_layout(ID3D11InputLayout* layout) override;
+    void ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+    void ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+    void ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+
+    void vs_set_shader(ID3D11VertexShader* shader) override;
+    void gs_set_shader(ID3D11GeometryShader* shader) override;
+    void ps_set_shader(ID3D11PixelShader* shader) override;
+    void cs_set_shader(ID3D11ComputeShader* shader) override;
+
+    void vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+
+    bool supports_constant_buffer_offsets() const override;
+    void vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+
+    void vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+
+    void ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers) override;
+
+    void rs_set_state(ID3D11RasterizerState* state) override;
+    void rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports) override;
+
+    void om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view) override;
+    void om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask) override;
+    void om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref) override;
+
+    void clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4]) override;
+    void clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) override;
+
+    void draw(UINT vertex_count, UINT start_vertex) override;
+    void draw_indexed(UINT index_count, UINT start_index, INT base_vertex) override;
+    void draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance) override;
+
+    std::unique_ptr<RenderBackend> create_deferred_context() override;
+    void finish_command_list() override;
+    void execute_command_list(RenderBackend* deferred) override;
+
+    void begin_event(const wchar_t* name) override;
+    void end_event() override;
+
+    void present(UINT sync_interval, UINT flags) override;
+
+private:
+    Microsoft::WRL::ComPtr<ID3D11Device> device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context_;
+    Microsoft::WRL::ComPtr<IDXGISwapChain> swapchain_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1_; // nullptr without D3D11.1 runtime
+    bool constant_buffer_offsets_{ false };
+    Microsoft::WRL::ComPtr<ID3D11CommandList> command_list_; // deferred context: finished, not executed yet
+
+    ID3DUserDefinedAnnotation* user_defined_annotation_{ nullptr };
+};
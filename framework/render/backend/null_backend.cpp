@@ -0,0 +1,637 @@
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#include "null_backend.h"
+
+namespace
+{
+// Minimal COM objects returned by NullBackend.
+// They hold descriptions (so GetDesc works) and buffers keep their memory for Map.
+template<typename Interface>
+class NullObject : public Interface
+{
+public:
+    explicit NullObject(uint64_t id) : id_{ id } {}
+    virtual ~NullObject() = default;
+
+    uint64_t id() const { return id_; }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+    {
+        if (object == nullptr) {
+            return E_POINTER;
+        }
+        if (riid == uuid_of<IUnknown>() || riid == uuid_of<ID3D11DeviceChild>() || riid == uuid_of<Interface>() ||
+            (std::is_base_of<ID3D11Resource, Interface>::value && riid == uuid_of<ID3D11Resource>()) ||
+            (std::is_base_of<ID3D11View, Interface>::value && riid == uuid_of<ID3D11View>())) {
+            *object = static_cast<Interface*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++ref_count_;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = --ref_count_;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    void STDMETHODCALLTYPE GetDevice(ID3D11Device** device) override
+    {
+        *device = nullptr;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT* size, void*) override
+    {
+        *size = 0;
+        return DXGI_ERROR_NOT_FOUND;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) override
+    {
+        return S_OK;
+    }
+
+private:
+    std::atomic<ULONG> ref_count_{ 1 };
+    uint64_t id_;
+};
+
+template<typename Interface, typename Desc>
+class NullDescObject : public NullObject<Interface>
+{
+public:
+    NullDescObject(uint64_t id, const Desc* desc) : NullObject<Interface>(id)
+    {
+        if (desc != nullptr) {
+            desc_ = *desc;
+        }
+    }
+
+    void STDMETHODCALLTYPE GetDesc(Desc* desc) override
+    {
+        *desc = desc_;
+    }
+
+protected:
+    Desc desc_{};
+};
+
+template<typename Interface, typename Desc, D3D11_RESOURCE_DIMENSION dimension>
+class NullResource : public NullDescObject<Interface, Desc>
+{
+public:
+    NullResource(uint64_t id, const Desc* desc) : NullDescObject<Interface, Desc>(id, desc) {}
+
+    void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* type) override
+    {
+        *type = dimension;
+    }
+
+    void STDMETHODCALLTYPE SetEvictionPriority(UINT priority) override
+    {
+        eviction_priority_ = priority;
+    }
+
+    UINT STDMETHODCALLTYPE GetEvictionPriority() override
+    {
+        return eviction_priority_;
+    }
+
+    std::vector<uint8_t>& storage()
+    {
+        return storage_;
+    }
+
+protected:
+    UINT eviction_priority_{ 0 };
+    std::vector<uint8_t> storage_; // cpu copy of contents, only for buffers
+};
+
+class NullBuffer final : public NullResource<ID3D11Buffer, D3D11_BUFFER_DESC, D3D11_RESOURCE_DIMENSION_BUFFER>
+{
+public:
+    NullBuffer(uint64_t id, const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data) : NullResource(id, desc)
+    {
+        storage_.resize(desc_.ByteWidth);
+        if (data != nullptr && data->pSysMem != nullptr) {
+            memcpy(storage_.data(), data->pSysMem, desc_.ByteWidth);
+        }
+    }
+};
+
+using NullTexture2D = NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE2D>;
+
+template<typename Interface, typename Desc>
+class NullView final : public NullDescObject<Interface, Desc>
+{
+public:
+    NullView(uint64_t id, ID3D11Resource* resource, const Desc* desc) : NullDescObject<Interface, Desc>(id, desc), resource_{ resource }
+    {
+        resource_->AddRef();
+    }
+
+    ~NullView()
+    {
+        resource_->Release();
+    }
+
+    void STDMETHODCALLTYPE GetResource(ID3D11Resource** resource) override
+    {
+        resource_->AddRef();
+        *resource = resource_;
+    }
+
+private:
+    ID3D11Resource* resource_;
+};
+
+template<typename T>
+uint64_t id_of(T* object)
+{
+    return object != nullptr ? static_cast<NullObject<T>*>(object)->id() : 0;
+}
+
+uint64_t id_of(ID3D11Resource* resource)
+{
+    if (resource == nullptr) {
+        return 0;
+    }
+    D3D11_RESOURCE_DIMENSION type;
+    resource->GetType(&type);
+    if (type == D3D11_RESOURCE_DIMENSION_BUFFER) {
+        return static_cast<NullBuffer*>(resource)->id();
+    }
+    return static_cast<NullTexture2D*>(resource)->id();
+}
+
+template<typename Object, typename Interface, typename... Args>
+HRESULT create_object(uint64_t id, Interface** result, Args... args)
+{
+    if (result == nullptr) {
+        return S_FALSE; // parameters validation only
+    }
+    *result = new Object(id, args...);
+    return S_OK;
+}
+}
+
+NullBackend::NullBackend() = default;
+
+NullBackend::NullBackend(NullBackend* immediate) : immediate_{ immediate }
+{
+}
+
+NullBackend::~NullBackend() = default;
+
+const char* NullBackend::call_name(Call call)
+{
+    static const char* names[] = {
+#define NULL_BACKEND_CALL_NAME(call) #call,
+        RENDER_BACKEND_CALLS(NULL_BACKEND_CALL_NAME)
+#undef NULL_BACKEND_CALL_NAME
+    };
+    return call < Call::count ? names[size_t(call)] : "unknown";
+}
+
+void NullBackend::set_recording(bool recording)
+{
+    recording_.store(recording);
+}
+
+void NullBackend::reset()
+{
+    for (auto& counter : counters_) {
+        counter.store(0);
+    }
+    mapped_bytes_.store(0);
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+    commands_.clear();
+}
+
+uint64_t NullBackend::counter(Call call) const
+{
+    return counters_[size_t(call)].load();
+}
+
+std::vector<NullBackend::Command> NullBackend::commands() const
+{
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+    return commands_;
+}
+
+uint64_t NullBackend::mapped_bytes() const
+{
+    return mapped_bytes_.load();
+}
+
+void NullBackend::record(Call call, uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3)
+{
+    counters_[size_t(call)].fetch_add(1, std::memory_order_relaxed);
+    const NullBackend* owner = immediate_ != nullptr ? immediate_ : this;
+    if (owner->recording_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        commands_.push_back(Command{ call, { arg0, arg1, arg2, arg3 } });
+    }
+}
+
+void NullBackend::update_storage(ID3D11Resource* resource, const D3D11_BOX* box, const void* data)
+{
+    D3D11_RESOURCE_DIMENSION type;
+    resource->GetType(&type);
+    if (type != D3D11_RESOURCE_DIMENSION_BUFFER) {
+        return;
+    }
+    auto& storage = static_cast<NullBuffer*>(resource)->storage();
+    UINT left = box != nullptr ? box->left : 0;
+    UINT right = box != nullptr ? box->right : UINT(storage.size());
+    memcpy(storage.data() + left, data, right - left);
+    mapped_bytes_.fetch_add(right - left, std::memory_order_relaxed);
+}
+
+uint64_t NullBackend::next_object_id()
+{
+    if (immediate_ != nullptr) {
+        return immediate_->next_object_id();
+    }
+    return ++object_id_;
+}
+
+RenderBackend::Type NullBackend::type() const
+{
+    return Type::null;
+}
+
+ID3D11Device* NullBackend::device() const
+{
+    return nullptr;
+}
+
+ID3D11DeviceContext* NullBackend::context() const
+{
+    return nullptr;
+}
+
+HRESULT NullBackend::create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_buffer, id, desc->ByteWidth, desc->BindFlags);
+    return create_object<NullBuffer>(id, buffer, desc, data);
+}
+
+HRESULT NullBackend::create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture2D** texture)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_texture_2d, id, desc->Width, desc->Height, desc->Format);
+    return create_object<NullTexture2D>(id, texture, desc);
+}
+
+HRESULT NullBackend::create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_shader_resource_view, id, id_of(resource));
+    return create_object<NullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC>>(id, view, resource, desc);
+}
+
+HRESULT NullBackend::create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_render_target_view, id, id_of(resource));
+    return create_object<NullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC>>(id, view, resource, desc);
+}
+
+HRESULT NullBackend::create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_depth_stencil_view, id, id_of(resource));
+    return create_object<NullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC>>(id, view, resource, desc);
+}
+
+HRESULT NullBackend::create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_sampler_state, id);
+    return create_object<NullDescObject<ID3D11SamplerState, D3D11_SAMPLER_DESC>>(id, state, desc);
+}
+
+HRESULT NullBackend::create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_rasterizer_state, id);
+    return create_object<NullDescObject<ID3D11RasterizerState, D3D11_RASTERIZER_DESC>>(id, state, desc);
+}
+
+HRESULT NullBackend::create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_blend_state, id);
+    return create_object<NullDescObject<ID3D11BlendState, D3D11_BLEND_DESC>>(id, state, desc);
+}
+
+HRESULT NullBackend::create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_depth_stencil_state, id);
+    return create_object<NullDescObject<ID3D11DepthStencilState, D3D11_DEPTH_STENCIL_DESC>>(id, state, desc);
+}
+
+HRESULT NullBackend::create_vertex_shader(const void*, SIZE_T size, ID3D11VertexShader** shader)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_vertex_shader, id, size);
+    return create_object<NullObject<ID3D11VertexShader>>(id, shader);
+}
+
+HRESULT NullBackend::create_geometry_shader(const void*, SIZE_T size, ID3D11GeometryShader** shader)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_geometry_shader, id, size);
+    return create_object<NullObject<ID3D11GeometryShader>>(id, shader);
+}
+
+HRESULT NullBackend::create_pixel_shader(const void*, SIZE_T size, ID3D11PixelShader** shader)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_pixel_shader, id, size);
+    return create_object<NullObject<ID3D11PixelShader>>(id, shader);
+}
+
+HRESULT NullBackend::create_compute_shader(const void*, SIZE_T size, ID3D11ComputeShader** shader)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_compute_shader, id, size);
+    return create_object<NullObject<ID3D11ComputeShader>>(id, shader);
+}
+
+HRESULT NullBackend::create_input_layout(const D3D11_INPUT_ELEMENT_DESC*, UINT count, const void*, SIZE_T, ID3D11InputLayout** layout)
+{
+    uint64_t id = next_object_id();
+    record(Call::create_input_layout, id, count);
+    return create_object<NullObject<ID3D11InputLayout>>(id, layout);
+}
+
+void NullBackend::clear_state()
+{
+    record(Call::clear_state);
+}
+
+HRESULT NullBackend::map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT, D3D11_MAPPED_SUBRESOURCE* mapped)
+{
+    record(Call::map, id_of(resource), subresource, map_type);
+
+    D3D11_RESOURCE_DIMENSION type;
+    resource->GetType(&type);
+    if (type != D3D11_RESOURCE_DIMENSION_BUFFER) {
+        return E_INVALIDARG; // only buffers have cpu storage
+    }
+    auto& storage = static_cast<NullBuffer*>(resource)->storage();
+    if (map_type != D3D11_MAP_READ) {
+        mapped_bytes_.fetch_add(storage.size(), std::memory_order_relaxed);
+    }
+    mapped->pData = storage.data();
+    mapped->RowPitch = UINT(storage.size());
+    mapped->DepthPitch = UINT(storage.size());
+    return S_OK;
+}
+
+void NullBackend::unmap(ID3D11Resource* resource, UINT subresource)
+{
+    record(Call::unmap, id_of(resource), subresource);
+}
+
+void NullBackend::update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT, UINT)
+{
+    record(Call::update_subresource, id_of(resource), subresource, box != nullptr ? box->left : 0, box != nullptr ? box->right : 0);
+    update_storage(resource, box, data);
+}
+
+void NullBackend::update_subresource1(ID3D11Resource* resource, UINT, const D3D11_BOX* box, const void* data, UINT, UINT, UINT copy_flags)
+{
+    record(Call::update_subresource1, id_of(resource), box != nullptr ? box->left : 0, box != nullptr ? box->right : 0, copy_flags);
+    update_storage(resource, box, data);
+}
+
+void NullBackend::copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT, UINT,
+                                          ID3D11Resource* source, UINT, const D3D11_BOX* source_box)
+{
+    record(Call::copy_subresource_region, id_of(destination), destination_subresource, id_of(source), x);
+
+    D3D11_RESOURCE_DIMENSION destination_type;
+    D3D11_RESOURCE_DIMENSION source_type;
+    destination->GetType(&destination_type);
+    source->GetType(&source_type);
+    if (destination_type != D3D11_RESOURCE_DIMENSION_BUFFER || source_type != D3D11_RESOURCE_DIMENSION_BUFFER) {
+        return;
+    }
+    auto& destination_storage = static_cast<NullBuffer*>(destination)->storage();
+    auto& source_storage = static_cast<NullBuffer*>(source)->storage();
+    UINT left = source_box != nullptr ? source_box->left : 0;
+    UINT right = source_box != nullptr ? source_box->right : UINT(source_storage.size());
+    memmove(destination_storage.data() + x, source_storage.data() + left, right - left);
+}
+
+void NullBackend::ia_set_input_layout(ID3D11InputLayout* layout)
+{
+    record(Call::ia_set_input_layout, id_of(layout));
+}
+
+void NullBackend::ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT*)
+{
+    record(Call::ia_set_vertex_buffers, slot, count, count > 0 ? id_of(buffers[0]) : 0, count > 0 ? strides[0] : 0);
+}
+
+void NullBackend::ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    record(Call::ia_set_index_buffer, id_of(buffer), format, offset);
+}
+
+void NullBackend::ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    record(Call::ia_set_primitive_topology, topology);
+}
+
+void NullBackend::vs_set_shader(ID3D11VertexShader* shader)
+{
+    record(Call::vs_set_shader, id_of(shader));
+}
+
+void NullBackend::gs_set_shader(ID3D11GeometryShader* shader)
+{
+    record(Call::gs_set_shader, id_of(shader));
+}
+
+void NullBackend::ps_set_shader(ID3D11PixelShader* shader)
+{
+    record(Call::ps_set_shader, id_of(shader));
+}
+
+void NullBackend::cs_set_shader(ID3D11ComputeShader* shader)
+{
+    record(Call::cs_set_shader, id_of(shader));
+}
+
+void NullBackend::vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    record(Call::vs_set_constant_buffers, slot, count, count > 0 ? id_of(buffers[0]) : 0);
+}
+
+void NullBackend::gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    record(Call::gs_set_constant_buffers, slot, count, count > 0 ? id_of(buffers[0]) : 0);
+}
+
+void NullBackend::ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    record(Call::ps_set_constant_buffers, slot, count, count > 0 ? id_of(buffers[0]) : 0);
+}
+
+bool NullBackend::supports_constant_buffer_offsets() const
+{
+    return true;
+}
+
+void NullBackend::vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT*)
+{
+    record(Call::vs_set_constant_buffers1, slot, count, count > 0 ? id_of(buffers[0]) : 0, count > 0 ? first_constant[0] : 0);
+}
+
+void NullBackend::gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT*)
+{
+    record(Call::gs_set_constant_buffers1, slot, count, count > 0 ? id_of(buffers[0]) : 0, count > 0 ? first_constant[0] : 0);
+}
+
+void NullBackend::ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT*)
+{
+    record(Call::ps_set_constant_buffers1, slot, count, count > 0 ? id_of(buffers[0]) : 0, count > 0 ? first_constant[0] : 0);
+}
+
+void NullBackend::vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    record(Call::vs_set_shader_resources, slot, count, count > 0 ? id_of(views[0]) : 0);
+}
+
+void NullBackend::gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    record(Call::gs_set_shader_resources, slot, count, count > 0 ? id_of(views[0]) : 0);
+}
+
+void NullBackend::ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    record(Call::ps_set_shader_resources, slot, count, count > 0 ? id_of(views[0]) : 0);
+}
+
+void NullBackend::ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers)
+{
+    record(Call::ps_set_samplers, slot, count, count > 0 ? id_of(samplers[0]) : 0);
+}
+
+void NullBackend::rs_set_state(ID3D11RasterizerState* state)
+{
+    record(Call::rs_set_state, id_of(state));
+}
+
+void NullBackend::rs_set_viewports(UINT count, const D3D11_VIEWPORT*)
+{
+    record(Call::rs_set_viewports, count);
+}
+
+void NullBackend::om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view)
+{
+    record(Call::om_set_render_targets, count, count > 0 ? id_of(views[0]) : 0, id_of(depth_view));
+}
+
+void NullBackend::om_set_blend_state(ID3D11BlendState* state, const FLOAT[4], UINT sample_mask)
+{
+    record(Call::om_set_blend_state, id_of(state), sample_mask);
+}
+
+void NullBackend::om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref)
+{
+    record(Call::om_set_depth_stencil_state, id_of(state), stencil_ref);
+}
+
+void NullBackend::clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT[4])
+{
+    record(Call::clear_render_target_view, id_of(view));
+}
+
+void NullBackend::clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT, UINT8)
+{
+    record(Call::clear_depth_stencil_view, id_of(view), flags);
+}
+
+void NullBackend::draw(UINT vertex_count, UINT start_vertex)
+{
+    record(Call::draw, vertex_count, start_vertex);
+}
+
+void NullBackend::draw_indexed(UINT index_count, UINT start_index, INT base_vertex)
+{
+    record(Call::draw_indexed, index_count, start_index, uint64_t(int64_t(base_vertex)));
+}
+
+void NullBackend::draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT)
+{
+    record(Call::draw_indexed_instanced, index_count, instance_count, start_index, uint64_t(int64_t(base_vertex)));
+}
+
+std::unique_ptr<RenderBackend> NullBackend::create_deferred_context()
+{
+    record(Call::create_deferred_context);
+    return std::unique_ptr<RenderBackend>(new NullBackend(this));
+}
+
+void NullBackend::finish_command_list()
+{
+    assert(immediate_ != nullptr);
+    record(Call::finish_command_list);
+}
+
+void NullBackend::execute_command_list(RenderBackend* deferred)
+{
+    assert(immediate_ == nullptr);
+    auto list = static_cast<NullBackend*>(deferred);
+    record(Call::execute_command_list);
+
+    // calls of the list count as calls of this context from now on
+    for (size_t i = 0; i < size_t(Call::count); ++i) {
+        counters_[i].fetch_add(list->counters_[i].exchange(0), std::memory_order_relaxed);
+    }
+    mapped_bytes_.fetch_add(list->mapped_bytes_.exchange(0), std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> list_lock(list->commands_mutex_);
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+    commands_.insert(commands_.end(), list->commands_.begin(), list->commands_.end());
+    list->commands_.clear();
+}
+
+void NullBackend::begin_event(const wchar_t*)
+{
+    record(Call::begin_event);
+}
+
+void NullBackend::end_event()
+{
+    record(Call::end_event);
+}
+
+void NullBackend::present(UINT sync_interval, UINT flags)
+{
+    record(Call::present, sync_interval, flags);
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "render_backend.h"
+
+#define RENDER_BACKEND_CALLS(FUNC)      \
+    FUNC(create_buffer)                 \
+    FUNC(create_texture_2d)             \
+    FUNC(create_shader_resource_view)   \
+    FUNC(create_render_target_view)     \
+    FUNC(create_depth_stencil_view)     \
+    FUNC(create_sampler_state)          \
+    FUNC(create_rasterizer_state)       \
+    FUNC(create_blend_state)            \
+    FUNC(create_depth_stencil_state)    \
+    FUNC(create_vertex_shader)          \
+    FUNC(create_geometry_shader)        \
+    FUNC(create_pixel_shader)           \
+    FUNC(create_compute_shader)         \
+    FUNC(create_input_layout)           \
+    FUNC(clear_state)                   \
+    FUNC(map)                           \
+    FUNC(unmap)                         \
+    FUNC(update_subresource)            \
+    FUNC(update_subresource1)           \
+    FUNC(copy_subresource_region)       \
+    FUNC(ia_set_input_layout)           \
+    FUNC(ia_set_vertex_buffers)         \
+    FUNC(ia_set_index_buffer)           \
+    FUNC(ia_set_primitive_topology)     \
+    FUNC(vs_set_shader)                 \
+    FUNC(gs_set_shader)                 \
+    FUNC(ps_set_shader)                 \
+    FUNC(cs_set_shader)                 \
+    FUNC(vs_set_constant_buffers)       \
+    FUNC(gs_set_constant_buffers)       \
+    FUNC(ps_set_constant_buffers)       \
+    FUNC(vs_set_constant_buffers1)      \
+    FUNC(gs_set_constant_buffers1)      \
+    FUNC(ps_set_constant_buffers1)      \
+    FUNC(vs_set_shader_resources)       \
+    FUNC(gs_set_shader_resources)       \
+    FUNC(ps_set_shader_resources)       \
+    FUNC(ps_set_samplers)               \
+    FUNC(rs_set_state)                  \
+    FUNC(rs_set_viewports)              \
+    FUNC(om_set_render_targets)         \
+    FUNC(om_set_blend_state)            \
+    FUNC(om_set_depth_stencil_state)    \
+    FUNC(clear_render_target_view)      \
+    FUNC(clear_depth_stencil_view)      \
+    FUNC(draw)                          \
+    FUNC(draw_indexed)                  \
+    FUNC(draw_indexed_instanced)        \
+    FUNC(create_deferred_context)       \
+    FUNC(finish_command_list)           \
+    FUNC(execute_command_list)          \
+    FUNC(begin_event)                   \
+    FUNC(end_event)                     \
+    FUNC(present)
+
+// Backend without GPU: creates dummy objects, counts every call and
+// (optionally) keeps a log of them. Used to profile CPU side of the frame headless.
+// Deferred contexts keep own counters and log, execute_command_list appends them
+// to the immediate context, so totals do not depend on recording threads.
+class NullBackend final : public RenderBackend
+{
+public:
+    enum class Call : uint32_t
+    {
+#define NULL_BACKEND_CALL_ENUM(call) call,
+        RENDER_BACKEND_CALLS(NULL_BACKEND_CALL_ENUM)
+#undef NULL_BACKEND_CALL_ENUM
+        count
+    };
+
+    // one recorded call, arguments are call specific:
+    // object ids of created/bound objects (0 - nullptr), slots, counts
+    struct Command
+    {
+        Call call;
+        uint64_t args[4];
+    };
+
+    NullBackend();
+    ~NullBackend();
+
+    static const char* call_name(Call call);
+
+    // command log is disabled by default, counters are always on
+    void set_recording(bool recording);
+    void reset();
+
+    uint64_t counter(Call call) const;
+    std::vector<Command> commands() const;
+
+    // total bytes written through mapped resources
+    uint64_t mapped_bytes() const;
+
+    Type type() const override;
+
+    ID3D11Device* device() const override;
+    ID3D11DeviceContext* context() const override;
+
+    HRESULT create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) override;
+    HRESULT create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) override;
+    HRESULT create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view) override;
+    HRESULT create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view) override;
+    HRESULT create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view) override;
+
+    HRESULT create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) override;
+    HRESULT create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) override;
+    HRESULT create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) override;
+    HRESULT create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) override;
+
+    HRESULT create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader) override;
+    HRESULT create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader) override;
+    HRESULT create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader) override;
+    HRESULT create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader) override;
+    HRESULT create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout) override;
+
+    void clear_state() override;
+
+    HRESULT map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) override;
+    void unmap(ID3D11Resource* resource, UINT subresource) override;
+    void update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch) override;
+    void update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags) override;
+    void copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                 ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box) override;
+
+    void ia_set_input_layout(ID3D11InputLayout* layout) override;
+    void ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+    void ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+    void ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+
+    void vs_set_shader(ID3D11VertexShader* shader) override;
+    void gs_set_shader(ID3D11GeometryShader* shader) override;
+    void ps_set_shader(ID3D11PixelShader* shader) override;
+    void cs_set_shader(ID3D11ComputeShader* shader) override;
+
+    void vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+
+    bool supports_constant_buffer_offsets() const override;
+    void vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+
+    void vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+
+    void ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers) override;
+
+    void rs_set_state(ID3D11RasterizerState* state) override;
+    void rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports) override;
+
+    void om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view) override;
+    void om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask) override;
+    void om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref) override;
+
+    void clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4]) override;
+    void clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) override;
+
+    void draw(UINT vertex_count, UINT start_vertex) override;
+    void draw_indexed(UINT index_count, UINT start_index, INT base_vertex) override;
+    void draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance) override;
+
+    std::unique_ptr<RenderBackend> create_deferred_context() override;
+    void finish_command_list() override;
+    void execute_command_list(RenderBackend* deferred) override;
+
+    void begin_event(const wchar_t* name) override;
+    void end_event() override;
+
+    void present(UINT sync_interval, UINT flags) override;
+
+private:
+    explicit NullBackend(NullBackend* immediate); // deferred context
+
+    void record(Call call, uint64_t arg0 = 0, uint64_t arg1 = 0, uint64_t arg2 = 0, uint64_t arg3 = 0);
+    uint64_t next_object_id();
+    // buffers: copy into cpu storage
+    void update_storage(ID3D11Resource* resource, const D3D11_BOX* box, const void* data);
+
+    std::atomic<uint64_t> counters_[size_t(Call::count)]{};
+    std::atomic<uint64_t> mapped_bytes_{ 0 };
+    std::atomic<uint64_t> object_id_{ 0 };
+
+    std::atomic<bool> recording_{ false };
+    mutable std::mutex commands_mutex_;
+    std::vector<Command> commands_;
+
+    NullBackend* immediate_{ nullptr }; // deferred context: owner of object ids and log switch
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "d3d11_types.h"
+
+// All device and context calls of the framework go through this interface.
+// D3D11Backend forwards them to the real device, NullBackend only records them.
+// Parameters follow ID3D11Device / ID3D11DeviceContext methods with the same name.
+class RenderBackend
+{
+public:
+    enum class Type : uint32_t
+    {
+        d3d11,
+        null,
+    };
+
+    virtual ~RenderBackend() = default;
+
+    virtual Type type() const = 0;
+
+    // native objects, nullptr for backends without D3D11 device
+    virtual ID3D11Device* device() const = 0;
+    virtual ID3D11DeviceContext* context() const = 0;
+
+    // device
+    virtual HRESULT create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) = 0;
+    virtual HRESULT create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) = 0;
+    virtual HRESULT create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view) = 0;
+    virtual HRESULT create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view) = 0;
+    virtual HRESULT create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view) = 0;
+
+    virtual HRESULT create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) = 0;
+    virtual HRESULT create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) = 0;
+    virtual HRESULT create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) = 0;
+    virtual HRESULT create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) = 0;
+
+    virtual HRESULT create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader) = 0;
+    virtual HRESULT create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader) = 0;
+    virtual HRESULT create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader) = 0;
+    virtual HRESULT create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader) = 0;
+    virtual HRESULT create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout) = 0;
+
+    // context
+    virtual void clear_state() = 0;
+
+    virtual HRESULT map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) = 0;
+    virtual void unmap(ID3D11Resource* resource, UINT subresource) = 0;
+    virtual void update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch) = 0;
+    // D3D11.1 copy flags (D3D11_COPY_DISCARD, D3D11_COPY_NO_OVERWRITE), boxes on constant buffers; plain update without D3D11.1 runtime
+    virtual void update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags) = 0;
+    virtual void copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                         ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box) = 0;
+
+    virtual void ia_set_input_layout(ID3D11InputLayout* layout) = 0;
+    virtual void ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) = 0;
+    virtual void ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) = 0;
+    virtual void ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+
+    virtual void vs_set_shader(ID3D11VertexShader* shader) = 0;
+    virtual void gs_set_shader(ID3D11GeometryShader* shader) = 0;
+    virtual void ps_set_shader(ID3D11PixelShader* shader) = 0;
+    virtual void cs_set_shader(ID3D11ComputeShader* shader) = 0;
+
+    virtual void vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) = 0;
+    virtual void gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) = 0;
+    virtual void ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) = 0;
+
+    // D3D11.1 binding of buffer ranges, first_constant / constant_count in 16 byte constants (multiples of 16)
+    virtual bool supports_constant_buffer_offsets() const = 0;
+    virtual void vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) = 0;
+    virtual void gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) = 0;
+    virtual void ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) = 0;
+
+    virtual void vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+    virtual void gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+    virtual void ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+
+    virtual void ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+
+    virtual void rs_set_state(ID3D11RasterizerState* state) = 0;
+    virtual void rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports) = 0;
+
+    virtual void om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view) = 0;
+    virtual void om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask) = 0;
+    virtual void om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref) = 0;
+
+    virtual void clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4]) = 0;
+    virtual void clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) = 0;
+
+    virtual void draw(UINT vertex_count, UINT start_vertex) = 0;
+    virtual void draw_indexed(UINT index_count, UINT start_index, INT base_vertex) = 0;
+    virtual void draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance) = 0;
+
+    // command lists: deferred context records context calls on any thread,
+    // device calls of deferred context go to the same device
+    virtual std::unique_ptr<RenderBackend> create_deferred_context() = 0;
+    // deferred context: ends recording, recorded calls wait for execute_command_list
+    virtual void finish_command_list() = 0;
+    // immediate context: runs calls finished by deferred context, context state is default afterwards
+    virtual void execute_command_list(RenderBackend* deferred) = 0;
+
+    // debug annotations
+    virtual void begin_event(const wchar_t* name) = 0;
+    virtual void end_event() = 0;
+
+    virtual void present(UINT sync_interval, UINT flags) = 0;
+};
@@ -0,0 +1,620 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+#include "state_cache.h"
+
+StateCache::StateCache(std::unique_ptr<RenderBackend> backend) : backend_{ std::move(backend) }
+{
+    // state of context is not known until first clear_state
+    invalidate();
+}
+
+StateCache::~StateCache()
+{
+}
+
+const char* StateCache::state_name(State state)
+{
+    switch (state)
+    {
+#define STATE_CACHE_STATE_NAME(state) case State::state: return #state;
+        STATE_CACHE_STATES(STATE_CACHE_STATE_NAME)
+#undef STATE_CACHE_STATE_NAME
+    default:
+        return "unknown";
+    }
+}
+
+RenderBackend* StateCache::backend() const
+{
+    return backend_.get();
+}
+
+void StateCache::set_enabled(bool enabled)
+{
+    if (enabled && !enabled_) {
+        invalidate();
+    }
+    enabled_ = enabled;
+}
+
+bool StateCache::enabled() const
+{
+    return enabled_;
+}
+
+void StateCache::invalidate()
+{
+    state_ = ShadowState{};
+}
+
+void StateCache::end_frame()
+{
+    for (size_t i = 0; i < size_t(State::count); ++i)
+    {
+        total_counters_.issued[i] += frame_counters_.issued[i];
+        total_counters_.elided[i] += frame_counters_.elided[i];
+    }
+    last_frame_counters_ = frame_counters_;
+    frame_counters_ = Counters{};
+}
+
+const StateCache::Counters& StateCache::frame_counters() const
+{
+    return last_frame_counters_;
+}
+
+const StateCache::Counters& StateCache::total_counters() const
+{
+    return total_counters_;
+}
+
+void StateCache::reset_counters()
+{
+    frame_counters_ = Counters{};
+    last_frame_counters_ = Counters{};
+    total_counters_ = Counters{};
+}
+
+RenderBackend::Type StateCache::type() const
+{
+    return backend_->type();
+}
+
+ID3D11Device* StateCache::device() const
+{
+    return backend_->device();
+}
+
+ID3D11DeviceContext* StateCache::context() const
+{
+    return backend_->context();
+}
+
+// device
+HRESULT StateCache::create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer)
+{
+    return backend_->create_buffer(desc, data, buffer);
+}
+
+HRESULT StateCache::create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture)
+{
+    return backend_->create_texture_2d(desc, data, texture);
+}
+
+HRESULT StateCache::create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view)
+{
+    return backend_->create_shader_resource_view(resource, desc, view);
+}
+
+HRESULT StateCache::create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view)
+{
+    return backend_->create_render_target_view(resource, desc, view);
+}
+
+HRESULT StateCache::create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view)
+{
+    return backend_->create_depth_stencil_view(resource, desc, view);
+}
+
+HRESULT StateCache::create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state)
+{
+    return backend_->create_sampler_state(desc, state);
+}
+
+HRESULT StateCache::create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state)
+{
+    return backend_->create_rasterizer_state(desc, state);
+}
+
+HRESULT StateCache::create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state)
+{
+    return backend_->create_blend_state(desc, state);
+}
+
+HRESULT StateCache::create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state)
+{
+    return backend_->create_depth_stencil_state(desc, state);
+}
+
+HRESULT StateCache::create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader)
+{
+    return backend_->create_vertex_shader(bytecode, size, shader);
+}
+
+HRESULT StateCache::create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader)
+{
+    return backend_->create_geometry_shader(bytecode, size, shader);
+}
+
+HRESULT StateCache::create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader)
+{
+    return backend_->create_pixel_shader(bytecode, size, shader);
+}
+
+HRESULT StateCache::create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader)
+{
+    return backend_->create_compute_shader(bytecode, size, shader);
+}
+
+HRESULT StateCache::create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout)
+{
+    return backend_->create_input_layout(inputs, count, bytecode, size, layout);
+}
+
+// context
+void StateCache::clear_state()
+{
+    backend_->clear_state();
+    reset_to_defaults();
+}
+
+HRESULT StateCache::map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped)
+{
+    return backend_->map(resource, subresource, map_type, flags, mapped);
+}
+
+void StateCache::unmap(ID3D11Resource* resource, UINT subresource)
+{
+    backend_->unmap(resource, subresource);
+}
+
+void StateCache::update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch)
+{
+    backend_->update_subresource(resource, subresource, box, data, row_pitch, depth_pitch);
+}
+
+void StateCache::update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags)
+{
+    backend_->update_subresource1(resource, subresource, box, data, row_pitch, depth_pitch, copy_flags);
+}
+
+void StateCache::copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                         ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box)
+{
+    backend_->copy_subresource_region(destination, destination_subresource, x, y, z, source, source_subresource, source_box);
+}
+
+void StateCache::ia_set_input_layout(ID3D11InputLayout* layout)
+{
+    if (check(State::input_layout, state_.input_layout, layout)) {
+        backend_->ia_set_input_layout(layout);
+    }
+}
+
+void StateCache::ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+{
+    assert(slot + count <= D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+    VertexBufferSlot values[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    for (UINT i = 0; i < count; ++i) {
+        values[i] = VertexBufferSlot{ buffers[i], strides[i], offsets[i], true };
+    }
+
+    UINT first = 0;
+    if (narrow(State::vertex_buffers, state_.vertex_buffers, values, slot, count, first)) {
+        backend_->ia_set_vertex_buffers(slot, count, buffers + first, strides + first, offsets + first);
+    }
+}
+
+void StateCache::ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    bool same = enabled_ &&
+        state_.index_buffer == Value<ID3D11Buffer*>{ buffer, true } &&
+        state_.index_format == Value<DXGI_FORMAT>{ format, true } &&
+        state_.index_offset == Value<UINT>{ offset, true };
+    state_.index_buffer = { buffer, true };
+    state_.index_format = { format, true };
+    state_.index_offset = { offset, true };
+    if (check(State::index_buffer, same)) {
+        backend_->ia_set_index_buffer(buffer, format, offset);
+    }
+}
+
+void StateCache::ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    if (check(State::primitive_topology, state_.topology, topology)) {
+        backend_->ia_set_primitive_topology(topology);
+    }
+}
+
+void StateCache::vs_set_shader(ID3D11VertexShader* shader)
+{
+    if (check(State::shaders, state_.vertex_shader, shader)) {
+        backend_->vs_set_shader(shader);
+    }
+}
+
+void StateCache::gs_set_shader(ID3D11GeometryShader* shader)
+{
+    if (check(State::shaders, state_.geometry_shader, shader)) {
+        backend_->gs_set_shader(shader);
+    }
+}
+
+void StateCache::ps_set_shader(ID3D11PixelShader* shader)
+{
+    if (check(State::shaders, state_.pixel_shader, shader)) {
+        backend_->ps_set_shader(shader);
+    }
+}
+
+void StateCache::cs_set_shader(ID3D11ComputeShader* shader)
+{
+    if (check(State::shaders, state_.compute_shader, shader)) {
+        backend_->cs_set_shader(shader);
+    }
+}
+
+void StateCache::vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    UINT first = 0;
+    if (set_constant_buffers(vertex_stage, slot, count, buffers, nullptr, nullptr, first)) {
+        backend_->vs_set_constant_buffers(slot, count, buffers + first);
+    }
+}
+
+void StateCache::gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    UINT first = 0;
+    if (set_constant_buffers(geometry_stage, slot, count, buffers, nullptr, nullptr, first)) {
+        backend_->gs_set_constant_buffers(slot, count, buffers + first);
+    }
+}
+
+void StateCache::ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers)
+{
+    UINT first = 0;
+    if (set_constant_buffers(pixel_stage, slot, count, buffers, nullptr, nullptr, first)) {
+        backend_->ps_set_constant_buffers(slot, count, buffers + first);
+    }
+}
+
+bool StateCache::supports_constant_buffer_offsets() const
+{
+    return backend_->supports_constant_buffer_offsets();
+}
+
+void StateCache::vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    UINT first = 0;
+    if (set_constant_buffers(vertex_stage, slot, count, buffers, first_constant, constant_count, first)) {
+        backend_->vs_set_constant_buffers1(slot, count, buffers + first, first_constant + first, constant_count + first);
+    }
+}
+
+void StateCache::gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    UINT first = 0;
+    if (set_constant_buffers(geometry_stage, slot, count, buffers, first_constant, constant_count, first)) {
+        backend_->gs_set_constant_buffers1(slot, count, buffers + first, first_constant + first, constant_count + first);
+    }
+}
+
+void StateCache::ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count)
+{
+    UINT first = 0;
+    if (set_constant_buffers(pixel_stage, slot, count, buffers, first_constant, constant_count, first)) {
+        backend_->ps_set_constant_buffers1(slot, count, buffers + first, first_constant + first, constant_count + first);
+    }
+}
+
+void StateCache::vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    UINT first = 0;
+    if (set_shader_resources(vertex_stage, slot, count, views, first)) {
+        backend_->vs_set_shader_resources(slot, count, views + first);
+    }
+}
+
+void StateCache::gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    UINT first = 0;
+    if (set_shader_resources(geometry_stage, slot, count, views, first)) {
+        backend_->gs_set_shader_resources(slot, count, views + first);
+    }
+}
+
+void StateCache::ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    UINT first = 0;
+    if (set_shader_resources(pixel_stage, slot, count, views, first)) {
+        backend_->ps_set_shader_resources(slot, count, views + first);
+    }
+}
+
+void StateCache::ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers)
+{
+    assert(slot + count <= D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+    Value<ID3D11SamplerState*> values[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+    for (UINT i = 0; i < count; ++i) {
+        values[i] = { samplers[i], true };
+    }
+
+    UINT first = 0;
+    if (narrow(State::samplers, state_.samplers, values, slot, count, first)) {
+        backend_->ps_set_samplers(slot, count, samplers + first);
+    }
+}
+
+void StateCache::rs_set_state(ID3D11RasterizerState* state)
+{
+    if (check(State::rasterizer_state, state_.rasterizer_state, state)) {
+        backend_->rs_set_state(state);
+    }
+}
+
+void StateCache::rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports)
+{
+    assert(count <= D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
+    bool same = enabled_ && state_.viewports_known && state_.viewport_count == count &&
+        std::memcmp(state_.viewports, viewports, count * sizeof(D3D11_VIEWPORT)) == 0;
+    state_.viewports_known = true;
+    state_.viewport_count = count;
+    std::memcpy(state_.viewports, viewports, count * sizeof(D3D11_VIEWPORT));
+    if (check(State::viewports, same)) {
+        backend_->rs_set_viewports(count, viewports);
+    }
+}
+
+void StateCache::om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view)
+{
+    assert(count <= D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+    // slots above count are unbound by the call
+    ID3D11RenderTargetView* targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT]{};
+    for (UINT i = 0; i < count; ++i) {
+        targets[i] = views[i];
+    }
+    bool same = enabled_ && state_.render_targets_known && state_.render_target_count == count &&
+        state_.depth_view == depth_view && std::memcmp(state_.render_targets, targets, sizeof(targets)) == 0;
+    state_.render_targets_known = true;
+    state_.render_target_count = count;
+    state_.depth_view = depth_view;
+    std::memcpy(state_.render_targets, targets, sizeof(targets));
+    if (check(State::render_targets, same))
+    {
+        backend_->om_set_render_targets(count, views, depth_view);
+        // runtime unbinds shader resources of new outputs behind our back
+        invalidate_shader_resources();
+    }
+}
+
+void StateCache::om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask)
+{
+    // nullptr factor is { 1, 1, 1, 1 }
+    const FLOAT default_factor[4] = { 1.f, 1.f, 1.f, 1.f };
+    const FLOAT* factor = blend_factor != nullptr ? blend_factor : default_factor;
+
+    bool same = enabled_ && state_.blend_state == Value<ID3D11BlendState*>{ state, true } &&
+        std::memcmp(state_.blend_factor, factor, sizeof(state_.blend_factor)) == 0 && state_.sample_mask == sample_mask;
+    state_.blend_state = { state, true };
+    std::memcpy(state_.blend_factor, factor, sizeof(state_.blend_factor));
+    state_.sample_mask = sample_mask;
+    if (check(State::blend_state, same)) {
+        backend_->om_set_blend_state(state, blend_factor, sample_mask);
+    }
+}
+
+void StateCache::om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref)
+{
+    bool same = enabled_ && state_.depth_stencil_state == Value<ID3D11DepthStencilState*>{ state, true } &&
+        state_.stencil_ref == stencil_ref;
+    state_.depth_stencil_state = { state, true };
+    state_.stencil_ref = stencil_ref;
+    if (check(State::depth_stencil_state, same)) {
+        backend_->om_set_depth_stencil_state(state, stencil_ref);
+    }
+}
+
+void StateCache::clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4])
+{
+    backend_->clear_render_target_view(view, color);
+}
+
+void StateCache::clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    backend_->clear_depth_stencil_view(view, flags, depth, stencil);
+}
+
+void StateCache::draw(UINT vertex_count, UINT start_vertex)
+{
+    backend_->draw(vertex_count, start_vertex);
+}
+
+void StateCache::draw_indexed(UINT index_count, UINT start_index, INT base_vertex)
+{
+    backend_->draw_indexed(index_count, start_index, base_vertex);
+}
+
+void StateCache::draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance)
+{
+    backend_->draw_indexed_instanced(index_count, instance_count, start_index, base_vertex, start_instance);
+}
+
+std::unique_ptr<RenderBackend> StateCache::create_deferred_context()
+{
+    auto deferred = backend_->create_deferred_context();
+    if (deferred == nullptr) {
+        return nullptr;
+    }
+    auto cache = std::make_unique<StateCache>(std::move(deferred));
+    cache->enabled_ = enabled_;
+    // deferred context starts with default state
+    cache->reset_to_defaults();
+    return cache;
+}
+
+void StateCache::finish_command_list()
+{
+    backend_->finish_command_list();
+    reset_to_defaults();
+}
+
+void StateCache::execute_command_list(RenderBackend* deferred)
+{
+    auto cache = static_cast<StateCache*>(deferred);
+    backend_->execute_command_list(cache->backend_.get());
+    reset_to_defaults();
+
+    // calls elided in the list count for frame of this context
+    for (size_t i = 0; i < size_t(State::count); ++i)
+    {
+        frame_counters_.issued[i] += cache->frame_counters_.issued[i];
+        frame_counters_.elided[i] += cache->frame_counters_.elided[i];
+    }
+    cache->frame_counters_ = Counters{};
+}
+
+void StateCache::begin_event(const wchar_t* name)
+{
+    backend_->begin_event(name);
+}
+
+void StateCache::end_event()
+{
+    backend_->end_event();
+}
+
+void StateCache::present(UINT sync_interval, UINT flags)
+{
+    backend_->present(sync_interval, flags);
+}
+
+// private
+bool StateCache::check(State state, bool same)
+{
+    if (same) {
+        frame_counters_.elided[size_t(state)]++;
+        return false;
+    }
+    frame_counters_.issued[size_t(state)]++;
+    return true;
+}
+
+template<typename T>
+bool StateCache::check(State state, Value<T>& shadow, T value)
+{
+    Value<T> next{ value, true };
+    bool same = enabled_ && shadow == next;
+    shadow = next;
+    return check(state, same);
+}
+
+template<typename T>
+bool StateCache::narrow(State state, T* shadow, const T* values, UINT& slot, UINT& count, UINT& first)
+{
+    UINT begin = count;
+    UINT end = 0;
+    for (UINT i = 0; i < count; ++i)
+    {
+        if (!enabled_ || !(shadow[slot + i] == values[i])) {
+            begin = (std::min)(begin, i);
+            end = i + 1;
+            shadow[slot + i] = values[i];
+        }
+    }
+    if (!check(state, begin >= end)) {
+        return false;
+    }
+    first = begin;
+    slot += begin;
+    count = end - begin;
+    return true;
+}
+
+bool StateCache::set_constant_buffers(Stage stage, UINT& slot, UINT& count, ID3D11Buffer* const* buffers,
+                                      const UINT* first_constant, const UINT* constant_count, UINT& first)
+{
+    assert(slot + count <= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+    ConstantBufferSlot values[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    for (UINT i = 0; i < count; ++i)
+    {
+        values[i] = ConstantBufferSlot{ buffers[i],
+                                        first_constant != nullptr ? first_constant[i] : 0,
+                                        constant_count != nullptr ? constant_count[i] : 0,
+                                        true };
+    }
+    return narrow(State::constant_buffers, state_.constant_buffers[stage], values, slot, count, first);
+}
+
+bool StateCache::set_shader_resources(Stage stage, UINT& slot, UINT& count, ID3D11ShaderResourceView* const* views, UINT& first)
+{
+    assert(slot + count <= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+    Value<ID3D11ShaderResourceView*> values[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    for (UINT i = 0; i < count; ++i) {
+        values[i] = { views[i], true };
+    }
+    return narrow(State::shader_resources, state_.shader_resources[stage], values, slot, count, first);
+}
+
+void StateCache::reset_to_defaults()
+{
+    state_ = ShadowState{};
+
+    state_.input_layout.known = true;
+    for (auto& vertex_buffer : state_.vertex_buffers) {
+        vertex_buffer.known = true;
+    }
+    state_.index_buffer.known = true;
+    state_.index_format.known = true;
+    state_.index_offset.known = true;
+    state_.topology.known = true;
+
+    state_.vertex_shader.known = true;
+    state_.geometry_shader.known = true;
+    state_.pixel_shader.known = true;
+    state_.compute_shader.known = true;
+
+    for (uint32_t stage = 0; stage < stage_count; ++stage)
+    {
+        for (auto& constant_buffer : state_.constant_buffers[stage]) {
+            constant_buffer.known = true;
+        }
+        for (auto& view : state_.shader_resources[stage]) {
+            view.known = true;
+        }
+    }
+    for (auto& sampler : state_.samplers) {
+        sampler.known = true;
+    }
+
+    state_.rasterizer_state.known = true;
+    state_.viewports_known = true;
+    state_.render_targets_known = true;
+
+    state_.blend_state.known = true;
+    std::fill(std::begin(state_.blend_factor), std::end(state_.blend_factor), 1.f);
+    state_.sample_mask = 0xFFFFFFFF;
+    state_.depth_stencil_state.known = true;
+}
+
+void StateCache::invalidate_shader_resources()
+{
+    for (uint32_t stage = 0; stage < stage_count; ++stage)
+    {
+        for (auto& view : state_.shader_resources[stage]) {
+            view.known = false;
+        }
+    }
+}
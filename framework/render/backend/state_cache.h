@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "render_backend.h"
+
+#define STATE_CACHE_STATES(FUNC)    \
+    FUNC(input_layout)              \
+    FUNC(vertex_buffers)            \
+    FUNC(index_buffer)              \
+    FUNC(primitive_topology)        \
+    FUNC(shaders)                   \
+    FUNC(constant_buffers)          \
+    FUNC(shader_resources)          \
+    FUNC(samplers)                  \
+    FUNC(rasterizer_state)          \
+    FUNC(viewports)                 \
+    FUNC(render_targets)            \
+    FUNC(blend_state)               \
+    FUNC(depth_stencil_state)
+
+// Shadow copy of pipeline state in front of another backend.
+// State calls which match what is bound already are dropped, slot ranges are narrowed
+// to slots which change. Everything else is forwarded as is.
+// Bound objects are referenced by the context, so their pointers can not be reused
+// while they are in the shadow state. Code which changes state on native context
+// directly has to call invalidate() afterwards.
+// Deferred contexts get own cache, their counters are added to this one on execute.
+class StateCache final : public RenderBackend
+{
+public:
+    enum class State : uint32_t
+    {
+#define STATE_CACHE_STATE_ENUM(state) state,
+        STATE_CACHE_STATES(STATE_CACHE_STATE_ENUM)
+#undef STATE_CACHE_STATE_ENUM
+        count
+    };
+
+    struct Counters
+    {
+        uint64_t issued[size_t(State::count)]{};
+        uint64_t elided[size_t(State::count)]{};
+    };
+
+    explicit StateCache(std::unique_ptr<RenderBackend> backend);
+    ~StateCache();
+
+    static const char* state_name(State state);
+
+    RenderBackend* backend() const; // wrapped backend
+
+    // disabled cache forwards every call, counts all of them as issued
+    void set_enabled(bool enabled);
+    bool enabled() const;
+    // forget shadow state: next call of every kind is issued
+    void invalidate();
+
+    // render thread, after present: counters of finished frame
+    void end_frame();
+    const Counters& frame_counters() const;
+    const Counters& total_counters() const;
+    void reset_counters();
+
+    Type type() const override;
+
+    ID3D11Device* device() const override;
+    ID3D11DeviceContext* context() const override;
+
+    HRESULT create_buffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) override;
+    HRESULT create_texture_2d(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) override;
+    HRESULT create_shader_resource_view(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view) override;
+    HRESULT create_render_target_view(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view) override;
+    HRESULT create_depth_stencil_view(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view) override;
+
+    HRESULT create_sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) override;
+    HRESULT create_rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) override;
+    HRESULT create_blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) override;
+    HRESULT create_depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) override;
+
+    HRESULT create_vertex_shader(const void* bytecode, SIZE_T size, ID3D11VertexShader** shader) override;
+    HRESULT create_geometry_shader(const void* bytecode, SIZE_T size, ID3D11GeometryShader** shader) override;
+    HRESULT create_pixel_shader(const void* bytecode, SIZE_T size, ID3D11PixelShader** shader) override;
+    HRESULT create_compute_shader(const void* bytecode, SIZE_T size, ID3D11ComputeShader** shader) override;
+    HRESULT create_input_layout(const D3D11_INPUT_ELEMENT_DESC* inputs, UINT count, const void* bytecode, SIZE_T size, ID3D11InputLayout** layout) override;
+
+    void clear_state() override;
+
+    HRESULT map(ID3D11Resource* resource, UINT subresource, D3D11_MAP map_type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) override;
+    void unmap(ID3D11Resource* resource, UINT subresource) override;
+    void update_subresource(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch) override;
+    void update_subresource1(ID3D11Resource* resource, UINT subresource, const D3D11_BOX* box, const void* data, UINT row_pitch, UINT depth_pitch, UINT copy_flags) override;
+    void copy_subresource_region(ID3D11Resource* destination, UINT destination_subresource, UINT x, UINT y, UINT z,
+                                 ID3D11Resource* source, UINT source_subresource, const D3D11_BOX* source_box) override;
+
+    void ia_set_input_layout(ID3D11InputLayout* layout) override;
+    void ia_set_vertex_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+    void ia_set_index_buffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+    void ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+
+    void vs_set_shader(ID3D11VertexShader* shader) override;
+    void gs_set_shader(ID3D11GeometryShader* shader) override;
+    void ps_set_shader(ID3D11PixelShader* shader) override;
+    void cs_set_shader(ID3D11ComputeShader* shader) override;
+
+    void vs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void gs_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+    void ps_set_constant_buffers(UINT slot, UINT count, ID3D11Buffer* const* buffers) override;
+
+    bool supports_constant_buffer_offsets() const override;
+    void vs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void gs_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+    void ps_set_constant_buffers1(UINT slot, UINT count, ID3D11Buffer* const* buffers, const UINT* first_constant, const UINT* constant_count) override;
+
+    void vs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void gs_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+    void ps_set_shader_resources(UINT slot, UINT count, ID3D11ShaderResourceView* const* views) override;
+
+    void ps_set_samplers(UINT slot, UINT count, ID3D11SamplerState* const* samplers) override;
+
+    void rs_set_state(ID3D11RasterizerState* state) override;
+    void rs_set_viewports(UINT count, const D3D11_VIEWPORT* viewports) override;
+
+    void om_set_render_targets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depth_view) override;
+    void om_set_blend_state(ID3D11BlendState* state, const FLOAT blend_factor[4], UINT sample_mask) override;
+    void om_set_depth_stencil_state(ID3D11DepthStencilState* state, UINT stencil_ref) override;
+
+    void clear_render_target_view(ID3D11RenderTargetView* view, const FLOAT color[4]) override;
+    void clear_depth_stencil_view(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) override;
+
+    void draw(UINT vertex_count, UINT start_vertex) override;
+    void draw_indexed(UINT index_count, UINT start_index, INT base_vertex) override;
+    void draw_indexed_instanced(UINT index_count, UINT instance_count, UINT start_index, INT base_vertex, UINT start_instance) override;
+
+    std::unique_ptr<RenderBackend> create_deferred_context() override;
+    void finish_command_list() override;
+    void execute_command_list(RenderBackend* deferred) override;
+
+    void begin_event(const wchar_t* name) override;
+    void end_event() override;
+
+    void present(UINT sync_interval, UINT flags) override;
+
+private:
+    enum Stage : uint32_t
+    {
+        vertex_stage,
+        geometry_stage,
+        pixel_stage,
+        stage_count,
+    };
+
+    // every shadow value knows if it matches the context
+    struct VertexBufferSlot
+    {
+        ID3D11Buffer* buffer;
+        UINT stride;
+        UINT offset;
+        bool known;
+
+        bool operator==(const VertexBufferSlot& other) const
+        {
+            return known && other.known && buffer == other.buffer && stride == other.stride && offset == other.offset;
+        }
+    };
+    struct ConstantBufferSlot
+    {
+        ID3D11Buffer* buffer;
+        UINT first_constant;    // 0 and 0 - whole buffer
+        UINT constant_count;
+        bool known;
+
+        bool operator==(const ConstantBufferSlot& other) const
+        {
+            return known && other.known && buffer == other.buffer &&
+                   first_constant == other.first_constant && constant_count == other.constant_count;
+        }
+    };
+    template<typename T>
+    struct Value
+    {
+        T value;
+        bool known;
+
+        bool operator==(const Value& other) const
+        {
+            return known && other.known && value == other.value;
+        }
+    };
+
+    struct ShadowState
+    {
+        Value<ID3D11InputLayout*> input_layout;
+        VertexBufferSlot vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+        Value<ID3D11Buffer*> index_buffer;
+        Value<DXGI_FORMAT> index_format;
+        Value<UINT> index_offset;
+        Value<D3D11_PRIMITIVE_TOPOLOGY> topology;
+
+        Value<ID3D11VertexShader*> vertex_shader;
+        Value<ID3D11GeometryShader*> geometry_shader;
+        Value<ID3D11PixelShader*> pixel_shader;
+        Value<ID3D11ComputeShader*> compute_shader;
+
+        ConstantBufferSlot constant_buffers[stage_count][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        Value<ID3D11ShaderResourceView*> shader_resources[stage_count][D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+        Value<ID3D11SamplerState*> samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+
+        Value<ID3D11RasterizerState*> rasterizer_state;
+        bool viewports_known;
+        UINT viewport_count;
+        D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+
+        bool render_targets_known;
+        UINT render_target_count;
+        ID3D11RenderTargetView* render_targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+        ID3D11DepthStencilView* depth_view;
+
+        Value<ID3D11BlendState*> blend_state;
+        FLOAT blend_factor[4];
+        UINT sample_mask;
+        Value<ID3D11DepthStencilState*> depth_stencil_state;
+        UINT stencil_ref;
+    };
+
+    // true when call has to be issued, counts it
+    bool check(State state, bool same);
+    template<typename T>
+    bool check(State state, Value<T>& shadow, T value);
+
+    // narrows [slot, slot + count) to changed slots and updates shadow
+    template<typename T>
+    bool narrow(State state, T* shadow, const T* values, UINT& slot, UINT& count, UINT& first);
+
+    bool set_constant_buffers(Stage stage, UINT& slot, UINT& count, ID3D11Buffer* const* buffers,
+                              const UINT* first_constant, const UINT* constant_count, UINT& first);
+    bool set_shader_resources(Stage stage, UINT& slot, UINT& count, ID3D11ShaderResourceView* const* views, UINT& first);
+
+    void reset_to_defaults(); // state after ClearState
+    void invalidate_shader_resources();
+
+    std::unique_ptr<RenderBackend> backend_;
+    bool enabled_{ true };
+    ShadowState state_{};
+
+    Counters frame_counters_;
+    Counters last_frame_counters_;
+    Counters total_counters_;
+};
@@ -154,10 +154,9 @@ const Matrix Camera::view_proj() const
     return view() * proj();
 }
 
-std::vector<std::pair<Matrix, float>> Camera::cascade_view_proj()
+Span<std::pair<Matrix, float>> Camera::cascade_view_proj(FrameArena& arena) const
 {
-    std::vector<std::pair<Matrix, float>> res;
-    res.reserve(Light::shadow_cascade_count);
+    auto res = arena.allocate_span<std::pair<Matrix, float>>(Light::shadow_cascade_count);
 
     float fars[Light::shadow_cascade_count] = { 50.f, 200.f, get_far() };
     float nears[Light::shadow_cascade_count] = { get_near(), get_near(), get_near() };
@@ -184,7 +183,7 @@ std::vector<std::pair<Matrix, float>> Camera::cascade_view_proj()
             break;
         }
         }
-        res.push_back(std::make_pair(view() * projection, fars[i]));
+        res[i] = std::make_pair(view() * projection, fars[i]);
     }
     return res;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 #include <SimpleMath.h>
 using namespace DirectX::SimpleMath;
 
+#include "core/frame_arena.h"
+
 class Camera
 {
 public:
@@ -35,7 +38,8 @@ public:
     const Matrix proj() const;
     const Matrix view_proj() const;
 
-    std::vector<std::pair<Matrix, float>> cascade_view_proj();
+    // view_proj and far plane of each shadow cascade, valid until arena reset
+    Span<std::pair<Matrix, float>> cascade_view_proj(FrameArena& arena) const;
 
     const Vector3& position() const;
     const Vector3& direction() const;
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cassert>
+
+#include "core/game.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/constant_ring.h"
+#include "command_list.h"
+
+// CommandList
+CommandList::CommandList(std::unique_ptr<RenderBackend> context) : context_{ std::move(context) }
+{
+    assert(context_ != nullptr);
+}
+
+CommandList::~CommandList()
+{
+    assert(!recording_ && !recorded_);
+}
+
+void CommandList::begin()
+{
+    assert(!recording_ && !recorded_);
+    recording_ = true;
+    Render::set_thread_context(context_.get());
+}
+
+void CommandList::end()
+{
+    assert(recording_);
+    context_->finish_command_list();
+    Render::set_thread_context(nullptr);
+    recording_ = false;
+    recorded_ = true;
+}
+
+void CommandList::execute()
+{
+    assert(recorded_);
+    Game::inst()->render().backend()->execute_command_list(context_.get());
+    recorded_ = false;
+}
+
+RenderBackend* CommandList::context() const
+{
+    return context_.get();
+}
+
+// CommandLists
+CommandLists::CommandLists()
+{
+}
+
+CommandLists::~CommandLists()
+{
+    assert(lists_.empty());
+}
+
+void CommandLists::record(JobSystem& jobs, uint32_t count, uint32_t grain, const RecordFunc& record)
+{
+    last_range_count_ = 0;
+    if (count == 0) {
+        return;
+    }
+
+    auto& render = Game::inst()->render();
+    grain = std::max(1u, grain);
+    uint32_t range_count = std::min((count + grain - 1) / grain, jobs.thread_count());
+    // without constant buffer offsets constant ring maps on every bind: immediate context only
+    if (!render.backend()->supports_constant_buffer_offsets()) {
+        range_count = 1;
+    }
+    while (range_count > 1 && deferred_supported_ && lists_.size() < range_count)
+    {
+        auto context = render.backend()->create_deferred_context();
+        if (context == nullptr) {
+            deferred_supported_ = false;
+            break;
+        }
+        lists_.push_back(std::make_unique<CommandList>(std::move(context)));
+    }
+    if (range_count <= 1 || !deferred_supported_)
+    {
+        last_range_count_ = 1;
+        record(0, count);
+        return;
+    }
+
+    // equal ranges, the last one may be shorter
+    const uint32_t range_size = (count + range_count - 1) / range_count;
+    range_count = (count + range_size - 1) / range_size;
+    last_range_count_ = range_count;
+
+    render.constant_ring()->flush();
+    {
+        ProfileScope record_scope("record command lists");
+        TaskGroup group(jobs);
+        for (uint32_t i = 0; i < range_count; ++i)
+        {
+            CommandList* list = lists_[i].get();
+            const uint32_t begin = i * range_size;
+            const uint32_t end = std::min(count, begin + range_size);
+            group.run([list, &record, begin, end] {
+                list->begin();
+                record(begin, end);
+                list->end();
+            });
+        }
+        group.wait();
+    }
+
+    ProfileScope execute_scope("execute command lists");
+    for (uint32_t i = 0; i < range_count; ++i) {
+        lists_[i]->execute();
+    }
+}
+
+uint32_t CommandLists::list_count() const
+{
+    return uint32_t(lists_.size());
+}
+
+uint32_t CommandLists::last_range_count() const
+{
+    return last_range_count_;
+}
+
+void CommandLists::destroy()
+{
+    lists_.clear();
+    deferred_supported_ = true;
+    last_range_count_ = 0;
+}
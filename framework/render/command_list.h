@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class RenderBackend;
+class JobSystem;
+
+// Context calls recorded on one thread, executed later on render thread.
+// Between begin() and end() Render::backend() of recording thread returns the deferred
+// context of the list, so usual draw code records into the list.
+// Every list starts from default context state: targets, viewports and frame constants
+// have to be bound again in each list.
+class CommandList final
+{
+public:
+    explicit CommandList(std::unique_ptr<RenderBackend> context);
+    ~CommandList();
+
+    CommandList(const CommandList&) = delete;
+    CommandList& operator=(const CommandList&) = delete;
+
+    // recording thread
+    void begin();
+    void end();
+
+    // render thread: immediate context has default state afterwards
+    void execute();
+
+    RenderBackend* context() const;
+
+private:
+    std::unique_ptr<RenderBackend> context_;
+    bool recording_{ false };
+    bool recorded_{ false };
+};
+
+// Command lists reused between frames, one per recorded range.
+class CommandLists final
+{
+public:
+    using RecordFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+    CommandLists();
+    ~CommandLists();
+
+    CommandLists(const CommandLists&) = delete;
+    CommandLists& operator=(const CommandLists&) = delete;
+
+    // Render thread. Splits [0, count) into at most one range per job thread, ranges have
+    // at least grain items. record(begin, end) of every range runs on job threads into own
+    // list, then lists are executed in range order, so result does not depend on threads.
+    // Constants written before are uploaded first: record must not write constant ring.
+    // One range, or backend without deferred contexts: record runs on immediate context.
+    void record(JobSystem& jobs, uint32_t count, uint32_t grain, const RecordFunc& record);
+
+    uint32_t list_count() const;     // lists created so far
+    uint32_t last_range_count() const; // ranges of last record
+
+    void destroy();
+
+private:
+    std::vector<std::unique_ptr<CommandList>> lists_;
+    bool deferred_supported_{ true };
+    uint32_t last_range_count_{ 0 };
+};
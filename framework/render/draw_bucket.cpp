@@ -0,0 +1,218 @@
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "core/game.h"
+#include "core/profiler.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/buffer.h"
+#include "render/resource/pipeline_state.h"
+#include "render/scene/material.h"
+#include "render/scene/mesh.h"
+#include "draw_bucket.h"
+
+DrawBucket::DrawBucket(FrameArena& arena) :
+    arena_{ arena },
+    commands_{ FrameAllocator<Command>(arena) },
+    order_{ FrameAllocator<SortEntry>(arena) },
+    batches_{ FrameAllocator<Batch>(arena) }
+{
+}
+
+uint64_t DrawBucket::make_key(Pass pass, uint32_t pipeline_id, uint32_t material_id, uint32_t mesh_id, float depth)
+{
+    // bits of non negative float grow with its value: top bits are quantised depth
+    uint32_t depth_key = 0;
+    if (depth > 0.f) {
+        std::memcpy(&depth_key, &depth, sizeof(depth_key));
+        depth_key >>= 32 - depth_bits;
+    }
+
+    uint64_t key = uint64_t(pass) & ((1ull << pass_bits) - 1);
+    key = (key << pipeline_bits) | (pipeline_id & ((1u << pipeline_bits) - 1));
+    key = (key << material_bits) | (material_id & ((1u << material_bits) - 1));
+    key = (key << mesh_bits) | (mesh_id & ((1u << mesh_bits) - 1));
+    key = (key << depth_bits) | depth_key;
+    return key;
+}
+
+void DrawBucket::add(uint64_t key, PipelineState* pipeline, PipelineState* instanced_pipeline, Mesh* mesh,
+                     const ConstantRing::Allocation* object_constants, const Instance* instance)
+{
+    order_.push_back(SortEntry{ key, uint32_t(commands_.size()) });
+    commands_.push_back(Command{ key, pipeline, instanced_pipeline, mesh, object_constants, instance });
+}
+
+void DrawBucket::sort()
+{
+    ProfileScope sort_scope("draw bucket sort");
+    if (order_.size() >= 2) {
+        radix_sort();
+    }
+
+    // ids in keys may collide, batches compare objects
+    batches_.clear();
+    instance_count_ = 0;
+    for (uint32_t i = 0; i < uint32_t(order_.size());)
+    {
+        const Command& command = commands_[order_[i].index];
+        uint32_t end = i + 1;
+        if (command.instanced_pipeline != nullptr)
+        {
+            while (end < order_.size())
+            {
+                const Command& next = commands_[order_[end].index];
+                if (next.pipeline != command.pipeline || next.instanced_pipeline != command.instanced_pipeline || next.mesh != command.mesh) {
+                    break;
+                }
+                ++end;
+            }
+            if (end - i < min_instance_count) {
+                end = i + 1;
+            }
+        }
+
+        Batch batch{ i, end - i, 0, {} };
+        if (batch.count > 1) {
+            batch.instance_offset = instance_count_;
+            instance_count_ += batch.count;
+        }
+        batches_.push_back(batch);
+        i = end;
+    }
+}
+
+uint32_t DrawBucket::instance_count() const
+{
+    return instance_count_;
+}
+
+uint32_t DrawBucket::draw_count() const
+{
+    return uint32_t(batches_.size());
+}
+
+void DrawBucket::radix_sort()
+{
+    // LSD radix sort by bytes, stable; bytes equal in all keys are skipped
+    Span<SortEntry> scratch = arena_.allocate_span<SortEntry>(order_.size());
+    SortEntry* source = order_.data();
+    SortEntry* destination = scratch.data();
+    const size_t count = order_.size();
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        uint32_t offsets[256] = {};
+        for (size_t i = 0; i < count; ++i) {
+            offsets[(source[i].key >> shift) & 0xFF]++;
+        }
+        if (offsets[(source[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for (auto& offset : offsets)
+        {
+            uint32_t bucket_count = offset;
+            offset = sum;
+            sum += bucket_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != order_.data()) {
+        std::memcpy(order_.data(), source, count * sizeof(SortEntry));
+    }
+}
+
+void DrawBucket::submit(StructuredBuffer* instances)
+{
+    prepare(instances);
+    submit(instances, 0, draw_count());
+}
+
+void DrawBucket::prepare(StructuredBuffer* instances)
+{
+    if (instance_count_ == 0) {
+        return;
+    }
+
+    // transforms of all instanced draws in one upload
+    assert(instances != nullptr && instances->count() >= instance_count_);
+    auto constant_ring = Game::inst()->render().constant_ring();
+    Span<Instance> data = arena_.allocate_span<Instance>(instance_count_);
+    for (auto& batch : batches_)
+    {
+        if (batch.count < 2) {
+            continue;
+        }
+        for (uint32_t i = 0; i < batch.count; ++i) {
+            data[batch.instance_offset + i] = *commands_[order_[batch.first + i].index].instance;
+        }
+        // instanced pipeline reads transforms from instance_offset
+        const uint32_t instance_data[4] = { batch.instance_offset, 0, 0, 0 };
+        batch.instance_constants = constant_ring->write(instance_data, sizeof(instance_data));
+    }
+    instances->update_data(data.data(), instance_count_);
+}
+
+void DrawBucket::submit(StructuredBuffer* instances, uint32_t first_draw, uint32_t end_draw)
+{
+    assert(first_draw <= end_draw && end_draw <= draw_count());
+    auto backend = Game::inst()->render().backend();
+    auto constant_ring = Game::inst()->render().constant_ring();
+
+    if (instance_count_ > 0) {
+        instances->bind(0);
+    }
+
+    const PipelineState* pipeline = nullptr;
+    const Material* material = nullptr;
+    const Mesh* mesh = nullptr;
+    const ConstantRing::Allocation* object_constants = nullptr;
+    for (uint32_t i = first_draw; i < end_draw; ++i)
+    {
+        const Batch& batch = batches_[i];
+        const Command& command = commands_[order_[batch.first].index];
+        const PipelineState* batch_pipeline = batch.count > 1 ? command.instanced_pipeline : command.pipeline;
+        batch_pipeline->apply(pipeline);
+        pipeline = batch_pipeline;
+        if (batch.count > 1)
+        {
+            constant_ring->bind(batch.instance_constants, 1);
+            object_constants = nullptr;
+        }
+        else if (command.object_constants != object_constants)
+        {
+            constant_ring->bind(*command.object_constants, 1);
+            object_constants = command.object_constants;
+        }
+        if (command.mesh->material() != material) {
+            command.mesh->material()->bind();
+            material = command.mesh->material();
+        }
+        if (command.mesh != mesh) {
+            command.mesh->bind();
+            mesh = command.mesh;
+        }
+
+        if (batch.count > 1) {
+            backend->draw_indexed_instanced(command.mesh->index_count(), batch.count, command.mesh->first_index(), command.mesh->base_vertex(), 0);
+        } else {
+            backend->draw_indexed(command.mesh->index_count(), command.mesh->first_index(), command.mesh->base_vertex());
+        }
+    }
+}
+
+size_t DrawBucket::size() const
+{
+    return commands_.size();
+}
+
+const DrawBucket::Command& DrawBucket::operator[](size_t index) const
+{
+    return commands_[order_[index].index];
+}
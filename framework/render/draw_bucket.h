@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+
+#include <SimpleMath.h>
+using namespace DirectX::SimpleMath;
+
+#include "core/frame_arena.h"
+#include "render/resource/constant_ring.h"
+
+class PipelineState;
+class Mesh;
+class StructuredBuffer;
+
+// Draw commands of one frame, sorted by 64 bit key before submit.
+// Key from high to low bits: pass, pipeline, material, mesh, depth - so state changes
+// are grouped and draws with same state go front to back.
+// Neighbour commands which differ only by depth and have instanced pipeline are merged
+// into one instanced draw, their transforms go to structured buffer.
+// Commands live in frame arena, bucket must not outlive the frame.
+class DrawBucket final
+{
+public:
+    enum class Pass : uint32_t
+    {
+        opaque = 0,
+    };
+
+    // object transform: ModelData constants of single draw, element of instance buffer
+    struct Instance
+    {
+        Matrix transform;
+        Matrix inverse_transpose_transform;
+    };
+
+    struct Command
+    {
+        uint64_t key;
+        PipelineState* pipeline;
+        PipelineState* instanced_pipeline; // nullptr - never instanced
+        Mesh* mesh;
+        const ConstantRing::Allocation* object_constants; // slot 1, owned by drawn object
+        const Instance* instance; // same data, owned by drawn object
+    };
+
+    constexpr static uint32_t min_instance_count = 2;
+
+    constexpr static uint32_t pass_bits = 4;
+    constexpr static uint32_t pipeline_bits = 8;
+    constexpr static uint32_t material_bits = 16;
+    constexpr static uint32_t mesh_bits = 12;
+    constexpr static uint32_t depth_bits = 24;
+    static_assert(pass_bits + pipeline_bits + material_bits + mesh_bits + depth_bits == 64, "key is 64 bits");
+
+    explicit DrawBucket(FrameArena& arena);
+
+    DrawBucket(const DrawBucket&) = delete;
+    DrawBucket& operator=(const DrawBucket&) = delete;
+
+    // ids are truncated to their bit count, depth is view depth (negative clamps to 0)
+    static uint64_t make_key(Pass pass, uint32_t pipeline_id, uint32_t material_id, uint32_t mesh_id, float depth);
+
+    void add(uint64_t key, PipelineState* pipeline, PipelineState* instanced_pipeline, Mesh* mesh,
+             const ConstantRing::Allocation* object_constants, const Instance* instance);
+
+    // sorts commands and merges instanced draws
+    void sort();
+    uint32_t instance_count() const; // elements of instance buffer needed by submit
+    uint32_t draw_count() const;     // draw calls issued by submit
+    // Render thread: applies pipelines and binds only state which differs from previous draw.
+    // Instance buffer holds at least instance_count() elements, bound to vs slot 0.
+    void submit(StructuredBuffer* instances);
+
+    // submit split for command lists: prepare() on render thread uploads instance data and
+    // writes constants of all draws, then ranges of [0, draw_count()) go to any threads
+    void prepare(StructuredBuffer* instances);
+    void submit(StructuredBuffer* instances, uint32_t first_draw, uint32_t end_draw);
+
+    size_t size() const;
+    const Command& operator[](size_t index) const; // in sorted order after sort()
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // sorted commands [first, first + count) drawn at once
+    struct Batch
+    {
+        uint32_t first;
+        uint32_t count;
+        uint32_t instance_offset; // in instance buffer, when count > 1
+        ConstantRing::Allocation instance_constants; // instance_offset for shader, written by prepare()
+    };
+
+    void radix_sort();
+
+    FrameArena& arena_;
+    FrameVector<Command> commands_;
+    FrameVector<SortEntry> order_;
+    FrameVector<Batch> batches_;
+    uint32_t instance_count_{ 0 };
+};
@@ -0,0 +1,213 @@
+#include <cmath>
+#include <immintrin.h>
+
+#include "frustum_culling.h"
+
+namespace
+{
+// column j of row vector matrix: clip.j = dot(p, column j)
+Vector4 column(const Matrix& m, int j)
+{
+    return Vector4(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]);
+}
+
+Vector4 normalize_plane(const Vector4& plane)
+{
+    const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    return length > 0.f ? plane / length : plane;
+}
+}
+
+// static
+Frustum Frustum::from_view_proj(const Matrix& view_proj)
+{
+    const Vector4 x = column(view_proj, 0);
+    const Vector4 y = column(view_proj, 1);
+    const Vector4 z = column(view_proj, 2);
+    const Vector4 w = column(view_proj, 3);
+
+    // -w <= x <= w, -w <= y <= w, 0 <= z <= w
+    Frustum frustum;
+    frustum.planes[left] = normalize_plane(w + x);
+    frustum.planes[right] = normalize_plane(w - x);
+    frustum.planes[bottom] = normalize_plane(w + y);
+    frustum.planes[top] = normalize_plane(w - y);
+    frustum.planes[near_plane] = normalize_plane(z);
+    frustum.planes[far_plane] = normalize_plane(w - z);
+    return frustum;
+}
+
+void transform_box(const Vector3& center, const Vector3& extent, const Matrix& transform,
+                   Vector3& transformed_center, Vector3& transformed_extent)
+{
+    // J. Arvo, "Transforming Axis-Aligned Bounding Boxes": extent along world axis j
+    // is the sum of box axes projected on it
+    transformed_center = Vector3::Transform(center, transform);
+    for (int j = 0; j < 3; ++j)
+    {
+        float e = 0.f;
+        for (int i = 0; i < 3; ++i) {
+            e += std::fabs(transform.m[i][j]) * (&extent.x)[i];
+        }
+        (&transformed_extent.x)[j] = e;
+    }
+}
+
+void CullingBoxes::clear()
+{
+    center_x_.clear();
+    center_y_.clear();
+    center_z_.clear();
+    extent_x_.clear();
+    extent_y_.clear();
+    extent_z_.clear();
+}
+
+void CullingBoxes::reserve(uint32_t count)
+{
+    center_x_.reserve(count);
+    center_y_.reserve(count);
+    center_z_.reserve(count);
+    extent_x_.reserve(count);
+    extent_y_.reserve(count);
+    extent_z_.reserve(count);
+}
+
+uint32_t CullingBoxes::add(const Vector3& center, const Vector3& extent)
+{
+    center_x_.push_back(center.x);
+    center_y_.push_back(center.y);
+    center_z_.push_back(center.z);
+    extent_x_.push_back(extent.x);
+    extent_y_.push_back(extent.y);
+    extent_z_.push_back(extent.z);
+    return uint32_t(center_x_.size() - 1);
+}
+
+uint32_t CullingBoxes::size() const
+{
+    return uint32_t(center_x_.size());
+}
+
+// Per plane: distance of center d = dot(n, c) + w and projected radius r = dot(|n|, e),
+// box is outside when d + r < 0. Operations are in the same order in every path,
+// so SIMD and scalar results are identical.
+uint32_t CullingBoxes::cull(const Frustum& frustum, uint32_t* visible) const
+{
+    const uint32_t count = size();
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+
+#if defined(__AVX2__)
+    {
+        __m256 plane[Frustum::plane_count][7];
+        for (int p = 0; p < Frustum::plane_count; ++p)
+        {
+            const Vector4& n = frustum.planes[p];
+            plane[p][0] = _mm256_set1_ps(n.x);
+            plane[p][1] = _mm256_set1_ps(n.y);
+            plane[p][2] = _mm256_set1_ps(n.z);
+            plane[p][3] = _mm256_set1_ps(n.w);
+            plane[p][4] = _mm256_set1_ps(std::fabs(n.x));
+            plane[p][5] = _mm256_set1_ps(std::fabs(n.y));
+            plane[p][6] = _mm256_set1_ps(std::fabs(n.z));
+        }
+        const __m256 zero = _mm256_setzero_ps();
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(center_x_.data() + i);
+            const __m256 cy = _mm256_loadu_ps(center_y_.data() + i);
+            const __m256 cz = _mm256_loadu_ps(center_z_.data() + i);
+            const __m256 ex = _mm256_loadu_ps(extent_x_.data() + i);
+            const __m256 ey = _mm256_loadu_ps(extent_y_.data() + i);
+            const __m256 ez = _mm256_loadu_ps(extent_z_.data() + i);
+            int mask = 0xFF;
+            for (int p = 0; p < Frustum::plane_count && mask != 0; ++p)
+            {
+                __m256 d = _mm256_add_ps(_mm256_mul_ps(cx, plane[p][0]), _mm256_mul_ps(cy, plane[p][1]));
+                d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(cz, plane[p][2])), plane[p][3]);
+                __m256 r = _mm256_add_ps(_mm256_mul_ps(ex, plane[p][4]), _mm256_mul_ps(ey, plane[p][5]));
+                r = _mm256_add_ps(r, _mm256_mul_ps(ez, plane[p][6]));
+                mask &= _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+            }
+            // branchless compaction: every lane is written, only visible ones advance
+            for (uint32_t lane = 0; lane < 8; ++lane)
+            {
+                visible[visible_count] = i + lane;
+                visible_count += (mask >> lane) & 1;
+            }
+        }
+    }
+#endif
+
+    {
+        __m128 plane[Frustum::plane_count][7];
+        for (int p = 0; p < Frustum::plane_count; ++p)
+        {
+            const Vector4& n = frustum.planes[p];
+            plane[p][0] = _mm_set1_ps(n.x);
+            plane[p][1] = _mm_set1_ps(n.y);
+            plane[p][2] = _mm_set1_ps(n.z);
+            plane[p][3] = _mm_set1_ps(n.w);
+            plane[p][4] = _mm_set1_ps(std::fabs(n.x));
+            plane[p][5] = _mm_set1_ps(std::fabs(n.y));
+            plane[p][6] = _mm_set1_ps(std::fabs(n.z));
+        }
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(center_x_.data() + i);
+            const __m128 cy = _mm_loadu_ps(center_y_.data() + i);
+            const __m128 cz = _mm_loadu_ps(center_z_.data() + i);
+            const __m128 ex = _mm_loadu_ps(extent_x_.data() + i);
+            const __m128 ey = _mm_loadu_ps(extent_y_.data() + i);
+            const __m128 ez = _mm_loadu_ps(extent_z_.data() + i);
+            int mask = 0xF;
+            for (int p = 0; p < Frustum::plane_count && mask != 0; ++p)
+            {
+                __m128 d = _mm_add_ps(_mm_mul_ps(cx, plane[p][0]), _mm_mul_ps(cy, plane[p][1]));
+                d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(cz, plane[p][2])), plane[p][3]);
+                __m128 r = _mm_add_ps(_mm_mul_ps(ex, plane[p][4]), _mm_mul_ps(ey, plane[p][5]));
+                r = _mm_add_ps(r, _mm_mul_ps(ez, plane[p][6]));
+                mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(d, r), zero));
+            }
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                visible[visible_count] = i + lane;
+                visible_count += (mask >> lane) & 1;
+            }
+        }
+    }
+
+    // tail
+    return visible_count + cull_scalar(frustum, i, visible + visible_count);
+}
+
+uint32_t CullingBoxes::cull_scalar(const Frustum& frustum, uint32_t* visible) const
+{
+    return cull_scalar(frustum, 0, visible);
+}
+
+// private
+uint32_t CullingBoxes::cull_scalar(const Frustum& frustum, uint32_t begin, uint32_t* visible) const
+{
+    const uint32_t count = size();
+    uint32_t visible_count = 0;
+    for (uint32_t i = begin; i < count; ++i)
+    {
+        bool inside = true;
+        for (int p = 0; p < Frustum::plane_count && inside; ++p)
+        {
+            const Vector4& n = frustum.planes[p];
+            float d = center_x_[i] * n.x + center_y_[i] * n.y;
+            d = d + center_z_[i] * n.z + n.w;
+            float r = extent_x_[i] * std::fabs(n.x) + extent_y_[i] * std::fabs(n.y);
+            r = r + extent_z_[i] * std::fabs(n.z);
+            inside = d + r >= 0.f;
+        }
+        if (inside) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
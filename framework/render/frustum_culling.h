@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SimpleMath.h>
+using namespace DirectX::SimpleMath;
+
+// Clip volume of view projection as six planes with normals inside:
+// point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum
+{
+    enum Plane
+    {
+        left = 0,
+        right,
+        bottom,
+        top,
+        near_plane,
+        far_plane,
+        plane_count
+    };
+
+    Vector4 planes[plane_count];
+
+    // view_proj maps row vectors to D3D clip space (z in [0, w]), as Camera::view_proj()
+    static Frustum from_view_proj(const Matrix& view_proj);
+};
+
+// axis aligned box of box (center, half extent) after transform
+void transform_box(const Vector3& center, const Vector3& extent, const Matrix& transform,
+                   Vector3& transformed_center, Vector3& transformed_extent);
+
+// World space boxes in structure of arrays layout, tested against frustum
+// 4 (SSE) or 8 (AVX2 builds) at a time.
+// Box is culled when it is fully behind one of the planes, so the test is conservative:
+// boxes near frustum corners may stay visible.
+class CullingBoxes final
+{
+public:
+    void clear();
+    void reserve(uint32_t count);
+    // index of added box
+    uint32_t add(const Vector3& center, const Vector3& extent);
+    uint32_t size() const;
+
+    // visible holds size() indices; gets indices of visible boxes in ascending order, returns their count
+    uint32_t cull(const Frustum& frustum, uint32_t* visible) const;
+    // one box at a time, reference of cull()
+    uint32_t cull_scalar(const Frustum& frustum, uint32_t* visible) const;
+
+private:
+    uint32_t cull_scalar(const Frustum& frustum, uint32_t begin, uint32_t* visible) const;
+
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> extent_x_;
+    std::vector<float> extent_y_;
+    std::vector<float> extent_z_;
+};
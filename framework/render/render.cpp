@@ -9,7 +9,33 @@
 #include "win32/input.h"
 #include "d3d11_common.h"
 #include "resource/shader.h"
+#include "resource/constant_ring.h"
+#include "resource/geometry_pool.h"
+#include "resource/state_objects.h"
+#include "resource/resource_manager.h"
+#include "resource/texture_cache.h"
+#include "resource/shader_cache.h"
+#include "resource/shader_compiler.h"
+#include "resource/shader_hot_reload.h"
+#include "command_list.h"
+#include "scene/mesh.h"
 #include "camera.h"
+#include "backend/d3d11_backend.h"
+#include "backend/null_backend.h"
+#include "backend/state_cache.h"
+
+namespace
+{
+thread_local RenderBackend* tls_thread_context = nullptr;
+}
+
+Render::Render()
+{
+}
+
+Render::~Render()
+{
+}
 
 void Render::initialize()
 {
@@ -43,6 +69,8 @@ void Render::initialize()
     swapDesc.SampleDesc.Count = 1;
     swapDesc.SampleDesc.Quality = 0;
 
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
     {
         uint32_t create_device_flags = 0;
 #ifndef NDEBUG
@@ -79,14 +107,14 @@ void Render::initialize()
                                                   nullptr, create_device_flags,
                                                   featureLevel, 1, D3D11_SDK_VERSION,
                                                   &swapDesc, &swapchain_,
-                                                  &device_, nullptr, &context_));
+                                                  &device, nullptr, &context));
 #else
         // choose default adapter
         D3D11_CHECK(D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE,
                                                   nullptr, create_device_flags,
                                                   featureLevel, 1, D3D11_SDK_VERSION,
                                                   &swapDesc, &swapchain_,
-                                                  &device_, nullptr, &context_));
+                                                  &device, nullptr, &context));
 #endif
 
 #ifndef NDEBUG
@@ -94,12 +122,68 @@ void Render::initialize()
         swapchain_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(swapchain_name.size()), swapchain_name.c_str());
 
         std::string context_name = "default_context";
-        context_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(context_name.size()), context_name.c_str());
+        context->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(context_name.size()), context_name.c_str());
 #endif
     }
 
+    backend_ = std::make_unique<StateCache>(std::make_unique<D3D11Backend>(device.Get(), context.Get(), swapchain_.Get()));
+    constant_ring_ = std::make_unique<ConstantRing>();
+    constant_ring_->initialize();
+    geometry_pool_ = std::make_unique<GeometryPool>();
+    geometry_pool_->initialize(sizeof(Vertex));
+    state_objects_ = std::make_unique<StateObjects>();
+    command_lists_ = std::make_unique<CommandLists>();
+    resources_ = std::make_unique<ResourceManager>();
+    resources_->initialize();
+    texture_cache_ = std::make_unique<TextureCache>();
+    shader_cache_ = std::make_unique<ShaderCache>();
+    shader_cache_->load(ShaderCache::default_filename);
+    shader_compiler_ = std::make_unique<ShaderCompiler>();
+    shader_hot_reload_ = std::make_unique<ShaderHotReload>();
+    if (!shader_hot_reload_->start("./resources/shaders")) {
+        OutputDebugString("Can not watch shader sources, hot reload is off\n");
+    }
+
+    create_render_target_view();
+    create_depth_stencil_state();
+    create_depth_stencil_texture_and_view();
+
+    camera_ = new Camera();
+    // camera_->set_camera(Vector3(100.f), Vector3(0.f, 0.f, 1.f));
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = NULL;
+    ImGui_ImplWin32_Init(hWnd);
+    ImGui_ImplDX11_Init(device.Get(), context.Get());
+}
+
+void Render::initialize_headless()
+{
+    backend_ = std::make_unique<StateCache>(std::make_unique<NullBackend>());
+    constant_ring_ = std::make_unique<ConstantRing>();
+    constant_ring_->initialize();
+    geometry_pool_ = std::make_unique<GeometryPool>();
+    geometry_pool_->initialize(sizeof(Vertex));
+    state_objects_ = std::make_unique<StateObjects>();
+    command_lists_ = std::make_unique<CommandLists>();
+    resources_ = std::make_unique<ResourceManager>();
+    resources_->initialize();
+    texture_cache_ = std::make_unique<TextureCache>();
+    shader_cache_ = std::make_unique<ShaderCache>();
+    shader_cache_->load(ShaderCache::default_filename);
+    shader_compiler_ = std::make_unique<ShaderCompiler>();
+    shader_hot_reload_ = std::make_unique<ShaderHotReload>(); // sources are not watched
+
     create_render_target_view();
+    create_depth_stencil_state();
+    create_depth_stencil_texture_and_view();
+
+    camera_ = new Camera();
+}
 
+void Render::create_depth_stencil_state()
+{
     // setup depth stencil
     D3D11_DEPTH_STENCIL_DESC depth_stencil_desc = {};
 
@@ -121,21 +205,7 @@ void Render::initialize()
     depth_stencil_desc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
     depth_stencil_desc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 
-    D3D11_CHECK(device_->CreateDepthStencilState(&depth_stencil_desc, &depth_stencil_state_));
-
-    create_depth_stencil_texture_and_view();
-
-    camera_ = new Camera();
-    // camera_->set_camera(Vector3(100.f), Vector3(0.f, 0.f, 1.f));
-
-    // initialize debug annotations
-    context_->QueryInterface(__uuidof(ID3DUserDefinedAnnotation), reinterpret_cast<void**>(&user_defined_annotation_));
-
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
-    io.IniFilename = NULL;
-    ImGui_ImplWin32_Init(hWnd);
-    ImGui_ImplDX11_Init(device_.Get(), context_.Get());
+    D3D11_CHECK(state_objects_->depth_stencil_state(&depth_stencil_desc, &depth_stencil_state_));
 }
 
 void Render::resize()
@@ -171,10 +241,8 @@ void Render::fullscreen(bool is_fullscreen)
     resize();
 }
 
-void Render::prepare_frame()
+void Render::update_camera()
 {
-    context_->ClearState();
-
     { // move camera
         float camera_move_delta = Game::inst()->delta_time() * 1e2f;
         const auto& keyboard = Game::inst()->win().input()->keyboard();
@@ -207,15 +275,23 @@ void Render::prepare_frame()
     }
 }
 
+void Render::prepare_frame()
+{
+    backend_->clear_state();
+    constant_ring_->begin_frame();
+    // holes left by unloaded meshes
+    geometry_pool_->defragment();
+}
+
 void Render::prepare_resources() const
 {
-    context_->OMSetRenderTargets(1, &render_target_view_, depth_stencil_view_);
+    backend_->om_set_render_targets(1, &render_target_view_, depth_stencil_view_);
 
     float clear_color[4] = { 0.f, 0.f, 0.f, 1.f };
-    context_->ClearRenderTargetView(render_target_view_, clear_color);
+    backend_->clear_render_target_view(render_target_view_, clear_color);
 
-    context_->OMSetDepthStencilState(depth_stencil_state_, 0);
-    context_->ClearDepthStencilView(depth_stencil_view_, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0xFF);
+    backend_->om_set_depth_stencil_state(depth_stencil_state_, 0);
+    backend_->clear_depth_stencil_view(depth_stencil_view_, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0xFF);
 
     D3D11_VIEWPORT viewport = {};
     viewport.Width = Game::inst()->win().screen_width();
@@ -225,7 +301,7 @@ void Render::prepare_resources() const
     viewport.MinDepth = 0;
     viewport.MaxDepth = 1.0f;
 
-    context_->RSSetViewports(1, &viewport);
+    backend_->rs_set_viewports(1, &viewport);
 }
 
 void Render::prepare_imgui()
@@ -241,25 +317,31 @@ void Render::end_imgui()
     ImGui::EndFrame();
     ImGui::Render();
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    // imgui draws on native context
+    backend_->invalidate();
 }
 
 void Render::restore_targets()
 {
-    context_->OMSetRenderTargets(0, nullptr, nullptr);
+    backend_->om_set_render_targets(0, nullptr, nullptr);
 }
 
 void Render::end_frame()
 {
-    D3D11_CHECK(swapchain_->Present(1, /* DXGI_PRESENT_DO_NOT_WAIT */ 0));
+    backend_->present(1, /* DXGI_PRESENT_DO_NOT_WAIT */ 0);
+    backend_->end_frame();
+    resources_->end_frame();
+    shader_hot_reload_->update();
+    shader_compiler_->flush();
 }
 
 void Render::destroy_resources()
 {
-    ImGui_ImplDX11_Shutdown();
-    ImGui_ImplWin32_Shutdown();
-    ImGui::DestroyContext(ImGui::GetCurrentContext());
-
-    user_defined_annotation_->Release();
+    if (swapchain_) {
+        ImGui_ImplDX11_Shutdown();
+        ImGui_ImplWin32_Shutdown();
+        ImGui::DestroyContext(ImGui::GetCurrentContext());
+    }
 
     delete camera_;
 
@@ -268,27 +350,130 @@ void Render::destroy_resources()
     destroy_depth_stencil_texture_and_view();
 
     destroy_render_target_view();
+
+    shader_hot_reload_->destroy();
+    shader_hot_reload_.reset();
+    shader_compiler_->destroy();
+    shader_compiler_.reset();
+    if (!shader_cache_->save()) {
+        OutputDebugString("Can not write shader cache\n");
+    }
+    shader_cache_->destroy();
+    shader_cache_.reset();
+    texture_cache_->destroy();
+    texture_cache_.reset();
+    // resources free their geometry and state objects
+    resources_->destroy();
+    resources_.reset();
+    command_lists_->destroy();
+    command_lists_.reset();
+    geometry_pool_->destroy();
+    geometry_pool_.reset();
+    state_objects_->destroy();
+    state_objects_.reset();
+    constant_ring_->destroy();
+    constant_ring_.reset();
+    backend_.reset();
+    swapchain_.Reset();
+}
+
+RenderBackend* Render::backend() const
+{
+    if (tls_thread_context != nullptr) {
+        return tls_thread_context;
+    }
+    return backend_.get();
+}
+
+StateCache* Render::state_cache() const
+{
+    return backend_.get();
+}
+
+ConstantRing* Render::constant_ring() const
+{
+    return constant_ring_.get();
+}
+
+GeometryPool* Render::geometry_pool() const
+{
+    return geometry_pool_.get();
+}
+
+StateObjects* Render::state_objects() const
+{
+    return state_objects_.get();
+}
+
+CommandLists* Render::command_lists() const
+{
+    return command_lists_.get();
+}
+
+ResourceManager* Render::resources() const
+{
+    return resources_.get();
+}
+
+TextureCache* Render::texture_cache() const
+{
+    return texture_cache_.get();
+}
+
+ShaderCache* Render::shader_cache() const
+{
+    return shader_cache_.get();
+}
+
+ShaderCompiler* Render::shader_compiler() const
+{
+    return shader_compiler_.get();
+}
+
+ShaderHotReload* Render::shader_hot_reload() const
+{
+    return shader_hot_reload_.get();
+}
+
+// static
+void Render::set_thread_context(RenderBackend* context)
+{
+    tls_thread_context = context;
 }
 
 ID3D11Device* Render::device() const
 {
-    return device_.Get();
+    return backend_->device();
 }
 
 ID3D11DeviceContext* Render::context() const
 {
-    return context_.Get();
+    return backend_->context();
 }
 
 void Render::create_render_target_view()
 {
     destroy_render_target_view();
-    D3D11_CHECK(swapchain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backbuffer_texture_));
+    if (swapchain_) {
+        D3D11_CHECK(swapchain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backbuffer_texture_));
+    } else {
+        // headless: render into offscreen texture of window size
+        D3D11_TEXTURE2D_DESC backbuffer_desc{};
+        backbuffer_desc.Width = UINT(Game::inst()->win().screen_width());
+        backbuffer_desc.Height = UINT(Game::inst()->win().screen_height());
+        backbuffer_desc.MipLevels = 1;
+        backbuffer_desc.ArraySize = 1;
+        backbuffer_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        backbuffer_desc.SampleDesc.Count = 1;
+        backbuffer_desc.Usage = D3D11_USAGE_DEFAULT;
+        backbuffer_desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+        D3D11_CHECK(backend_->create_texture_2d(&backbuffer_desc, nullptr, &backbuffer_texture_));
+    }
 #ifndef NDEBUG
     std::string backbuffer_texture_name = "default_backbuffer";
     backbuffer_texture_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(backbuffer_texture_name.size()), backbuffer_texture_name.c_str());
 #endif
-    D3D11_CHECK(device_->CreateRenderTargetView(backbuffer_texture_, nullptr, &render_target_view_));
+    D3D11_CHECK(backend_->create_render_target_view(backbuffer_texture_, nullptr, &render_target_view_));
 #ifndef NDEBUG
     std::string render_target_view_name = "default_render_target_view";
     render_target_view_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(render_target_view_name.size()), render_target_view_name.c_str());
@@ -309,13 +494,13 @@ void Render::create_depth_stencil_texture_and_view()
     backbuffer_texture_->GetDesc(&depth_texture_desc);
     depth_texture_desc.Format = DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
     depth_texture_desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-    D3D11_CHECK(device_->CreateTexture2D(&depth_texture_desc, nullptr, &depth_stencil_texture_));
+    D3D11_CHECK(backend_->create_texture_2d(&depth_texture_desc, nullptr, &depth_stencil_texture_));
 #ifndef NDEBUG
     std::string depth_stencil_texture_name = "default_depth_stencil_texture";
     depth_stencil_texture_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(depth_stencil_texture_name.size()), depth_stencil_texture_name.c_str());
 #endif
 
-    D3D11_CHECK(device_->CreateDepthStencilView(depth_stencil_texture_, nullptr, &depth_stencil_view_));
+    D3D11_CHECK(backend_->create_depth_stencil_view(depth_stencil_texture_, nullptr, &depth_stencil_view_));
 #ifndef NDEBUG
     std::string depth_stencil_view_name = "default_depth_stencil_view";
     depth_stencil_view_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(depth_stencil_view_name.size()), depth_stencil_view_name.c_str());
@@ -333,7 +518,3 @@ Camera* Render::camera() const
     return camera_;
 }
 
-ID3DUserDefinedAnnotation* Render::user_defined_annotation() const
-{
-    return user_defined_annotation_;
-}
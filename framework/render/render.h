@@ -7,19 +7,39 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <memory>
 #include <SimpleMath.h>
 using namespace DirectX::SimpleMath;
 
 class GameComponent;
 class Camera;
+class RenderBackend;
+class StateCache;
+class ConstantRing;
+class GeometryPool;
+class StateObjects;
+class CommandLists;
+class ResourceManager;
+class TextureCache;
+class ShaderCache;
+class ShaderCompiler;
+class ShaderHotReload;
 
 class Render
 {
 private:
-    // main D3D11 units
-    Microsoft::WRL::ComPtr<ID3D11Device> device_{ nullptr };
-    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context_{ nullptr };
-    Microsoft::WRL::ComPtr<IDXGISwapChain> swapchain_{ nullptr };
+    // all device and context calls go through backend, state calls are filtered by cache
+    std::unique_ptr<StateCache> backend_;
+    std::unique_ptr<ConstantRing> constant_ring_; // per-draw constants of the frame
+    std::unique_ptr<GeometryPool> geometry_pool_; // vertices and indices of meshes
+    std::unique_ptr<StateObjects> state_objects_; // sampler, rasterizer, blend and depth stencil states
+    std::unique_ptr<CommandLists> command_lists_; // parallel recording of draws
+    std::unique_ptr<ResourceManager> resources_; // textures, materials and meshes by handle
+    std::unique_ptr<TextureCache> texture_cache_; // textures shared by file and contents
+    std::unique_ptr<ShaderCache> shader_cache_; // compiled shaders, persistent between runs
+    std::unique_ptr<ShaderCompiler> shader_compiler_; // shader compilation on workers
+    std::unique_ptr<ShaderHotReload> shader_hot_reload_; // recompiles shaders changed on disk
+    Microsoft::WRL::ComPtr<IDXGISwapChain> swapchain_{ nullptr }; // nullptr when headless
 
     constexpr static uint32_t swapchain_buffer_count_{ 2 };
 
@@ -32,6 +52,7 @@ private:
     ID3D11DepthStencilView* depth_stencil_view_{ nullptr };
     ID3D11DepthStencilState* depth_stencil_state_{ nullptr };
 
+    void create_depth_stencil_state();
     void create_render_target_view();
     void destroy_render_target_view();
     void create_depth_stencil_texture_and_view();
@@ -39,16 +60,19 @@ private:
 
     Camera* camera_{ nullptr };
 
-    ID3DUserDefinedAnnotation* user_defined_annotation_{ nullptr };
-
 public:
-    Render() = default;
-    ~Render() = default;
+    Render();
+    ~Render();
 
     void initialize();
+    // null backend without window and swapchain, backbuffer is an offscreen texture
+    void initialize_headless();
     void resize();
     void fullscreen(bool);
 
+    // simulation side: move camera by input
+    void update_camera();
+
     void prepare_frame();
     void prepare_resources() const;
 
@@ -60,10 +84,25 @@ public:
 
     void destroy_resources();
 
+    // context of calling thread: deferred context of command list recorded on it, immediate otherwise
+    RenderBackend* backend() const;
+    StateCache* state_cache() const;
+    ConstantRing* constant_ring() const;
+    GeometryPool* geometry_pool() const;
+    StateObjects* state_objects() const;
+    CommandLists* command_lists() const;
+    ResourceManager* resources() const;
+    TextureCache* texture_cache() const;
+    ShaderCache* shader_cache() const;
+    ShaderCompiler* shader_compiler() const;
+    ShaderHotReload* shader_hot_reload() const;
+
+    // CommandList::begin / end, nullptr - immediate context
+    static void set_thread_context(RenderBackend* context);
+
+    // native objects, nullptr when headless
     ID3D11Device* device() const;
     ID3D11DeviceContext* context() const;
 
     Camera* camera() const;
-
-    ID3DUserDefinedAnnotation* user_defined_annotation() const;
 };
@@ -2,8 +2,20 @@
 #include "render/d3d11_common.h"
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <d3d11_1.h>
+
+namespace
+{
+std::atomic<uint64_t> upload_updated_bytes{ 0 };
+std::atomic<uint64_t> upload_uploaded_bytes{ 0 };
+std::atomic<uint64_t> upload_updates{ 0 };
+std::atomic<uint64_t> upload_range_updates{ 0 };
+}
 
 Buffer::Buffer()
 {
@@ -39,8 +51,8 @@ void Buffer::initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT stride, UIN
     subresource_data_.SysMemPitch = 0;
     subresource_data_.SysMemSlicePitch = 0;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateBuffer(&buffer_desc_, &subresource_data_, &resource_));
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_buffer(&buffer_desc_, &subresource_data_, &resource_));
 
     // create shader resource view
     if (bind_flags == D3D11_BIND_SHADER_RESOURCE)
@@ -51,7 +63,7 @@ void Buffer::initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT stride, UIN
         resource_view_desc.BufferEx.Flags = 0;
         resource_view_desc.Format = DXGI_FORMAT_UNKNOWN;
         resource_view_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
-        D3D11_CHECK(device->CreateShaderResourceView(resource_, &resource_view_desc, &resource_view_));
+        D3D11_CHECK(backend->create_shader_resource_view(resource_, &resource_view_desc, &resource_view_));
     }
 }
 
@@ -64,31 +76,31 @@ void Buffer::set_name(const std::string& name)
 void Buffer::bind(UINT slot)
 {
     assert(resource_ != nullptr);
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
 
     if (buffer_desc_.BindFlags == D3D11_BIND_VERTEX_BUFFER)
     {
-        context->IASetVertexBuffers(slot, 1, &resource_, strides_.data(), offsets_.data());
+        backend->ia_set_vertex_buffers(slot, 1, &resource_, strides_.data(), offsets_.data());
     }
     else if (buffer_desc_.BindFlags == D3D11_BIND_INDEX_BUFFER)
     {
         if (strides_[0] == sizeof(uint16_t)) {
-            context->IASetIndexBuffer(resource_, DXGI_FORMAT_R16_UINT, 0);
+            backend->ia_set_index_buffer(resource_, DXGI_FORMAT_R16_UINT, 0);
         } else if (strides_[0] == sizeof(uint32_t)) {
-            context->IASetIndexBuffer(resource_, DXGI_FORMAT_R32_UINT, 0);
+            backend->ia_set_index_buffer(resource_, DXGI_FORMAT_R32_UINT, 0);
         }
     }
     else if (buffer_desc_.BindFlags == D3D11_BIND_CONSTANT_BUFFER)
     {
-        context->VSSetConstantBuffers(slot, 1, &resource_);
-        context->PSSetConstantBuffers(slot, 1, &resource_);
-        context->GSSetConstantBuffers(slot, 1, &resource_);
+        backend->vs_set_constant_buffers(slot, 1, &resource_);
+        backend->ps_set_constant_buffers(slot, 1, &resource_);
+        backend->gs_set_constant_buffers(slot, 1, &resource_);
     }
     else if (buffer_desc_.BindFlags == D3D11_BIND_SHADER_RESOURCE)
     {
-        context->VSSetShaderResources(slot, 1, &resource_view_);
-        context->PSSetShaderResources(slot, 1, &resource_view_);
-        context->GSSetShaderResources(slot, 1, &resource_view_);
+        backend->vs_set_shader_resources(slot, 1, &resource_view_);
+        backend->ps_set_shader_resources(slot, 1, &resource_view_);
+        backend->gs_set_shader_resources(slot, 1, &resource_view_);
     }
 }
 
@@ -103,7 +115,7 @@ UINT Buffer::count() const
     return buffer_desc_.ByteWidth / strides_[0];
 }
 
-void ConstBuffer::initialize(UINT size, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG cpu_access)
+void ConstBuffer::initialize(UINT size, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG cpu_access, const void* data)
 {
     buffer_desc_.Usage = usage;
     buffer_desc_.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
@@ -113,21 +125,41 @@ void ConstBuffer::initialize(UINT size, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG
     buffer_desc_.ByteWidth = size;
     assert(size >= 16);
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateBuffer(&buffer_desc_, nullptr, &resource_));
+    subresource_data_.pSysMem = data;
+    subresource_data_.SysMemPitch = 0;
+    subresource_data_.SysMemSlicePitch = 0;
+
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_buffer(&buffer_desc_, data != nullptr ? &subresource_data_ : nullptr, &resource_));
 }
 
-void ConstBuffer::update_data(void* data)
+void ConstBuffer::update_data(const void* data)
 {
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
     D3D11_MAPPED_SUBRESOURCE mss;
-    context->Map(resource_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mss);
+    backend->map(resource_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mss);
     memcpy(mss.pData, data, buffer_desc_.ByteWidth);
-    context->Unmap(resource_, 0);
+    backend->unmap(resource_, 0);
 }
 
 void StructuredBuffer::initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT stride, UINT count, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG cpu_access)
 {
+    assert(resource_ == nullptr);
+    strides_.assign(1, stride);
+    offsets_.assign(1, 0);
+    contents_.clear();
+    known_bytes_ = 0;
+    dirty_.clear();
+    if (usage == D3D11_USAGE_DEFAULT)
+    {
+        contents_.resize(stride * count);
+        if (data != nullptr)
+        {
+            memcpy(contents_.data(), data, contents_.size());
+            known_bytes_ = UINT(contents_.size());
+        }
+    }
+
     buffer_desc_.Usage = usage;
     buffer_desc_.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     buffer_desc_.CPUAccessFlags = cpu_access;
@@ -139,8 +171,8 @@ void StructuredBuffer::initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT s
     subresource_data_.SysMemPitch = 0;
     subresource_data_.SysMemSlicePitch = 0;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateBuffer(&buffer_desc_, &subresource_data_, &resource_));
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_buffer(&buffer_desc_, data != nullptr ? &subresource_data_ : nullptr, &resource_));
 
     D3D11_SHADER_RESOURCE_VIEW_DESC resource_view_desc;
     resource_view_desc.BufferEx.FirstElement = 0;
@@ -148,14 +180,110 @@ void StructuredBuffer::initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT s
     resource_view_desc.BufferEx.Flags = 0;
     resource_view_desc.Format = DXGI_FORMAT_UNKNOWN;
     resource_view_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
-    D3D11_CHECK(device->CreateShaderResourceView(resource_, &resource_view_desc, &resource_view_));
+    D3D11_CHECK(backend->create_shader_resource_view(resource_, &resource_view_desc, &resource_view_));
 }
 
-void StructuredBuffer::update_data(void* data)
+void StructuredBuffer::update_data(const void* data)
 {
-    auto context = Game::inst()->render().context();
-    D3D11_MAPPED_SUBRESOURCE mss;
-    context->Map(resource_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mss);
-    memcpy(mss.pData, data, buffer_desc_.ByteWidth);
-    context->Unmap(resource_, 0);
+    update_data(data, count());
+}
+
+void StructuredBuffer::update_data(const void* data, UINT count)
+{
+    assert(count <= this->count());
+    const UINT stride = buffer_desc_.StructureByteStride;
+    const UINT size = count * stride;
+    upload_updated_bytes += size;
+    upload_updates++;
+
+    auto backend = Game::inst()->render().backend();
+    if (buffer_desc_.Usage == D3D11_USAGE_DYNAMIC)
+    {
+        D3D11_MAPPED_SUBRESOURCE mss;
+        backend->map(resource_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mss);
+        memcpy(mss.pData, data, size);
+        backend->unmap(resource_, 0);
+        upload_uploaded_bytes += size;
+        return;
+    }
+
+    // elements which differ from cpu copy, everything past known part
+    auto source = static_cast<const uint8_t*>(data);
+    const UINT compared = std::min(size, known_bytes_);
+    for (UINT offset = 0; offset < compared; offset += stride)
+    {
+        if (memcmp(contents_.data() + offset, source + offset, stride) != 0)
+        {
+            memcpy(contents_.data() + offset, source + offset, stride);
+            add_dirty(offset, offset + stride);
+        }
+    }
+    if (size > compared)
+    {
+        memcpy(contents_.data() + compared, source + compared, size - compared);
+        add_dirty(compared, size);
+        known_bytes_ = size;
+    }
+    upload(size);
+}
+
+StructuredBuffer::UploadCounters StructuredBuffer::upload_counters()
+{
+    UploadCounters counters;
+    counters.updated_bytes = upload_updated_bytes.load();
+    counters.uploaded_bytes = upload_uploaded_bytes.load();
+    counters.updates = upload_updates.load();
+    counters.range_updates = upload_range_updates.load();
+    return counters;
+}
+
+void StructuredBuffer::reset_upload_counters()
+{
+    upload_updated_bytes = 0;
+    upload_uploaded_bytes = 0;
+    upload_updates = 0;
+    upload_range_updates = 0;
+}
+
+void StructuredBuffer::add_dirty(UINT begin, UINT end)
+{
+    // updates go from low to high offsets
+    if (!dirty_.empty() && begin <= dirty_.back().end + merge_gap)
+    {
+        dirty_.back().end = std::max(dirty_.back().end, end);
+        return;
+    }
+    dirty_.push_back(ByteRange{ begin, end });
+}
+
+void StructuredBuffer::upload(UINT size)
+{
+    if (dirty_.empty()) {
+        return;
+    }
+
+    UINT dirty_bytes = 0;
+    for (const auto& range : dirty_) {
+        dirty_bytes += range.end - range.begin;
+    }
+
+    auto backend = Game::inst()->render().backend();
+    if (dirty_bytes * 2 >= size || dirty_.size() > max_dirty_ranges)
+    {
+        // most of it changed: rename buffer instead of waiting for draws which read it
+        D3D11_BOX box{ 0, 0, 0, known_bytes_, 1, 1 };
+        backend->update_subresource1(resource_, 0, &box, contents_.data(), 0, 0, D3D11_COPY_DISCARD);
+        upload_uploaded_bytes += known_bytes_;
+    }
+    else
+    {
+        for (const auto& range : dirty_)
+        {
+            D3D11_BOX box{ range.begin, 0, 0, range.end, 1, 1 };
+            backend->update_subresource1(resource_, 0, &box, contents_.data() + range.begin, 0, 0, 0);
+        }
+        upload_uploaded_bytes += dirty_bytes;
+        upload_range_updates += dirty_.size();
+    }
+    dirty_.clear();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <d3d11.h>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -32,14 +33,50 @@ class ConstBuffer : public Buffer
 {
 public:
     ConstBuffer() = default;
-    void initialize(UINT size, D3D11_USAGE usage = D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_FLAG cpu_access = D3D11_CPU_ACCESS_WRITE);
-    void update_data(void* data);
+    // immutable buffers need data, per-draw data goes to ConstantRing
+    void initialize(UINT size, D3D11_USAGE usage = D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_FLAG cpu_access = D3D11_CPU_ACCESS_WRITE, const void* data = nullptr);
+    void update_data(const void* data);
 };
 
+// Dynamic buffers are rewritten with map discard on every update.
+// Default usage buffers keep cpu copy of contents: update sends only elements which differ
+// from the copy (UpdateSubresource1 with boxes), or whole written part with copy discard
+// when most of it changed.
 class StructuredBuffer : public Buffer
 {
 public:
+    // all structured buffers, since last reset
+    struct UploadCounters
+    {
+        uint64_t updated_bytes;  // passed to update_data
+        uint64_t uploaded_bytes; // sent to GPU
+        uint64_t updates;        // update_data calls
+        uint64_t range_updates;  // partial uploads
+    };
+
+    constexpr static UINT merge_gap = 256;      // dirty ranges closer than this are uploaded as one
+    constexpr static UINT max_dirty_ranges = 32;
+
     StructuredBuffer() = default;
     void initialize(D3D11_BIND_FLAG bind_flags, void* data, UINT stride, UINT count, D3D11_USAGE usage = D3D11_USAGE_DEFAULT, D3D11_CPU_ACCESS_FLAG cpu_access = (D3D11_CPU_ACCESS_FLAG)0);
-    void update_data(void* data);
+    void update_data(const void* data);
+    // first count elements; rest is undefined for dynamic buffers and keeps old contents for default ones
+    void update_data(const void* data, UINT count);
+
+    static UploadCounters upload_counters();
+    static void reset_upload_counters();
+
+private:
+    struct ByteRange
+    {
+        UINT begin;
+        UINT end;
+    };
+
+    void add_dirty(UINT begin, UINT end);
+    void upload(UINT size);
+
+    std::vector<uint8_t> contents_; // default usage: cpu copy
+    UINT known_bytes_{ 0 };         // [0, known_bytes_) of GPU buffer matches contents_
+    std::vector<ByteRange> dirty_;  // sorted, disjoint
 };
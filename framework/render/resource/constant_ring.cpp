@@ -0,0 +1,178 @@
+#include <cassert>
+#include <cstring>
+
+#include "core/game.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/d3d11_common.h"
+#include "constant_ring.h"
+
+namespace
+{
+ID3D11Buffer* create_dynamic_buffer(UINT size)
+{
+    D3D11_BUFFER_DESC desc{};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.ByteWidth = size;
+
+    ID3D11Buffer* buffer = nullptr;
+    D3D11_CHECK(Game::inst()->render().backend()->create_buffer(&desc, nullptr, &buffer));
+    return buffer;
+}
+}
+
+ConstantRing::ConstantRing()
+{
+}
+
+ConstantRing::~ConstantRing()
+{
+    assert(pages_.empty());
+}
+
+void ConstantRing::initialize()
+{
+    offsets_supported_ = Game::inst()->render().backend()->supports_constant_buffer_offsets();
+    add_page();
+}
+
+void ConstantRing::destroy()
+{
+    for (auto& page : pages_) {
+        SAFE_RELEASE(page.buffer);
+    }
+    pages_.clear();
+    for (auto& buffer : slot_buffers_) {
+        SAFE_RELEASE(buffer);
+    }
+    slot_buffers_.clear();
+}
+
+void ConstantRing::begin_frame()
+{
+    for (auto& page : pages_) {
+        page.used = 0;
+        page.uploaded = 0;
+    }
+    current_page_ = 0;
+    frame_++;
+    map_count_ = 0;
+}
+
+ConstantRing::Allocation ConstantRing::write(const void* data, UINT size)
+{
+    assert(size > 0 && size <= page_size);
+    UINT aligned_size = (size + alignment - 1) & ~(alignment - 1);
+
+    if (pages_[current_page_].used + aligned_size > page_size)
+    {
+        // page is full: next one, pages stay for next frames
+        current_page_++;
+        if (current_page_ == pages_.size()) {
+            add_page();
+        }
+    }
+
+    Page& page = pages_[current_page_];
+    std::memcpy(page.data.data() + page.used, data, size);
+
+    Allocation allocation;
+    allocation.frame = frame_;
+    allocation.page = current_page_;
+    allocation.first_constant = page.used / 16;
+    allocation.constant_count = aligned_size / 16;
+    allocation.size = size;
+    page.used += aligned_size;
+    return allocation;
+}
+
+void ConstantRing::flush()
+{
+    if (!offsets_supported_) {
+        return;
+    }
+    for (uint32_t i = 0; i <= current_page_; ++i) {
+        if (pages_[i].uploaded < pages_[i].used) {
+            upload(pages_[i]);
+        }
+    }
+}
+
+bool ConstantRing::valid(const Allocation& allocation) const
+{
+    return allocation.frame == frame_;
+}
+
+void ConstantRing::bind(const Allocation& allocation, UINT slot)
+{
+    assert(valid(allocation));
+    if (!offsets_supported_) {
+        bind_fallback(allocation, slot);
+        return;
+    }
+
+    Page& page = pages_[allocation.page];
+    if ((allocation.first_constant + allocation.constant_count) * 16 > page.uploaded) {
+        upload(page);
+    }
+
+    auto backend = Game::inst()->render().backend();
+    backend->vs_set_constant_buffers1(slot, 1, &page.buffer, &allocation.first_constant, &allocation.constant_count);
+    backend->ps_set_constant_buffers1(slot, 1, &page.buffer, &allocation.first_constant, &allocation.constant_count);
+    backend->gs_set_constant_buffers1(slot, 1, &page.buffer, &allocation.first_constant, &allocation.constant_count);
+}
+
+uint32_t ConstantRing::page_count() const
+{
+    return uint32_t(pages_.size());
+}
+
+uint32_t ConstantRing::map_count() const
+{
+    return map_count_;
+}
+
+void ConstantRing::add_page()
+{
+    Page page;
+    page.buffer = create_dynamic_buffer(page_size);
+    page.data.resize(page_size);
+    pages_.push_back(std::move(page));
+}
+
+void ConstantRing::upload(Page& page)
+{
+    // discard renames the buffer: draws issued before keep old contents,
+    // so whole written range is copied again
+    auto backend = Game::inst()->render().backend();
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    D3D11_CHECK(backend->map(page.buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    std::memcpy(mapped.pData, page.data.data(), page.used);
+    backend->unmap(page.buffer, 0);
+    page.uploaded = page.used;
+    map_count_++;
+}
+
+void ConstantRing::bind_fallback(const Allocation& allocation, UINT slot)
+{
+    if (slot >= slot_buffers_.size()) {
+        slot_buffers_.resize(slot + 1, nullptr);
+    }
+    if (slot_buffers_[slot] == nullptr) {
+        slot_buffers_[slot] = create_dynamic_buffer(page_size);
+    }
+
+    const Page& page = pages_[allocation.page];
+    auto backend = Game::inst()->render().backend();
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    D3D11_CHECK(backend->map(slot_buffers_[slot], 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    std::memcpy(mapped.pData, page.data.data() + allocation.first_constant * 16, allocation.size);
+    backend->unmap(slot_buffers_[slot], 0);
+    map_count_++;
+
+    backend->vs_set_constant_buffers(slot, 1, &slot_buffers_[slot]);
+    backend->ps_set_constant_buffers(slot, 1, &slot_buffers_[slot]);
+    backend->gs_set_constant_buffers(slot, 1, &slot_buffers_[slot]);
+}
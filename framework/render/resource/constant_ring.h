@@ -0,0 +1,73 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+
+// Per frame upload ring for constant data.
+// Objects write their per-draw constants into 256 byte aligned slices of a few big
+// dynamic buffers and bind slices with *SetConstantBuffers1 offsets. Writes go to a cpu
+// copy, the buffer is mapped once when a slice written after last upload is bound,
+// so a frame which writes everything before drawing maps every page once.
+// Allocations are valid until next begin_frame().
+class ConstantRing final
+{
+public:
+    struct Allocation
+    {
+        uint64_t frame{ 0 };        // 0 - never written
+        uint32_t page{ 0 };
+        UINT first_constant{ 0 };   // 16 byte shader constants
+        UINT constant_count{ 0 };
+        UINT size{ 0 };             // bytes of data
+    };
+
+    constexpr static UINT alignment = 256;              // offsets must be multiple of 16 constants
+    constexpr static UINT page_size = 64 * 1024;        // max range of one binding (4096 constants)
+
+    ConstantRing();
+    ~ConstantRing();
+
+    ConstantRing(const ConstantRing&) = delete;
+    ConstantRing& operator=(const ConstantRing&) = delete;
+
+    void initialize();
+    void destroy();
+
+    // drops allocations of previous frame
+    void begin_frame();
+
+    Allocation write(const void* data, UINT size);
+    // uploads everything written so far: binds of these allocations do not map,
+    // so command lists can bind them on other threads while nobody writes
+    void flush();
+    // written in current frame
+    bool valid(const Allocation& allocation) const;
+    // to vs, gs and ps like ConstBuffer::bind
+    void bind(const Allocation& allocation, UINT slot);
+
+    uint32_t page_count() const;
+    uint32_t map_count() const; // maps in current frame
+
+private:
+    struct Page
+    {
+        ID3D11Buffer* buffer{ nullptr };
+        std::vector<uint8_t> data; // cpu copy of the frame
+        UINT used{ 0 };
+        UINT uploaded{ 0 };
+    };
+
+    void add_page();
+    void upload(Page& page);
+    void bind_fallback(const Allocation& allocation, UINT slot);
+
+    std::vector<Page> pages_;
+    uint32_t current_page_{ 0 };
+    uint64_t frame_{ 1 };
+    uint32_t map_count_{ 0 };
+
+    // without D3D11.1 offsets: one buffer per slot, mapped on every bind
+    bool offsets_supported_{ false };
+    std::vector<ID3D11Buffer*> slot_buffers_;
+};
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#include "core/game.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/d3d11_common.h"
+#include "geometry_pool.h"
+
+// FreeList
+void GeometryPool::FreeList::reset(UINT capacity)
+{
+    ranges_.assign(1, FreeRange{ 0, capacity });
+    capacity_ = capacity;
+    free_ = capacity;
+}
+
+bool GeometryPool::FreeList::allocate(UINT count, UINT& offset)
+{
+    if (count == 0) {
+        offset = 0;
+        return true;
+    }
+    for (auto it = ranges_.begin(); it != ranges_.end(); ++it)
+    {
+        if (it->count < count) {
+            continue;
+        }
+        offset = it->offset;
+        it->offset += count;
+        it->count -= count;
+        if (it->count == 0) {
+            ranges_.erase(it);
+        }
+        free_ -= count;
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::FreeList::free(UINT offset, UINT count)
+{
+    if (count == 0) {
+        return;
+    }
+    auto next = std::lower_bound(ranges_.begin(), ranges_.end(), offset,
+                                 [](const FreeRange& range, UINT value) { return range.offset < value; });
+    // merge with neighbours
+    bool merge_prev = next != ranges_.begin() && std::prev(next)->offset + std::prev(next)->count == offset;
+    bool merge_next = next != ranges_.end() && offset + count == next->offset;
+    if (merge_prev && merge_next)
+    {
+        std::prev(next)->count += count + next->count;
+        ranges_.erase(next);
+    }
+    else if (merge_prev)
+    {
+        std::prev(next)->count += count;
+    }
+    else if (merge_next)
+    {
+        next->offset = offset;
+        next->count += count;
+    }
+    else
+    {
+        ranges_.insert(next, FreeRange{ offset, count });
+    }
+    free_ += count;
+}
+
+UINT GeometryPool::FreeList::capacity() const
+{
+    return capacity_;
+}
+
+UINT GeometryPool::FreeList::used() const
+{
+    return capacity_ - free_;
+}
+
+UINT GeometryPool::FreeList::holes() const
+{
+    if (!ranges_.empty() && ranges_.back().offset + ranges_.back().count == capacity_) {
+        return free_ - ranges_.back().count;
+    }
+    return free_;
+}
+
+// GeometryPool
+GeometryPool::GeometryPool()
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+    assert(pages_.empty());
+}
+
+void GeometryPool::initialize(UINT vertex_stride)
+{
+    vertex_stride_ = vertex_stride;
+}
+
+void GeometryPool::destroy()
+{
+    for (auto& page : pages_)
+    {
+        SAFE_RELEASE(page.vertex_buffer);
+        SAFE_RELEASE(page.index_buffer);
+    }
+    pages_.clear();
+    ranges_.clear();
+    live_.clear();
+    free_handles_.clear();
+    fragmented_ = false;
+}
+
+GeometryPool::Handle GeometryPool::allocate(const void* vertices, UINT vertex_count, const uint32_t* indices, UINT index_count)
+{
+    assert(vertex_stride_ > 0);
+
+    Range range{};
+    uint32_t page_index = 0;
+    for (; page_index < pages_.size(); ++page_index)
+    {
+        Page& page = pages_[page_index];
+        if (!page.vertices.allocate(vertex_count, range.base_vertex)) {
+            continue;
+        }
+        if (!page.indices.allocate(index_count, range.first_index)) {
+            page.vertices.free(range.base_vertex, vertex_count);
+            continue;
+        }
+        break;
+    }
+    if (page_index == pages_.size())
+    {
+        add_page(std::max(vertex_count, page_vertex_count), std::max(index_count, page_index_count));
+        pages_.back().vertices.allocate(vertex_count, range.base_vertex);
+        pages_.back().indices.allocate(index_count, range.first_index);
+    }
+    range.page = page_index;
+    range.vertex_count = vertex_count;
+    range.index_count = index_count;
+
+    auto backend = Game::inst()->render().backend();
+    const Page& page = pages_[page_index];
+    if (vertex_count > 0)
+    {
+        D3D11_BOX box{ range.base_vertex * vertex_stride_, 0, 0, (range.base_vertex + vertex_count) * vertex_stride_, 1, 1 };
+        backend->update_subresource(page.vertex_buffer, 0, &box, vertices, 0, 0);
+    }
+    if (index_count > 0)
+    {
+        D3D11_BOX box{ UINT(range.first_index * sizeof(uint32_t)), 0, 0, UINT((range.first_index + index_count) * sizeof(uint32_t)), 1, 1 };
+        backend->update_subresource(page.index_buffer, 0, &box, indices, 0, 0);
+    }
+
+    Handle handle;
+    if (!free_handles_.empty())
+    {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+        ranges_[handle] = range;
+        live_[handle] = true;
+    }
+    else
+    {
+        handle = Handle(ranges_.size());
+        ranges_.push_back(range);
+        live_.push_back(true);
+    }
+    return handle;
+}
+
+void GeometryPool::free(Handle handle)
+{
+    assert(handle < ranges_.size() && live_[handle]);
+    const Range& range = ranges_[handle];
+    Page& page = pages_[range.page];
+    page.vertices.free(range.base_vertex, range.vertex_count);
+    page.indices.free(range.first_index, range.index_count);
+    live_[handle] = false;
+    free_handles_.push_back(handle);
+    fragmented_ = true;
+}
+
+const GeometryPool::Range& GeometryPool::range(Handle handle) const
+{
+    assert(handle < ranges_.size() && live_[handle]);
+    return ranges_[handle];
+}
+
+void GeometryPool::bind(Handle handle) const
+{
+    const Page& page = pages_[range(handle).page];
+    auto backend = Game::inst()->render().backend();
+    UINT offset = 0;
+    backend->ia_set_vertex_buffers(0, 1, &page.vertex_buffer, &vertex_stride_, &offset);
+    backend->ia_set_index_buffer(page.index_buffer, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void GeometryPool::defragment()
+{
+    if (!fragmented_) {
+        return;
+    }
+    fragmented_ = false;
+
+    for (uint32_t page_index = 0; page_index < pages_.size();)
+    {
+        Page& page = pages_[page_index];
+        if (page.vertices.used() == 0 && page.indices.used() == 0)
+        {
+            SAFE_RELEASE(page.vertex_buffer);
+            SAFE_RELEASE(page.index_buffer);
+            pages_.erase(pages_.begin() + page_index);
+            for (size_t handle = 0; handle < ranges_.size(); ++handle) {
+                if (live_[handle] && ranges_[handle].page > page_index) {
+                    ranges_[handle].page--;
+                }
+            }
+            continue;
+        }
+        if (page.vertices.holes() * 4 >= page.vertices.capacity() || page.indices.holes() * 4 >= page.indices.capacity()) {
+            pack(page_index);
+        }
+        ++page_index;
+    }
+}
+
+uint32_t GeometryPool::page_count() const
+{
+    return uint32_t(pages_.size());
+}
+
+size_t GeometryPool::used_bytes() const
+{
+    size_t bytes = 0;
+    for (const auto& page : pages_) {
+        bytes += size_t(page.vertices.used()) * vertex_stride_ + size_t(page.indices.used()) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+size_t GeometryPool::capacity_bytes() const
+{
+    size_t bytes = 0;
+    for (const auto& page : pages_) {
+        bytes += size_t(page.vertices.capacity()) * vertex_stride_ + size_t(page.indices.capacity()) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void GeometryPool::add_page(UINT vertex_count, UINT index_count)
+{
+    Page page;
+    page.vertices.reset(vertex_count);
+    page.indices.reset(index_count);
+    create_buffers(page);
+    pages_.push_back(std::move(page));
+}
+
+void GeometryPool::create_buffers(Page& page)
+{
+    auto backend = Game::inst()->render().backend();
+
+    D3D11_BUFFER_DESC desc{};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.ByteWidth = page.vertices.capacity() * vertex_stride_;
+    D3D11_CHECK(backend->create_buffer(&desc, nullptr, &page.vertex_buffer));
+
+    desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    desc.ByteWidth = page.indices.capacity() * sizeof(uint32_t);
+    D3D11_CHECK(backend->create_buffer(&desc, nullptr, &page.index_buffer));
+
+#ifndef NDEBUG
+    std::string vertex_name = "geometry_pool_vertices";
+    std::string index_name = "geometry_pool_indices";
+    page.vertex_buffer->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(vertex_name.size()), vertex_name.c_str());
+    page.index_buffer->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(index_name.size()), index_name.c_str());
+#endif
+}
+
+void GeometryPool::pack(uint32_t page_index)
+{
+    // copy live ranges in offset order to the start of new buffers:
+    // source and destination of CopySubresourceRegion must not overlap
+    Page& page = pages_[page_index];
+    Page packed;
+    packed.vertices.reset(page.vertices.capacity());
+    packed.indices.reset(page.indices.capacity());
+    create_buffers(packed);
+
+    std::vector<Handle> handles;
+    for (Handle handle = 0; handle < ranges_.size(); ++handle) {
+        if (live_[handle] && ranges_[handle].page == page_index) {
+            handles.push_back(handle);
+        }
+    }
+
+    auto backend = Game::inst()->render().backend();
+    std::sort(handles.begin(), handles.end(),
+              [this](Handle a, Handle b) { return ranges_[a].base_vertex < ranges_[b].base_vertex; });
+    for (Handle handle : handles)
+    {
+        Range& range = ranges_[handle];
+        UINT base_vertex = 0;
+        packed.vertices.allocate(range.vertex_count, base_vertex);
+        if (range.vertex_count > 0)
+        {
+            D3D11_BOX box{ range.base_vertex * vertex_stride_, 0, 0, (range.base_vertex + range.vertex_count) * vertex_stride_, 1, 1 };
+            backend->copy_subresource_region(packed.vertex_buffer, 0, base_vertex * vertex_stride_, 0, 0, page.vertex_buffer, 0, &box);
+        }
+        range.base_vertex = base_vertex;
+    }
+
+    std::sort(handles.begin(), handles.end(),
+              [this](Handle a, Handle b) { return ranges_[a].first_index < ranges_[b].first_index; });
+    for (Handle handle : handles)
+    {
+        Range& range = ranges_[handle];
+        UINT first_index = 0;
+        packed.indices.allocate(range.index_count, first_index);
+        if (range.index_count > 0)
+        {
+            D3D11_BOX box{ UINT(range.first_index * sizeof(uint32_t)), 0, 0, UINT((range.first_index + range.index_count) * sizeof(uint32_t)), 1, 1 };
+            backend->copy_subresource_region(packed.index_buffer, 0, UINT(first_index * sizeof(uint32_t)), 0, 0, page.index_buffer, 0, &box);
+        }
+        range.first_index = first_index;
+    }
+
+    SAFE_RELEASE(page.vertex_buffer);
+    SAFE_RELEASE(page.index_buffer);
+    page = std::move(packed);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+
+// Vertices and indices of all meshes in a few big buffers.
+// Every page is a vertex buffer and an index buffer, both suballocated with first fit
+// free lists. Meshes keep a handle and draw with DrawIndexed(count, first_index, base_vertex),
+// so meshes of one page share vertex and index buffer bindings.
+// Freed ranges merge with their neighbours; defragment() packs fragmented pages and
+// releases empty ones, ranges of live handles move then.
+// Render thread only.
+class GeometryPool final
+{
+public:
+    using Handle = uint32_t;
+    constexpr static Handle invalid_handle = ~0u;
+
+    constexpr static UINT page_vertex_count = 1 << 18;  // 8 Mb of 32 byte vertices
+    constexpr static UINT page_index_count = 1 << 20;   // 4 Mb of 32 bit indices
+
+    struct Range
+    {
+        uint32_t page;
+        UINT base_vertex;
+        UINT vertex_count;
+        UINT first_index;
+        UINT index_count;
+    };
+
+    GeometryPool();
+    ~GeometryPool();
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    void initialize(UINT vertex_stride);
+    void destroy();
+
+    // meshes bigger than page get their own page
+    Handle allocate(const void* vertices, UINT vertex_count, const uint32_t* indices, UINT index_count);
+    void free(Handle handle);
+
+    const Range& range(Handle handle) const;
+    // vertex buffer to slot 0 and index buffer of handle's page
+    void bind(Handle handle) const;
+
+    // packs pages whose holes reach 1/4 of capacity, releases empty pages
+    void defragment();
+
+    uint32_t page_count() const;
+    size_t used_bytes() const;
+    size_t capacity_bytes() const;
+
+private:
+    struct FreeRange
+    {
+        UINT offset;
+        UINT count;
+    };
+
+    // first fit, sorted by offset
+    class FreeList
+    {
+    public:
+        void reset(UINT capacity);
+        bool allocate(UINT count, UINT& offset);
+        void free(UINT offset, UINT count);
+        UINT capacity() const;
+        UINT used() const;
+        UINT holes() const; // free elements before the last used one
+    private:
+        std::vector<FreeRange> ranges_;
+        UINT capacity_{ 0 };
+        UINT free_{ 0 };
+    };
+
+    struct Page
+    {
+        ID3D11Buffer* vertex_buffer{ nullptr };
+        ID3D11Buffer* index_buffer{ nullptr };
+        FreeList vertices;
+        FreeList indices;
+    };
+
+    void add_page(UINT vertex_count, UINT index_count);
+    void create_buffers(Page& page);
+    void pack(uint32_t page);
+
+    UINT vertex_stride_{ 0 };
+    std::vector<Page> pages_;
+
+    std::vector<Range> ranges_;          // by handle
+    std::vector<bool> live_;
+    std::vector<Handle> free_handles_;
+    bool fragmented_{ false };
+};
@@ -0,0 +1,82 @@
+#include <cassert>
+
+#include "core/game.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/d3d11_common.h"
+#include "shader.h"
+#include "state_objects.h"
+#include "pipeline_state.h"
+
+std::atomic<uint32_t> PipelineState::next_id_{ 0 };
+
+PipelineState::PipelineState() : id_{ next_id_++ }
+{
+}
+
+PipelineState::~PipelineState()
+{
+    assert(shader_ == nullptr);
+}
+
+void PipelineState::initialize(const Desc& desc)
+{
+    assert(shader_ == nullptr && desc.shader != nullptr);
+    shader_ = desc.shader;
+    topology_ = desc.topology;
+    stencil_ref_ = desc.stencil_ref;
+
+    auto state_objects = Game::inst()->render().state_objects();
+    if (desc.rasterizer != nullptr) {
+        D3D11_CHECK(state_objects->rasterizer_state(desc.rasterizer, &rasterizer_state_));
+    }
+    if (desc.blend != nullptr) {
+        D3D11_CHECK(state_objects->blend_state(desc.blend, &blend_state_));
+    }
+    if (desc.depth_stencil != nullptr) {
+        D3D11_CHECK(state_objects->depth_stencil_state(desc.depth_stencil, &depth_stencil_state_));
+    }
+}
+
+void PipelineState::destroy()
+{
+    shader_ = nullptr;
+    SAFE_RELEASE(rasterizer_state_);
+    SAFE_RELEASE(blend_state_);
+    SAFE_RELEASE(depth_stencil_state_);
+}
+
+void PipelineState::apply(const PipelineState* previous) const
+{
+    assert(shader_ != nullptr);
+    if (previous == this) {
+        return;
+    }
+
+    auto backend = Game::inst()->render().backend();
+    if (previous == nullptr || previous->shader_ != shader_) {
+        shader_->use();
+    }
+    if (previous == nullptr || previous->topology_ != topology_) {
+        backend->ia_set_primitive_topology(topology_);
+    }
+    if (previous == nullptr || previous->rasterizer_state_ != rasterizer_state_) {
+        backend->rs_set_state(rasterizer_state_);
+    }
+    if (previous == nullptr || previous->blend_state_ != blend_state_) {
+        backend->om_set_blend_state(blend_state_, nullptr, 0xFFFFFFFF);
+    }
+    if (previous == nullptr || previous->depth_stencil_state_ != depth_stencil_state_ || previous->stencil_ref_ != stencil_ref_) {
+        backend->om_set_depth_stencil_state(depth_stencil_state_, stencil_ref_);
+    }
+}
+
+uint32_t PipelineState::id() const
+{
+    return id_;
+}
+
+Shader* PipelineState::shader() const
+{
+    return shader_;
+}
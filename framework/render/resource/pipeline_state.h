@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <d3d11.h>
+
+class Shader;
+
+// Immutable draw setup: shader stages with input layout, primitive topology, rasterizer,
+// blend and depth stencil state. State objects come from StateObjects, so pipelines
+// with equal descriptors share them.
+// apply() binds only parts which differ from previously applied pipeline, id() is compact
+// and small enough for sort keys.
+class PipelineState final
+{
+public:
+    struct Desc
+    {
+        Shader* shader{ nullptr };
+        D3D11_PRIMITIVE_TOPOLOGY topology{ D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST };
+        // nullptr - default state
+        const D3D11_RASTERIZER_DESC* rasterizer{ nullptr };
+        const D3D11_BLEND_DESC* blend{ nullptr };
+        const D3D11_DEPTH_STENCIL_DESC* depth_stencil{ nullptr };
+        UINT stencil_ref{ 0 };
+    };
+
+    PipelineState();
+    ~PipelineState();
+
+    PipelineState(const PipelineState&) = delete;
+    PipelineState& operator=(const PipelineState&) = delete;
+
+    void initialize(const Desc& desc);
+    void destroy();
+
+    // previous - pipeline applied last with no state changes after it, nullptr binds everything
+    void apply(const PipelineState* previous = nullptr) const;
+
+    uint32_t id() const;
+    Shader* shader() const;
+
+private:
+    Shader* shader_{ nullptr };
+    D3D11_PRIMITIVE_TOPOLOGY topology_{ D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED };
+    ID3D11RasterizerState* rasterizer_state_{ nullptr };
+    ID3D11BlendState* blend_state_{ nullptr };
+    ID3D11DepthStencilState* depth_stencil_state_{ nullptr };
+    UINT stencil_ref_{ 0 };
+
+    const uint32_t id_;
+    static std::atomic<uint32_t> next_id_;
+};
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <Windows.h>
+
+#include "core/profiler.h"
+#include "resource_manager.h"
+
+Resource::Resource(ResourceCategory category) : category_{ category }
+{
+}
+
+void Resource::set_resident_bytes(size_t bytes)
+{
+    if (bytes == resident_bytes_) {
+        return;
+    }
+    if (manager_ != nullptr) {
+        manager_->account(category_, resident_bytes_, bytes);
+    }
+    resident_bytes_ = bytes;
+}
+
+ResourceManager::ResourceManager()
+{
+}
+
+ResourceManager::~ResourceManager()
+{
+    assert(alive_ == 0 && released_.empty());
+}
+
+void ResourceManager::initialize(uint32_t capacity)
+{
+    assert(slots_ == nullptr);
+    assert(capacity > 0 && capacity - 1 <= ResourceHandle::index_mask);
+    slots_ = std::make_unique<Slot[]>(capacity);
+    capacity_ = capacity;
+    used_ = 0;
+    frame_ = 0;
+}
+
+void ResourceManager::destroy()
+{
+    std::vector<uint32_t> indices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // references between destroyed resources are dropped with them
+        destroying_ = true;
+        for (uint32_t i = 0; i < used_; ++i)
+        {
+            if (slots_[i].resource != nullptr) {
+                slots_[i].generation.store(0, std::memory_order_release);
+                indices.push_back(i);
+            }
+        }
+        released_.clear();
+        alive_ = 0;
+    }
+    for (uint32_t index : indices) {
+        destroy_slot(index);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.reset();
+    free_slots_.clear();
+    capacity_ = 0;
+    used_ = 0;
+    destroying_ = false;
+}
+
+ResourceHandle ResourceManager::add(std::unique_ptr<Resource> resource)
+{
+    assert(resource != nullptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint32_t index;
+    if (!free_slots_.empty()) {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        if (used_ == capacity_) {
+            OutputDebugString("ResourceManager: out of slots\n");
+            assert(false);
+            return {};
+        }
+        index = used_++;
+    }
+
+    Slot& slot = slots_[index];
+    const uint32_t generation = slot.next_generation;
+    // skip 0 on wrap, it never matches
+    slot.next_generation = generation == ResourceHandle::generation_mask ? 1 : generation + 1;
+    slot.references = 1;
+    slot.last_used = frame_;
+    slot.evicted = false;
+    slot.resource = resource.release();
+
+    ResourceHandle handle;
+    handle.value = (generation << ResourceHandle::index_bits) | index;
+    slot.resource->handle_ = handle;
+    slot.resource->manager_ = this;
+    // already locked
+    Usage& usage = usage_[size_t(slot.resource->category_)];
+    usage.bytes += slot.resource->resident_bytes_;
+    usage.peak_bytes = (std::max)(usage.peak_bytes, usage.bytes);
+    // resource is visible before generation matches
+    slot.generation.store(generation, std::memory_order_release);
+    ++alive_;
+    return handle;
+}
+
+void ResourceManager::add_ref(ResourceHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(get(handle) != nullptr);
+    ++slots_[handle.index()].references;
+}
+
+bool ResourceManager::try_add_ref(ResourceHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (get(handle) == nullptr) {
+        return false;
+    }
+    ++slots_[handle.index()].references;
+    return true;
+}
+
+void ResourceManager::release(ResourceHandle handle)
+{
+    if (!handle) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (destroying_) {
+        return;
+    }
+    assert(get(handle) != nullptr);
+    Slot& slot = slots_[handle.index()];
+    if (--slot.references > 0) {
+        return;
+    }
+    // handle stops resolving now, resource waits for frames in flight
+    slot.generation.store(0, std::memory_order_release);
+    released_.push_back({ handle.index(), frame_ });
+    --alive_;
+}
+
+Resource* ResourceManager::get(ResourceHandle handle) const
+{
+    const uint32_t index = handle.index();
+    if (!handle || index >= capacity_) {
+        return nullptr;
+    }
+    const Slot& slot = slots_[index];
+    if (slot.generation.load(std::memory_order_acquire) != handle.generation()) {
+        return nullptr;
+    }
+    return slot.resource;
+}
+
+void ResourceManager::use(ResourceHandle handle)
+{
+    Resource* resource = get(handle);
+    if (resource == nullptr) {
+        return;
+    }
+    Slot& slot = slots_[handle.index()];
+    slot.last_used = frame_;
+    if (slot.evicted)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot.evicted = false;
+            Usage& usage = usage_[size_t(resource->category_)];
+            --usage.evicted;
+            ++usage.restores;
+        }
+        resource->restore();
+    }
+    resource->used(*this);
+}
+
+void ResourceManager::end_frame()
+{
+    std::vector<uint32_t> indices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++frame_;
+        // released in frame order
+        size_t ready = 0;
+        while (ready < released_.size() && released_[ready].frame + frames_in_flight <= frame_) {
+            indices.push_back(released_[ready++].index);
+        }
+        released_.erase(released_.begin(), released_.begin() + ready);
+    }
+    if (!indices.empty())
+    {
+        ProfileScope destroy_scope("destroy released resources");
+        // resources released by destroyed ones wait for their own frames
+        for (uint32_t index : indices) {
+            destroy_slot(index);
+        }
+    }
+
+    evict_over_budget();
+}
+
+void ResourceManager::set_budget(ResourceCategory category, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    usage_[size_t(category)].budget = bytes;
+}
+
+uint64_t ResourceManager::frame() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_;
+}
+
+ResourceManager::Stats ResourceManager::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return { alive_, uint32_t(released_.size()), destroyed_ };
+}
+
+ResourceManager::Usage ResourceManager::usage(ResourceCategory category) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usage_[size_t(category)];
+}
+
+// static
+const char* ResourceManager::category_name(ResourceCategory category)
+{
+    switch (category)
+    {
+    case ResourceCategory::texture: return "texture";
+    case ResourceCategory::geometry: return "geometry";
+    case ResourceCategory::other: return "other";
+    default: return "unknown";
+    }
+}
+
+void ResourceManager::destroy_slot(uint32_t index)
+{
+    // outside of lock: destroy may release other resources
+    Resource* resource = slots_[index].resource;
+    const ResourceCategory category = resource->category_;
+    resource->destroy();
+    // resource may keep memory past destroy(), all of it is gone now
+    account(category, resource->resident_bytes_, 0);
+    resource->manager_ = nullptr;
+    delete resource;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_[index].evicted) {
+        --usage_[size_t(category)].evicted;
+    }
+    slots_[index].resource = nullptr;
+    slots_[index].references = 0;
+    slots_[index].evicted = false;
+    free_slots_.push_back(index);
+    ++destroyed_;
+}
+
+void ResourceManager::account(ResourceCategory category, size_t old_bytes, size_t new_bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Usage& usage = usage_[size_t(category)];
+    usage.bytes = usage.bytes - old_bytes + new_bytes;
+    usage.peak_bytes = (std::max)(usage.peak_bytes, usage.bytes);
+}
+
+void ResourceManager::evict_over_budget()
+{
+    struct Candidate
+    {
+        uint32_t index;
+        uint64_t last_used;
+    };
+    for (uint32_t c = 0; c < uint32_t(ResourceCategory::count); ++c)
+    {
+        std::vector<Candidate> candidates;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const Usage& usage = usage_[c];
+            if (usage.budget == 0 || usage.bytes <= usage.budget) {
+                continue;
+            }
+            // resources of frames in flight stay
+            for (uint32_t i = 0; i < used_; ++i)
+            {
+                const Slot& slot = slots_[i];
+                if (slot.generation.load(std::memory_order_relaxed) != 0 && !slot.evicted &&
+                    uint32_t(slot.resource->category_) == c && slot.resource->resident_bytes_ > 0 &&
+                    slot.last_used + frames_in_flight <= frame_) {
+                    candidates.push_back({ i, slot.last_used });
+                }
+            }
+        }
+
+        // least recently used first
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.last_used < b.last_used;
+        });
+        ProfileScope evict_scope("evict resources");
+        for (const Candidate& candidate : candidates)
+        {
+            const Usage current = usage(ResourceCategory(c));
+            if (current.bytes <= current.budget) {
+                break;
+            }
+            // outside of lock: evict accounts freed bytes
+            Slot& slot = slots_[candidate.index];
+            if (!slot.resource->evict()) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot.evicted = true;
+            ++usage_[c].evicted;
+            ++usage_[c].evictions;
+        }
+    }
+}
@@ -1,21 +1,184 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+// 32 bit reference to resource of ResourceManager: slot index and slot generation.
+// Handles of destroyed resources do not resolve, even when their slot is reused.
+struct ResourceHandle
+{
+    constexpr static uint32_t index_bits = 20;
+    constexpr static uint32_t generation_bits = 32 - index_bits;
+    constexpr static uint32_t index_mask = (1u << index_bits) - 1;
+    constexpr static uint32_t generation_mask = (1u << generation_bits) - 1;
+
+    uint32_t value{ 0 }; // 0 - invalid, generations start from 1
+
+    uint32_t index() const { return value & index_mask; }
+    uint32_t generation() const { return value >> index_bits; }
+
+    explicit operator bool() const { return value != 0; }
+    bool operator==(const ResourceHandle& other) const { return value == other.value; }
+    bool operator!=(const ResourceHandle& other) const { return value != other.value; }
+};
+
+class ResourceManager;
+
+// memory accounted and budgeted together
+enum class ResourceCategory : uint32_t
+{
+    texture,    // texels
+    geometry,   // vertices, indices and mesh constants
+    other,
+    count
+};
+
+// Object owned by ResourceManager
 class Resource
 {
+public:
+    explicit Resource(ResourceCategory category = ResourceCategory::other);
+    virtual ~Resource() = default;
+
+    // free GPU objects, ResourceManager calls it when no frame in flight uses resource
+    virtual void destroy() = 0;
+
+    ResourceHandle handle() const { return handle_; }
+    ResourceCategory category() const { return category_; }
+    size_t resident_bytes() const { return resident_bytes_; }
+
 protected:
-    uint64_t handle_;
+    // Render thread. Free memory of unused resource, keep what restore() needs.
+    // false - resource can not be restored and stays resident.
+    virtual bool evict() { return false; }
+    // render thread: evicted resource is used again, it may become resident frames later
+    virtual void restore() {}
+    // render thread, every ResourceManager::use(): use resources this one draws with
+    virtual void used(ResourceManager& /* resources */) {}
+
+    // call when memory of resource changes, accounted once resource is registered
+    void set_resident_bytes(size_t bytes);
+
+private:
+    friend class ResourceManager;
+    ResourceHandle handle_;
+    ResourceManager* manager_{ nullptr };
+    const ResourceCategory category_;
+    size_t resident_bytes_{ 0 };
 };
 
+// Registry of textures, materials and meshes.
+// Resources live in a fixed array of slots, handle lookup is a single index with generation
+// check. Every handle returned by add() or passed to add_ref() carries a reference.
+// When the last reference is released the handle stops resolving, the resource itself is
+// destroyed by end_frame() once the frames which could still draw with it are done.
+// Resident bytes are accounted per category. end_frame() keeps categories with budget under
+// it by evicting least recently used resources, use() restores them.
+// add, add_ref and release are safe on any thread (loader jobs register parsed resources),
+// lookups are lock free. Resources are destroyed on render thread.
 class ResourceManager final
 {
 public:
+    constexpr static uint32_t default_capacity = 1 << 16;
+    // frames recorded before resource was released may still be processed
+    constexpr static uint64_t frames_in_flight = 2;
+
+    struct Stats
+    {
+        uint32_t alive;     // resources with references
+        uint32_t pending;   // released, waiting for destruction
+        uint64_t destroyed;
+    };
+
+    struct Usage
+    {
+        size_t bytes;       // resident
+        size_t peak_bytes;
+        size_t budget;      // 0 - unlimited
+        uint32_t evicted;   // resources evicted now
+        uint64_t evictions;
+        uint64_t restores;
+    };
+
     ResourceManager();
     ~ResourceManager();
 
-    void add_resource();
+    ResourceManager(const ResourceManager&) = delete;
+    ResourceManager& operator=(const ResourceManager&) = delete;
+
+    void initialize(uint32_t capacity = default_capacity);
+    // destroys everything, referenced or not
+    void destroy();
+
+    ResourceHandle add(std::unique_ptr<Resource> resource);
+    void add_ref(ResourceHandle handle);
+    // add_ref if handle still resolves, for caches which keep handles without reference
+    bool try_add_ref(ResourceHandle handle);
+    // invalid handle is ignored
+    void release(ResourceHandle handle);
+
+    // nullptr for invalid and released handles
+    Resource* get(ResourceHandle handle) const;
+    template<typename T>
+    T* get(ResourceHandle handle) const
+    {
+        Resource* resource = get(handle);
+        assert(resource == nullptr || dynamic_cast<T*>(resource) != nullptr);
+        return static_cast<T*>(resource);
+    }
+
+    // Render thread, every frame resource is drawn with: marks it recently used, restores
+    // evicted resource and uses resources it depends on. Invalid handle is ignored.
+    void use(ResourceHandle handle);
+
+    // Render thread, after frame is submitted: destroys resources released frames_in_flight frames ago,
+    // then evicts resources not used for frames_in_flight frames from categories over budget.
+    void end_frame();
+
+    // 0 - unlimited
+    void set_budget(ResourceCategory category, size_t bytes);
+
+    uint64_t frame() const;
+    Stats stats() const;
+    Usage usage(ResourceCategory category) const;
+    static const char* category_name(ResourceCategory category);
+
 private:
-    std::vector<Resource*> resources_;
+    struct Slot
+    {
+        std::atomic<uint32_t> generation{ 0 }; // matches handles while resource is referenced
+        uint32_t next_generation{ 1 };
+        Resource* resource{ nullptr };
+        uint32_t references{ 0 };
+        uint64_t last_used{ 0 };    // frame, render thread
+        bool evicted{ false };
+    };
+
+    struct Released
+    {
+        uint32_t index;
+        uint64_t frame; // last frame which could use resource
+    };
+
+    friend class Resource;
+
+    void destroy_slot(uint32_t index);
+    void account(ResourceCategory category, size_t old_bytes, size_t new_bytes);
+    void evict_over_budget();
+
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t capacity_{ 0 };
+    uint32_t used_{ 0 };                // slots ever taken, next one is never used
+    std::vector<uint32_t> free_slots_;
+    std::vector<Released> released_;    // in release order
+    uint64_t frame_{ 0 };
+    uint32_t alive_{ 0 };
+    uint64_t destroyed_{ 0 };
+    Usage usage_[size_t(ResourceCategory::count)]{};
+    bool destroying_{ false };
+    mutable std::mutex mutex_;
 };
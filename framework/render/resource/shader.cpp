@@ -1,9 +1,12 @@
-#include <sstream>
+#include <cassert>
+#include <utility>
 #include <d3dcompiler.h>
 
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "shader.h"
+#include "shader_compiler.h"
 #include "render/d3d11_common.h"
 
 Shader::Shader() {}
@@ -33,335 +36,166 @@ void Shader::set_compute_shader_from_file(const std::string& filename,
                                           const std::string& entrypoint,
                                           D3D_SHADER_MACRO* macro, ID3DInclude* include)
 {
-    assert(compute_bc_ == nullptr);
-    assert(compute_shader_ == nullptr);
-
-    // translate filename to wstring
-    std::wstringstream wfilename;
-    wfilename << filename.c_str();
-
-    ID3DBlob* error_code = nullptr;
-
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    // don't use D3D11_CHECK for this call, need to know compilation error message
-    HRESULT status = D3DCompileFromFile(wfilename.str().c_str(), macro, include,
-                                        entrypoint.c_str(), "cs_5_0",
-                                        compile_flags, 0,
-                                        &compute_bc_, &error_code);
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        else
-        {
-            OutputDebugString("Missing shader file\n");
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateComputeShader(compute_bc_->GetBufferPointer(),
-                                            compute_bc_->GetBufferSize(),
-                                            nullptr, &compute_shader_));
+    set_compute_shader(compile(filename, {}, entrypoint, "cs_5_0", macro, include));
 }
 
 void Shader::set_vs_shader_from_file(const std::string& filename,
                                      const std::string& entrypoint,
                                      D3D_SHADER_MACRO* macro, ID3DInclude* include)
 {
-    assert(vertex_bc_ == nullptr);
-    assert(vertex_shader_ == nullptr);
-
-    // translate filename to wstring
-    std::wstringstream wfilename;
-    wfilename << filename.c_str();
-
-    ID3DBlob* error_code = nullptr;
-
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    // don't use D3D11_CHECK for this call, need to know compilation error message
-    HRESULT status = D3DCompileFromFile(wfilename.str().c_str(), macro, include,
-                                        entrypoint.c_str(), "vs_5_0",
-                                        compile_flags, 0,
-                                        &vertex_bc_, &error_code);
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        else
-        {
-            OutputDebugString("Missing shader file\n");
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateVertexShader(vertex_bc_->GetBufferPointer(),
-                                           vertex_bc_->GetBufferSize(),
-                                           nullptr, &vertex_shader_));
+    set_vs_shader(compile(filename, {}, entrypoint, "vs_5_0", macro, include));
 }
 
 void Shader::set_gs_shader_from_file(const std::string& filename,
                                      const std::string& entrypoint,
                                      D3D_SHADER_MACRO* macro, ID3DInclude* include)
 {
-    assert(geometry_bc_ == nullptr);
-    assert(geometry_shader_ == nullptr);
-
-    // translate filename to wstring
-    std::wstringstream wfilename;
-    wfilename << filename.c_str();
-
-    ID3DBlob* error_code = nullptr;
-
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    // don't use D3D11_CHECK for this call, need to know compilation error message
-    HRESULT status = D3DCompileFromFile(wfilename.str().c_str(), macro, include,
-                                        entrypoint.c_str(), "gs_5_0",
-                                        compile_flags, 0,
-                                        &geometry_bc_, &error_code);
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        else
-        {
-            OutputDebugString("Missing shader file\n");
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateGeometryShader(geometry_bc_->GetBufferPointer(),
-                                             geometry_bc_->GetBufferSize(),
-                                             nullptr, &geometry_shader_));
+    set_gs_shader(compile(filename, {}, entrypoint, "gs_5_0", macro, include));
 }
 
 void Shader::set_ps_shader_from_file(const std::string& filename,
                                      const std::string& entrypoint,
                                      D3D_SHADER_MACRO* macro, ID3DInclude* include)
 {
-    assert(pixel_bc_ == nullptr);
-    assert(pixel_shader_ == nullptr);
-
-    // translate filename to wstring
-    std::wstringstream wfilename;
-    wfilename << filename.c_str();
-
-    ID3DBlob* error_code = nullptr;
-
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    // don't use D3D11_CHECK for this call, need to know compilation error message
-    HRESULT status = D3DCompileFromFile(wfilename.str().c_str(), macro, include,
-                                        entrypoint.c_str(), "ps_5_0",
-                                        compile_flags, 0,
-                                        &pixel_bc_, &error_code);
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        else
-        {
-            OutputDebugString("Missing shader file\n");
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreatePixelShader(pixel_bc_->GetBufferPointer(),
-                                          pixel_bc_->GetBufferSize(),
-                                          nullptr, &pixel_shader_));
+    set_ps_shader(compile(filename, {}, entrypoint, "ps_5_0", macro, include));
 }
 
 void Shader::set_compute_shader_from_memory(const std::string& data,
                                             const std::string& entrypoint,
                                             D3D_SHADER_MACRO* macro, ID3DInclude* include)
 {
-    assert(compute_bc_ == nullptr);
-    assert(compute_shader_ == nullptr);
+    set_compute_shader(compile({}, data, entrypoint, "cs_5_0", macro, include));
+}
 
-    ID3DBlob* error_code = nullptr;
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    HRESULT status = D3DCompile(data.data(), data.size(), nullptr,
-                                macro, include,
-                                entrypoint.c_str(), "cs_5_0",
-                                compile_flags, 0,
-                                &compute_bc_, &error_code);
+void Shader::set_vs_shader_from_memory(const std::string& data,
+                                       const std::string& entrypoint,
+                                       D3D_SHADER_MACRO* macro, ID3DInclude* include)
+{
+    set_vs_shader(compile({}, data, entrypoint, "vs_5_0", macro, include));
+}
 
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateComputeShader(compute_bc_->GetBufferPointer(),
-                                            compute_bc_->GetBufferSize(),
-                                            nullptr, &compute_shader_));
+void Shader::set_gs_shader_from_memory(const std::string& data,
+                                       const std::string& entrypoint,
+                                       D3D_SHADER_MACRO* macro, ID3DInclude* include)
+{
+    set_gs_shader(compile({}, data, entrypoint, "gs_5_0", macro, include));
 }
 
-void Shader::set_vs_shader_from_memory(const std::string& data,
+void Shader::set_ps_shader_from_memory(const std::string& data,
                                        const std::string& entrypoint,
                                        D3D_SHADER_MACRO* macro, ID3DInclude* include)
+{
+    set_ps_shader(compile({}, data, entrypoint, "ps_5_0", macro, include));
+}
+
+void Shader::set_compute_shader(ID3DBlob* bytecode)
+{
+    assert(compute_bc_ == nullptr);
+    assert(compute_shader_ == nullptr);
+    assert(bytecode != nullptr);
+
+    compute_bc_ = bytecode;
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_compute_shader(compute_bc_->GetBufferPointer(),
+                                               compute_bc_->GetBufferSize(), &compute_shader_));
+}
+
+void Shader::set_vs_shader(ID3DBlob* bytecode)
 {
     assert(vertex_bc_ == nullptr);
     assert(vertex_shader_ == nullptr);
+    assert(bytecode != nullptr);
 
-    ID3DBlob* error_code = nullptr;
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    HRESULT status = D3DCompile(data.data(), data.size(), nullptr,
-                                macro, include,
-                                entrypoint.c_str(), "vs_5_0",
-                                compile_flags, 0,
-                                &vertex_bc_, &error_code);
-
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateVertexShader(vertex_bc_->GetBufferPointer(),
-                                          vertex_bc_->GetBufferSize(),
-                                          nullptr, &vertex_shader_));
+    vertex_bc_ = bytecode;
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_vertex_shader(vertex_bc_->GetBufferPointer(),
+                                              vertex_bc_->GetBufferSize(), &vertex_shader_));
 }
 
-void Shader::set_gs_shader_from_memory(const std::string& data,
-                                       const std::string& entrypoint,
-                                       D3D_SHADER_MACRO* macro, ID3DInclude* include)
+void Shader::set_gs_shader(ID3DBlob* bytecode)
 {
     assert(geometry_bc_ == nullptr);
     assert(geometry_shader_ == nullptr);
+    assert(bytecode != nullptr);
 
-    ID3DBlob* error_code = nullptr;
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    HRESULT status = D3DCompile(data.data(), data.size(), nullptr,
-                                macro, include,
-                                entrypoint.c_str(), "gs_5_0",
-                                compile_flags, 0,
-                                &geometry_bc_, &error_code);
-
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateGeometryShader(geometry_bc_->GetBufferPointer(),
-                                             geometry_bc_->GetBufferSize(),
-                                             nullptr, &geometry_shader_));
+    geometry_bc_ = bytecode;
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_geometry_shader(geometry_bc_->GetBufferPointer(),
+                                                geometry_bc_->GetBufferSize(), &geometry_shader_));
 }
 
-void Shader::set_ps_shader_from_memory(const std::string& data,
-                                       const std::string& entrypoint,
-                                       D3D_SHADER_MACRO* macro, ID3DInclude* include)
+void Shader::set_ps_shader(ID3DBlob* bytecode)
 {
     assert(pixel_bc_ == nullptr);
     assert(pixel_shader_ == nullptr);
+    assert(bytecode != nullptr);
 
-    ID3DBlob* error_code = nullptr;
-    unsigned int compile_flags = 0;
-#ifndef NDEBUG
-    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    HRESULT status = D3DCompile(data.data(), data.size(), nullptr,
-                                macro, include,
-                                entrypoint.c_str(), "ps_5_0",
-                                compile_flags, 0,
-                                &pixel_bc_, &error_code);
-
-    if (FAILED(status))
-    {
-        if (error_code)
-        {
-            std::stringstream err;
-            err << (char*)(error_code->GetBufferPointer());
-            OutputDebugString(err.str().c_str());
-        }
-        assert(false);
-    }
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreatePixelShader(pixel_bc_->GetBufferPointer(),
-                                          pixel_bc_->GetBufferSize(),
-                                          nullptr, &pixel_shader_));
+    pixel_bc_ = bytecode;
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_pixel_shader(pixel_bc_->GetBufferPointer(),
+                                             pixel_bc_->GetBufferSize(), &pixel_shader_));
 }
 
 void Shader::set_input_layout(D3D11_INPUT_ELEMENT_DESC* inputs, size_t count)
 {
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateInputLayout(
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_input_layout(
                 inputs, static_cast<uint32_t>(count),
                 vertex_bc_->GetBufferPointer(),
                 vertex_bc_->GetBufferSize(),
                 &input_layout_));
 }
 
+// static
+ID3DBlob* Shader::compile(const std::string& filename, const std::string& source,
+                          const std::string& entrypoint, const char* profile,
+                          D3D_SHADER_MACRO* macro, ID3DInclude* include)
+{
+    ShaderCompiler::Request request;
+    request.filename = filename;
+    request.source = source;
+    request.entrypoint = entrypoint;
+    request.profile = profile;
+    request.defines = ShaderCompiler::defines(macro);
+    request.include = include;
+
+    std::string output;
+    ID3DBlob* blob = ShaderCompiler::compile(request, output, &Game::inst()->render().shader_compiler()->dependencies());
+    ShaderCompiler::report(request, output, blob != nullptr);
+    assert(blob != nullptr);
+    return blob;
+}
+
+void Shader::swap(Shader& other)
+{
+    std::swap(compute_shader_, other.compute_shader_);
+    std::swap(compute_bc_, other.compute_bc_);
+    std::swap(vertex_shader_, other.vertex_shader_);
+    std::swap(vertex_bc_, other.vertex_bc_);
+    std::swap(geometry_shader_, other.geometry_shader_);
+    std::swap(geometry_bc_, other.geometry_bc_);
+    std::swap(pixel_shader_, other.pixel_shader_);
+    std::swap(pixel_bc_, other.pixel_bc_);
+    std::swap(input_layout_, other.input_layout_);
+}
+
 void Shader::use()
 {
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
     if (input_layout_ != nullptr) {
-        context->IASetInputLayout(input_layout_);
+        backend->ia_set_input_layout(input_layout_);
     }
     if (vertex_shader_ != nullptr) {
-        context->VSSetShader(vertex_shader_, nullptr, 0);
+        backend->vs_set_shader(vertex_shader_);
     }
     if (geometry_shader_ != nullptr) {
-        context->GSSetShader(geometry_shader_, nullptr, 0);
+        backend->gs_set_shader(geometry_shader_);
     }
     if (pixel_shader_ != nullptr) {
-        context->PSSetShader(pixel_shader_, nullptr, 0);
+        backend->ps_set_shader(pixel_shader_);
     }
     if (compute_shader_ != nullptr) {
-        context->CSSetShader(compute_shader_, nullptr, 0);
+        backend->cs_set_shader(compute_shader_);
     }
 }
 
@@ -18,6 +18,12 @@ private:
     ID3DBlob* pixel_bc_{ nullptr };
 
     ID3D11InputLayout* input_layout_{ nullptr }; // optional
+
+    // synchronous ShaderCompiler::compile, errors reported to debug output
+    // filename - file of source, empty for sources in memory
+    static ID3DBlob* compile(const std::string& filename, const std::string& source,
+                             const std::string& entrypoint, const char* profile,
+                             D3D_SHADER_MACRO* macro, ID3DInclude* include);
 public:
     Shader();
     ~Shader();
@@ -50,8 +56,17 @@ public:
                                    const std::string& entrypoint,
                                    D3D_SHADER_MACRO*, ID3DInclude*);
 
+    // stages from bytecode compiled elsewhere (ShaderCompiler), shader takes the reference
+    void set_compute_shader(ID3DBlob* bytecode);
+    void set_vs_shader(ID3DBlob* bytecode);
+    void set_gs_shader(ID3DBlob* bytecode);
+    void set_ps_shader(ID3DBlob* bytecode);
+
     void set_input_layout(D3D11_INPUT_ELEMENT_DESC*, size_t);
 
+    // exchanges all stages and input layout: pipelines using this shader get the other's
+    void swap(Shader& other);
+
     void use();
 
     void destroy();
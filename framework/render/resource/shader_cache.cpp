@@ -0,0 +1,315 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+#include <d3dcompiler.h>
+
+#include "core/path.h"
+#include "shader_cache.h"
+
+namespace
+{
+constexpr uint32_t file_magic = 0x43444853; // "SHDC"
+constexpr uint32_t file_version = 2;
+// entries unused by this many sessions which rewrote the file are dropped on save:
+// every edit of a shader leaves a stale entry behind
+constexpr uint64_t max_entry_age = 8;
+
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t compiler_version;
+    uint32_t count;
+};
+
+struct FileEntry
+{
+    uint64_t key;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t age; // sessions since last use
+};
+
+// FNV-1a, strings with their length so that concatenations differ
+class Hasher
+{
+public:
+    void add(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+    void add(uint64_t value)
+    {
+        add(&value, sizeof(value));
+    }
+    void add(const char* text)
+    {
+        const size_t size = text != nullptr ? std::strlen(text) : 0;
+        add(uint64_t(size));
+        add(text, size);
+    }
+    void add(const std::string& text)
+    {
+        add(uint64_t(text.size()));
+        add(text.data(), text.size());
+    }
+    uint64_t hash() const
+    {
+        return hash_;
+    }
+private:
+    uint64_t hash_{ 14695981039346656037ull };
+};
+
+struct IncludeDirective
+{
+    std::string name;
+    bool system; // <name>
+};
+
+// #include directives of source, conditional blocks are not evaluated:
+// the result is a superset of files the compiler opens
+std::vector<IncludeDirective> include_directives(const std::string& source)
+{
+    std::vector<IncludeDirective> directives;
+    size_t line = 0;
+    while (line < source.size())
+    {
+        size_t end = source.find('\n', line);
+        if (end == std::string::npos) {
+            end = source.size();
+        }
+        size_t i = source.find_first_not_of(" \t", line);
+        if (i < end && source[i] == '#')
+        {
+            i = source.find_first_not_of(" \t", i + 1);
+            if (i < end && source.compare(i, 7, "include") == 0)
+            {
+                i = source.find_first_not_of(" \t", i + 7);
+                if (i < end && (source[i] == '"' || source[i] == '<'))
+                {
+                    const char close = source[i] == '"' ? '"' : '>';
+                    size_t name_end = source.find(close, i + 1);
+                    if (name_end < end) {
+                        directives.push_back({ source.substr(i + 1, name_end - i - 1), close == '>' });
+                    }
+                }
+            }
+        }
+        line = end + 1;
+    }
+    return directives;
+}
+
+bool read_file(const std::string& filename, std::string& contents)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// hashes names and contents of included files, recursively;
+// data - parent data the compiler passes to include handler for this source (nullptr for compiled file),
+// path - its file. Names resolve relative to including file, so visited files are keyed by resolved path.
+void hash_includes(Hasher& hasher, const std::string& source, LPCVOID data, const std::string& path,
+                   ID3DInclude* include, std::unordered_set<std::string>& visited)
+{
+    for (const auto& directive : include_directives(source))
+    {
+        hasher.add(directive.name);
+        const std::string included_path = directory_of(path) + directive.name;
+        if (!visited.insert(normalize_path(included_path)).second) {
+            continue;
+        }
+        if (include == D3D_COMPILE_STANDARD_FILE_INCLUDE)
+        {
+            std::string contents;
+            if (!read_file(included_path, contents)) {
+                continue; // compilation fails as well
+            }
+            hasher.add(contents);
+            hash_includes(hasher, contents, nullptr, included_path, include, visited);
+        }
+        else
+        {
+            LPCVOID included_data = nullptr;
+            UINT bytes = 0;
+            if (FAILED(include->Open(directive.system ? D3D_INCLUDE_SYSTEM : D3D_INCLUDE_LOCAL,
+                                     directive.name.c_str(), data, &included_data, &bytes))) {
+                continue;
+            }
+            // kept open while nested includes are hashed: it is their parent data
+            const std::string contents(static_cast<const char*>(included_data), bytes);
+            hasher.add(contents);
+            hash_includes(hasher, contents, included_data, included_path, include, visited);
+            include->Close(included_data);
+        }
+    }
+}
+}
+
+ShaderCache::ShaderCache()
+{
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+void ShaderCache::load(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    filename_ = filename;
+    data_.clear();
+    blobs_.clear();
+    dirty_ = false;
+
+    std::string contents;
+    if (!read_file(filename, contents) || contents.size() < sizeof(FileHeader)) {
+        return;
+    }
+    FileHeader header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != file_magic || header.version != file_version || header.compiler_version != D3D_COMPILER_VERSION) {
+        // rebuilt from scratch
+        dirty_ = true;
+        return;
+    }
+    const size_t index_end = sizeof(FileHeader) + size_t(header.count) * sizeof(FileEntry);
+    if (contents.size() < index_end) {
+        dirty_ = true;
+        return;
+    }
+
+    data_.assign(contents.begin() + index_end, contents.end());
+    for (uint32_t i = 0; i < header.count; ++i)
+    {
+        FileEntry entry;
+        std::memcpy(&entry, contents.data() + sizeof(FileHeader) + i * sizeof(FileEntry), sizeof(entry));
+        if (entry.offset + entry.size > data_.size()) {
+            // damaged tail: keep what is intact, rewrite
+            dirty_ = true;
+            continue;
+        }
+        // one more session; find() and store() make entry young again
+        blobs_[entry.key] = { size_t(entry.offset), size_t(entry.size), entry.age + 1 };
+    }
+}
+
+bool ShaderCache::save()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ || filename_.empty()) {
+        return true;
+    }
+
+    std::ofstream file(filename_, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    // drop old entries and compact bytecode of the rest
+    std::vector<uint8_t> data;
+    std::vector<FileEntry> entries;
+    for (auto it = blobs_.begin(); it != blobs_.end();)
+    {
+        Blob& blob = it->second;
+        if (blob.age > max_entry_age) {
+            it = blobs_.erase(it);
+            continue;
+        }
+        entries.push_back({ it->first, data.size(), blob.size, blob.age });
+        data.insert(data.end(), data_.begin() + blob.offset, data_.begin() + blob.offset + blob.size);
+        blob.offset = size_t(entries.back().offset);
+        ++it;
+    }
+    data_.swap(data);
+
+    FileHeader header{ file_magic, file_version, D3D_COMPILER_VERSION, uint32_t(entries.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size() * sizeof(FileEntry)));
+    file.write(reinterpret_cast<const char*>(data_.data()), std::streamsize(data_.size()));
+    if (!file) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+void ShaderCache::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_.clear();
+    data_.shrink_to_fit();
+    blobs_.clear();
+    filename_.clear();
+    dirty_ = false;
+}
+
+// static
+uint64_t ShaderCache::key(const std::string& source, const std::string& source_name,
+                          const D3D_SHADER_MACRO* macros, ID3DInclude* include,
+                          const std::string& entrypoint, const char* profile, UINT flags)
+{
+    Hasher hasher;
+    hasher.add(source);
+    hasher.add(source_name); // in debug info and __FILE__
+    for (auto macro = macros; macro != nullptr && macro->Name != nullptr; ++macro)
+    {
+        hasher.add(macro->Name);
+        hasher.add(macro->Definition);
+    }
+    hasher.add(entrypoint);
+    hasher.add(profile);
+    hasher.add(uint64_t(flags));
+    // without include handler #include does not compile
+    if (include != nullptr)
+    {
+        std::unordered_set<std::string> visited;
+        hash_includes(hasher, source, nullptr, source_name, include, visited);
+    }
+    return hasher.hash();
+}
+
+bool ShaderCache::find(uint64_t key, std::vector<uint8_t>& bytecode)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(key);
+    if (it == blobs_.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    it->second.age = 0;
+    auto begin = data_.begin() + it->second.offset;
+    bytecode.assign(begin, begin + it->second.size);
+    return true;
+}
+
+void ShaderCache::store(uint64_t key, const void* bytecode, size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(key);
+    if (it != blobs_.end()) {
+        it->second.age = 0;
+        return;
+    }
+    auto bytes = static_cast<const uint8_t*>(bytecode);
+    blobs_[key] = { data_.size(), size, 0 };
+    data_.insert(data_.end(), bytes, bytes + size);
+    dirty_ = true;
+}
+
+ShaderCache::Stats ShaderCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return { hits_, misses_, uint32_t(blobs_.size()) };
+}
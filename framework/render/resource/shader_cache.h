@@ -0,0 +1,65 @@
+#pragma once
+
+#include <d3dcommon.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compiled shader bytecode by hash of everything compiler output depends on: source text,
+// sources of included files, macros, entry point, profile and compile flags.
+// Entries live in one file: header, index of (key, offset, size) and bytecode blobs.
+// The file is read whole on load and rewritten on save when something was added; the rewrite
+// drops entries which no session used for a while (edited shaders), so the file does not grow forever.
+// Safe on any thread.
+class ShaderCache final
+{
+public:
+    constexpr static const char* default_filename = "./shader_cache.bin";
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint32_t entries;
+    };
+
+    ShaderCache();
+    ~ShaderCache();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // missing, damaged or other compiler version file gives empty cache
+    void load(const std::string& filename);
+    // writes file given to load() if entries were added
+    bool save();
+    void destroy();
+
+    // source_name - file of source (includes are resolved next to it), empty for sources in memory
+    static uint64_t key(const std::string& source, const std::string& source_name,
+                        const D3D_SHADER_MACRO* macros, ID3DInclude* include,
+                        const std::string& entrypoint, const char* profile, UINT flags);
+
+    bool find(uint64_t key, std::vector<uint8_t>& bytecode);
+    void store(uint64_t key, const void* bytecode, size_t size);
+
+    Stats stats() const;
+
+private:
+    struct Blob
+    {
+        size_t offset;
+        size_t size;
+        uint64_t age; // sessions which rewrote the file without using the entry
+    };
+
+    mutable std::mutex mutex_;
+    std::string filename_;
+    std::vector<uint8_t> data_; // bytecode of all entries
+    std::unordered_map<uint64_t, Blob> blobs_;
+    bool dirty_{ false };
+    uint64_t hits_{ 0 };
+    uint64_t misses_{ 0 };
+};
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <d3dcompiler.h>
+
+#include "core/game.h"
+#include "core/job_system.h"
+#include "render/render.h"
+#include "render/d3d11_common.h"
+#include "shader_cache.h"
+#include "shader_compiler.h"
+#include "shader_include.h"
+
+struct ShaderCompiler::Batch
+{
+    std::vector<Request> requests;
+    std::vector<ID3DBlob*> bytecode; // written by job of request
+    std::vector<std::string> output; // written by job of request
+    std::vector<JobHandle> jobs;
+    Callback callback;
+    std::atomic<bool> completed{ false };
+
+    bool ready() const
+    {
+        for (const auto& job : jobs)
+        {
+            if (!job.finished()) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool ShaderCompiler::Handle::valid() const
+{
+    return batch_ != nullptr;
+}
+
+bool ShaderCompiler::Handle::ready() const
+{
+    return batch_ != nullptr && batch_->ready();
+}
+
+bool ShaderCompiler::Handle::completed() const
+{
+    return batch_ != nullptr && batch_->completed;
+}
+
+bool ShaderCompiler::Handle::succeeded() const
+{
+    assert(ready());
+    for (auto bytecode : batch_->bytecode)
+    {
+        if (bytecode == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string ShaderCompiler::Handle::errors() const
+{
+    assert(ready());
+    std::string errors;
+    for (const auto& output : batch_->output) {
+        errors += output;
+    }
+    return errors;
+}
+
+ShaderCompiler::ShaderCompiler()
+{
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    assert(pending_.empty());
+}
+
+void ShaderCompiler::destroy()
+{
+    wait_all();
+}
+
+ShaderCompiler::Handle ShaderCompiler::submit(std::vector<Request> requests, Callback callback)
+{
+    auto batch = std::make_shared<Batch>();
+    batch->requests = std::move(requests);
+    batch->bytecode.resize(batch->requests.size(), nullptr);
+    batch->output.resize(batch->requests.size());
+    batch->callback = std::move(callback);
+
+    // pending_ keeps batch alive until its jobs are finished and callback is done
+    Batch* raw = batch.get();
+    auto& jobs = Game::inst()->jobs();
+    for (size_t i = 0; i < raw->requests.size(); ++i)
+    {
+        raw->jobs.push_back(jobs.create([this, raw, i] {
+            raw->bytecode[i] = compile(raw->requests[i], raw->output[i], &dependencies_);
+        }));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(batch);
+        ++batches_;
+    }
+    for (const auto& job : raw->jobs) {
+        jobs.submit(job);
+    }
+
+    Handle handle;
+    handle.batch_ = std::move(batch);
+    return handle;
+}
+
+void ShaderCompiler::flush()
+{
+    std::vector<std::shared_ptr<Batch>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = pending_.begin(); it != pending_.end();)
+        {
+            if ((*it)->ready()) {
+                ready.push_back(std::move(*it));
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // callbacks may submit more work
+    for (auto& batch : ready) {
+        complete(*batch);
+    }
+}
+
+void ShaderCompiler::wait(const Handle& handle)
+{
+    if (!handle.valid() || handle.completed()) {
+        return;
+    }
+    for (const auto& job : handle.batch_->jobs) {
+        Game::inst()->jobs().wait(job);
+    }
+    // batch and everything finished meanwhile
+    flush();
+    assert(handle.completed());
+}
+
+void ShaderCompiler::wait_all()
+{
+    for (;;)
+    {
+        Handle handle;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty()) {
+                return;
+            }
+            handle.batch_ = pending_.front();
+        }
+        wait(handle);
+    }
+}
+
+ShaderCompiler::Stats ShaderCompiler::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return { batches_, compiled_, failed_, uint32_t(pending_.size()) };
+}
+
+ShaderDependencies& ShaderCompiler::dependencies()
+{
+    return dependencies_;
+}
+
+// static
+ID3DBlob* ShaderCompiler::compile(const Request& request, std::string& output, ShaderDependencies* dependencies)
+{
+    std::string source = request.source;
+    if (!request.filename.empty())
+    {
+        std::ifstream file(request.filename, std::ios::binary);
+        if (!file) {
+            output = "Missing shader file\n";
+            return nullptr;
+        }
+        source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    unsigned int compile_flags = 0;
+#ifndef NDEBUG
+    compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (const auto& define : request.defines) {
+        macros.push_back({ define.first.c_str(), define.second.c_str() });
+    }
+    macros.push_back({ nullptr, nullptr });
+
+    // cache key opens includes as well, so edges are recorded on cache hits too
+    std::unique_ptr<ShaderInclude> tracked_include;
+    ID3DInclude* include = request.include;
+    if (include == nullptr && !request.filename.empty())
+    {
+        tracked_include = std::make_unique<ShaderInclude>(request.filename);
+        include = tracked_include.get();
+    }
+    auto record_includes = [&] {
+        if (tracked_include == nullptr || dependencies == nullptr) {
+            return;
+        }
+        std::unordered_map<std::string, std::vector<std::string>> includes{ { request.filename, {} } };
+        for (const auto& edge : tracked_include->edges())
+        {
+            includes[edge.first].push_back(edge.second);
+            includes[edge.second];
+        }
+        for (const auto& file : includes) {
+            dependencies->set_includes(file.first, file.second);
+        }
+    };
+
+    auto cache = Game::inst()->render().shader_cache();
+    const uint64_t key = ShaderCache::key(source, request.filename, macros.data(), include,
+                                          request.entrypoint, request.profile.c_str(), compile_flags);
+    std::vector<uint8_t> bytecode;
+    ID3DBlob* blob = nullptr;
+    if (cache->find(key, bytecode))
+    {
+        D3D11_CHECK(D3DCreateBlob(bytecode.size(), &blob));
+        std::memcpy(blob->GetBufferPointer(), bytecode.data(), bytecode.size());
+        record_includes();
+        return blob;
+    }
+
+    ID3DBlob* error_code = nullptr;
+    // don't use D3D11_CHECK for this call, need to know compilation error message
+    // compile the text the key was computed from: file may change on disk meanwhile (hot reload saves);
+    // source name keeps includes next to the file and names it in debug info
+    HRESULT status = D3DCompile(source.data(), source.size(),
+                                request.filename.empty() ? nullptr : request.filename.c_str(),
+                                macros.data(), include,
+                                request.entrypoint.c_str(), request.profile.c_str(),
+                                compile_flags, 0,
+                                &blob, &error_code);
+    if (error_code != nullptr) {
+        output.assign(static_cast<const char*>(error_code->GetBufferPointer()), error_code->GetBufferSize());
+    }
+    SAFE_RELEASE(error_code);
+    // failed compilation still depends on its includes: fixing one of them reloads the shader
+    record_includes();
+    if (FAILED(status))
+    {
+        SAFE_RELEASE(blob);
+        return nullptr;
+    }
+    cache->store(key, blob->GetBufferPointer(), blob->GetBufferSize());
+    return blob;
+}
+
+// static
+std::vector<std::pair<std::string, std::string>> ShaderCompiler::defines(const D3D_SHADER_MACRO* macros)
+{
+    std::vector<std::pair<std::string, std::string>> defines;
+    for (auto macro = macros; macro != nullptr && macro->Name != nullptr; ++macro) {
+        defines.emplace_back(macro->Name, macro->Definition != nullptr ? macro->Definition : "");
+    }
+    return defines;
+}
+
+// static
+void ShaderCompiler::report(const Request& request, const std::string& output, bool succeeded)
+{
+    if (succeeded && output.empty()) {
+        return;
+    }
+    std::string message = request.filename.empty() ? std::string("<memory>") : request.filename;
+    message += " (" + request.entrypoint + ", " + request.profile;
+    for (const auto& define : request.defines) {
+        message += ", " + define.first + "=" + define.second;
+    }
+    message += succeeded ? "): warnings\n" : "): failed\n";
+    message += output;
+    if (!output.empty() && output.back() != '\n') {
+        message += '\n';
+    }
+    OutputDebugString(message.c_str());
+}
+
+void ShaderCompiler::complete(Batch& batch)
+{
+    uint64_t failed = 0;
+    for (size_t i = 0; i < batch.requests.size(); ++i)
+    {
+        report(batch.requests[i], batch.output[i], batch.bytecode[i] != nullptr);
+        if (batch.bytecode[i] == nullptr) {
+            ++failed;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compiled_ += batch.requests.size();
+        failed_ += failed;
+    }
+    if (batch.callback) {
+        batch.callback(batch.bytecode);
+    } else {
+        for (auto bytecode : batch.bytecode) {
+            SAFE_RELEASE(bytecode);
+        }
+    }
+    batch.completed = true;
+}
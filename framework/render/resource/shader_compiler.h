@@ -0,0 +1,104 @@
+#pragma once
+
+#include <d3dcommon.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shader_dependencies.h"
+
+// Compilation of shaders on job system workers.
+// A batch is the set of stages of one shader: every stage compiles as a separate job and
+// the batch callback gets bytecode of all of them on render thread, where device objects
+// are created. Callbacks run from flush() (every frame) and wait() as batches finish.
+// Compiler output is reported to debug output per stage.
+// Includes of compiled files go to the dependency graph used by hot reload.
+class ShaderCompiler final
+{
+public:
+    struct Request
+    {
+        std::string filename; // file of source, includes are opened next to it
+        std::string source;   // source in memory when filename is empty
+        std::string entrypoint;
+        std::string profile;
+        std::vector<std::pair<std::string, std::string>> defines;
+        // must outlive compilation; nullptr - includes next to the file, recorded by ShaderInclude
+        ID3DInclude* include{ nullptr };
+    };
+
+    // bytecode of batch requests in their order, nullptr for failed ones;
+    // callback takes the references
+    using Callback = std::function<void(const std::vector<ID3DBlob*>& bytecode)>;
+
+    struct Stats
+    {
+        uint64_t batches;
+        uint64_t compiled; // requests, including shader cache hits
+        uint64_t failed;
+        uint32_t pending;  // batches waiting for callback
+    };
+
+private:
+    struct Batch;
+
+public:
+    // future-like handle of submitted batch
+    class Handle
+    {
+    public:
+        bool valid() const;
+        bool ready() const;     // all stages compiled, callback may be pending
+        bool completed() const; // callback done
+        bool succeeded() const; // after ready(): every stage compiled
+        std::string errors() const; // after ready(): compiler output of all stages
+
+    private:
+        friend class ShaderCompiler;
+        std::shared_ptr<Batch> batch_;
+    };
+
+    ShaderCompiler();
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+    // waits for pending batches and runs their callbacks
+    void destroy();
+
+    // any thread
+    Handle submit(std::vector<Request> requests, Callback callback);
+
+    // render thread: callbacks of finished batches
+    void flush();
+    // render thread: block until batch is finished, other workers keep compiling meanwhile
+    void wait(const Handle& handle);
+    void wait_all();
+
+    Stats stats() const;
+    ShaderDependencies& dependencies();
+
+    // synchronous compilation through shader cache, any thread.
+    // nullptr on error, output gets compiler errors and warnings, dependencies (if any) get includes
+    static ID3DBlob* compile(const Request& request, std::string& output, ShaderDependencies* dependencies = nullptr);
+    static std::vector<std::pair<std::string, std::string>> defines(const D3D_SHADER_MACRO* macros);
+    // debug output of request with its compiler output
+    static void report(const Request& request, const std::string& output, bool succeeded);
+
+private:
+    void complete(Batch& batch);
+
+    ShaderDependencies dependencies_;
+
+    mutable std::mutex mutex_;
+    std::deque<std::shared_ptr<Batch>> pending_; // submission order
+    uint64_t batches_{ 0 };
+    uint64_t compiled_{ 0 };
+    uint64_t failed_{ 0 };
+};
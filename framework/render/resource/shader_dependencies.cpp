@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "core/path.h"
+#include "shader_dependencies.h"
+
+ShaderDependencies::ShaderDependencies()
+{
+}
+
+ShaderDependencies::~ShaderDependencies()
+{
+}
+
+void ShaderDependencies::set_includes(const std::string& file, const std::vector<std::string>& includes)
+{
+    const std::string key = normalize_path(file);
+    std::vector<std::string> normalized;
+    for (const auto& include : includes)
+    {
+        std::string path = normalize_path(include);
+        if (std::find(normalized.begin(), normalized.end(), path) == normalized.end()) {
+            normalized.push_back(std::move(path));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& edges = includes_[key];
+    for (const auto& include : edges)
+    {
+        auto it = included_by_.find(include);
+        if (it != included_by_.end())
+        {
+            it->second.erase(key);
+            if (it->second.empty()) {
+                included_by_.erase(it);
+            }
+        }
+    }
+    edges = std::move(normalized);
+    for (const auto& include : edges) {
+        included_by_[include].insert(key);
+    }
+}
+
+void ShaderDependencies::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    includes_.clear();
+    included_by_.clear();
+}
+
+std::vector<std::string> ShaderDependencies::includes(const std::string& file) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = includes_.find(normalize_path(file));
+    return it != includes_.end() ? it->second : std::vector<std::string>{};
+}
+
+std::vector<std::string> ShaderDependencies::dependents(const std::string& file) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // breadth first over reverse edges, include cycles are visited once
+    std::vector<std::string> result{ normalize_path(file) };
+    std::unordered_set<std::string> visited{ result[0] };
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        auto it = included_by_.find(result[i]);
+        if (it == included_by_.end()) {
+            continue;
+        }
+        for (const auto& parent : it->second)
+        {
+            if (visited.insert(parent).second) {
+                result.push_back(parent);
+            }
+        }
+    }
+    return result;
+}
+
+bool ShaderDependencies::contains(const std::string& file) const
+{
+    const std::string key = normalize_path(file);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return includes_.count(key) != 0 || included_by_.count(key) != 0;
+}
+
+size_t ShaderDependencies::file_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = includes_.size();
+    for (const auto& file : included_by_)
+    {
+        if (includes_.count(file.first) == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
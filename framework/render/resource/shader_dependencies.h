@@ -0,0 +1,37 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Include graph of shader sources: edges from a file to the files it includes, as the compiler
+// opened them (see ShaderInclude). Paths are normalized, so files reported by a file watcher
+// match however the shader spelled them.
+// Standard library only: no device or platform headers, usable by tools and tests on any OS.
+// Safe on any thread.
+class ShaderDependencies final
+{
+public:
+    ShaderDependencies();
+    ~ShaderDependencies();
+
+    ShaderDependencies(const ShaderDependencies&) = delete;
+    ShaderDependencies& operator=(const ShaderDependencies&) = delete;
+
+    // replaces direct includes of file
+    void set_includes(const std::string& file, const std::vector<std::string>& includes);
+    void clear();
+
+    std::vector<std::string> includes(const std::string& file) const;
+    // file and every file which includes it directly or through other includes
+    std::vector<std::string> dependents(const std::string& file) const;
+    bool contains(const std::string& file) const;
+    size_t file_count() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<std::string>> includes_;
+    std::unordered_map<std::string, std::unordered_set<std::string>> included_by_;
+};
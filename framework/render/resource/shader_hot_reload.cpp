@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cassert>
+
+#include "core/game.h"
+#include "core/path.h"
+#include "render/render.h"
+#include "shader_compiler.h"
+#include "shader_hot_reload.h"
+#include "shader_permutations.h"
+
+ShaderHotReload::ShaderHotReload()
+{
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+}
+
+bool ShaderHotReload::start(const std::string& directory)
+{
+    return watcher_.start(directory);
+}
+
+void ShaderHotReload::destroy()
+{
+    watcher_.stop();
+    permutations_.clear();
+}
+
+void ShaderHotReload::add(ShaderPermutations* permutations)
+{
+    assert(std::find(permutations_.begin(), permutations_.end(), permutations) == permutations_.end());
+    permutations_.push_back(permutations);
+}
+
+void ShaderHotReload::remove(ShaderPermutations* permutations)
+{
+    permutations_.erase(std::remove(permutations_.begin(), permutations_.end(), permutations), permutations_.end());
+}
+
+void ShaderHotReload::update()
+{
+    for (const auto& path : watcher_.changes()) {
+        file_changed(path);
+    }
+}
+
+void ShaderHotReload::file_changed(const std::string& path)
+{
+    auto& dependencies = Game::inst()->render().shader_compiler()->dependencies();
+    if (!dependencies.contains(path)) {
+        return; // not read by any shader
+    }
+    ++changes_;
+
+    const auto dependents = dependencies.dependents(path);
+    for (auto permutations : permutations_)
+    {
+        const std::string filename = normalize_path(permutations->filename());
+        if (std::find(dependents.begin(), dependents.end(), filename) != dependents.end())
+        {
+            OutputDebugString(("Reloading " + permutations->filename() + "\n").c_str());
+            permutations->reload();
+            ++reloads_;
+        }
+    }
+}
+
+ShaderHotReload::Stats ShaderHotReload::stats() const
+{
+    return { changes_, reloads_ };
+}
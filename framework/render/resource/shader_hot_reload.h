@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "win32/file_watcher.h"
+
+class ShaderPermutations;
+
+// Recompiles shaders whose sources change on disk. The file watcher reports changed files,
+// the dependency graph of ShaderCompiler maps them to the compiled files which include them,
+// permutations of those files compile their variants again on workers. A new variant replaces
+// the old one when it is compiled; a variant which fails to compile keeps the old one.
+// Render thread.
+class ShaderHotReload final
+{
+public:
+    struct Stats
+    {
+        uint64_t changes; // changed files which are shader sources or includes
+        uint64_t reloads; // reloaded permutations
+    };
+
+    ShaderHotReload();
+    ~ShaderHotReload();
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // watch sources under directory, without it nothing is reloaded
+    bool start(const std::string& directory);
+    void destroy();
+
+    void add(ShaderPermutations* permutations);
+    void remove(ShaderPermutations* permutations);
+
+    // every frame: queue recompilation of changed shaders
+    void update();
+    // changed file given explicitly, e.g. by a watcher of another tool
+    void file_changed(const std::string& path);
+
+    Stats stats() const;
+
+private:
+    FileWatcher watcher_;
+    std::vector<ShaderPermutations*> permutations_;
+    uint64_t changes_{ 0 };
+    uint64_t reloads_{ 0 };
+};
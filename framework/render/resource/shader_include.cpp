@@ -0,0 +1,55 @@
+#include <fstream>
+#include <iterator>
+
+#include "core/path.h"
+#include "shader_include.h"
+
+ShaderInclude::ShaderInclude(const std::string& filename) : filename_{ filename }
+{
+}
+
+ShaderInclude::~ShaderInclude()
+{
+    for (auto& file : open_files_) {
+        delete[] static_cast<const char*>(file.first);
+    }
+}
+
+HRESULT ShaderInclude::Open(D3D_INCLUDE_TYPE /* type */, LPCSTR name, LPCVOID parent_data, LPCVOID* data, UINT* bytes)
+{
+    // parent is nullptr for includes of compiled file
+    auto parent = open_files_.find(parent_data);
+    const std::string& including = parent != open_files_.end() ? parent->second : filename_;
+    const std::string path = directory_of(including) + name;
+    edges_.emplace_back(including, path);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return E_FAIL;
+    }
+    std::string contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    char* buffer = new char[contents.size() + 1];
+    contents.copy(buffer, contents.size());
+    buffer[contents.size()] = '\0';
+    open_files_[buffer] = path;
+
+    *data = buffer;
+    *bytes = UINT(contents.size());
+    return S_OK;
+}
+
+HRESULT ShaderInclude::Close(LPCVOID data)
+{
+    auto it = open_files_.find(data);
+    if (it == open_files_.end()) {
+        return E_FAIL;
+    }
+    delete[] static_cast<const char*>(data);
+    open_files_.erase(it);
+    return S_OK;
+}
+
+const std::vector<std::pair<std::string, std::string>>& ShaderInclude::edges() const
+{
+    return edges_;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <d3dcommon.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Include handler of ShaderCompiler: opens files next to the including file, like the
+// standard handler, and records every include edge for the dependency graph.
+// One instance per compilation.
+class ShaderInclude final : public ID3DInclude
+{
+public:
+    explicit ShaderInclude(const std::string& filename); // compiled file
+    ~ShaderInclude();
+
+    ShaderInclude(const ShaderInclude&) = delete;
+    ShaderInclude& operator=(const ShaderInclude&) = delete;
+
+    HRESULT __stdcall Open(D3D_INCLUDE_TYPE type, LPCSTR name, LPCVOID parent_data, LPCVOID* data, UINT* bytes) override;
+    HRESULT __stdcall Close(LPCVOID data) override;
+
+    // (including file, included file), in order of opening
+    const std::vector<std::pair<std::string, std::string>>& edges() const;
+
+private:
+    std::string filename_;
+    std::unordered_map<const void*, std::string> open_files_; // contents -> path
+    std::vector<std::pair<std::string, std::string>> edges_;
+};
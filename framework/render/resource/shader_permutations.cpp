@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cassert>
+
+#include "core/game.h"
+#include "render/render.h"
+#include "render/d3d11_common.h"
+#include "shader.h"
+#include "shader_hot_reload.h"
+#include "shader_permutations.h"
+
+ShaderPermutations::ShaderPermutations()
+{
+}
+
+ShaderPermutations::~ShaderPermutations()
+{
+}
+
+void ShaderPermutations::initialize(const Desc& desc)
+{
+    assert(variants_.empty());
+    assert(desc.features.size() <= max_features);
+    desc_ = desc;
+    variants_.resize(size_t(1) << desc_.features.size());
+    pipelines_.resize(variants_.size());
+    compiling_.resize(variants_.size());
+    failed_.resize(variants_.size());
+    reload_generations_.resize(variants_.size());
+    Game::inst()->render().shader_hot_reload()->add(this);
+}
+
+void ShaderPermutations::set_pipeline_state(const PipelineState::Desc& desc)
+{
+    has_pipeline_state_ = true;
+    topology_ = desc.topology;
+    has_rasterizer_ = desc.rasterizer != nullptr;
+    if (has_rasterizer_) {
+        rasterizer_ = *desc.rasterizer;
+    }
+    has_blend_ = desc.blend != nullptr;
+    if (has_blend_) {
+        blend_ = *desc.blend;
+    }
+    has_depth_stencil_ = desc.depth_stencil != nullptr;
+    if (has_depth_stencil_) {
+        depth_stencil_ = *desc.depth_stencil;
+    }
+    stencil_ref_ = desc.stencil_ref;
+}
+
+void ShaderPermutations::destroy()
+{
+    // callbacks of queued variants write to shaders
+    auto compiler = Game::inst()->render().shader_compiler();
+    for (const auto& handle : compiling_) {
+        compiler->wait(handle);
+    }
+    compiling_.clear();
+    for (const auto& handle : reloading_) {
+        compiler->wait(handle);
+    }
+    reloading_.clear();
+    Game::inst()->render().shader_hot_reload()->remove(this);
+    for (auto& pipeline : pipelines_)
+    {
+        if (pipeline != nullptr) {
+            pipeline->destroy();
+        }
+    }
+    pipelines_.clear();
+    for (auto& shader : variants_)
+    {
+        if (shader != nullptr) {
+            shader->destroy();
+        }
+    }
+    variants_.clear();
+    failed_.clear();
+    reload_generations_.clear();
+    has_pipeline_state_ = false;
+}
+
+Shader* ShaderPermutations::variant(uint32_t features)
+{
+    assert(features < variants_.size());
+    if (variants_[features] == nullptr) {
+        submit(features);
+    }
+    if (compiling_[features].valid())
+    {
+        Game::inst()->render().shader_compiler()->wait(compiling_[features]);
+        compiling_[features] = {};
+    }
+    return variants_[features].get();
+}
+
+PipelineState* ShaderPermutations::pipeline(uint32_t features)
+{
+    assert(has_pipeline_state_);
+    assert(features < pipelines_.size());
+    auto& pipeline = pipelines_[features];
+    if (pipeline != nullptr) {
+        return pipeline.get();
+    }
+
+    PipelineState::Desc desc;
+    desc.shader = variant(features);
+    desc.topology = topology_;
+    desc.rasterizer = has_rasterizer_ ? &rasterizer_ : nullptr;
+    desc.blend = has_blend_ ? &blend_ : nullptr;
+    desc.depth_stencil = has_depth_stencil_ ? &depth_stencil_ : nullptr;
+    desc.stencil_ref = stencil_ref_;
+    pipeline = std::make_unique<PipelineState>();
+    pipeline->initialize(desc);
+    return pipeline.get();
+}
+
+bool ShaderPermutations::ready(uint32_t features)
+{
+    assert(features < variants_.size());
+    if (variants_[features] == nullptr) {
+        submit(features);
+    }
+    if (compiling_[features].valid())
+    {
+        // callback runs in ShaderCompiler::flush() of a later frame
+        if (!compiling_[features].completed()) {
+            return false;
+        }
+        compiling_[features] = {};
+    }
+    return true;
+}
+
+bool ShaderPermutations::failed(uint32_t features)
+{
+    variant(features);
+    return failed_[features];
+}
+
+void ShaderPermutations::precompile(const std::vector<uint32_t>& variants)
+{
+    for (uint32_t features : variants)
+    {
+        assert(features < variants_.size());
+        if (variants_[features] == nullptr) {
+            submit(features);
+        }
+    }
+}
+
+uint32_t ShaderPermutations::feature(const std::string& name) const
+{
+    for (size_t i = 0; i < desc_.features.size(); ++i)
+    {
+        if (desc_.features[i] == name) {
+            return 1u << i;
+        }
+    }
+    return 0;
+}
+
+uint32_t ShaderPermutations::compiled_count() const
+{
+    uint32_t count = 0;
+    for (const auto& shader : variants_)
+    {
+        if (shader != nullptr) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ShaderPermutations::reload()
+{
+    auto compiler = Game::inst()->render().shader_compiler();
+    for (uint32_t features = 0; features < variants_.size(); ++features)
+    {
+        if (variants_[features] == nullptr) {
+            continue;
+        }
+        // first compilation creates stages of the object which reload swaps
+        compiler->wait(compiling_[features]);
+        // old variant draws until the new one is compiled, failed variant keeps it;
+        // batches finish in any order, only the latest one of the variant is applied
+        const uint32_t generation = ++reload_generations_[features];
+        reloading_.push_back(compiler->submit(requests(features),
+            [this, features, generation](const std::vector<ID3DBlob*>& bytecode) {
+                for (auto stage : bytecode)
+                {
+                    if (stage == nullptr || generation != reload_generations_[features])
+                    {
+                        for (auto compiled : bytecode) {
+                            SAFE_RELEASE(compiled);
+                        }
+                        return;
+                    }
+                }
+                Shader shader;
+                create(shader, bytecode, features);
+                variants_[features]->swap(shader);
+                shader.destroy();
+                failed_[features] = false;
+            }));
+    }
+    // drop handles of finished reloads
+    reloading_.erase(std::remove_if(reloading_.begin(), reloading_.end(),
+                                    [](const ShaderCompiler::Handle& handle) { return handle.completed(); }),
+                     reloading_.end());
+}
+
+const std::string& ShaderPermutations::filename() const
+{
+    return desc_.filename;
+}
+
+std::vector<ShaderCompiler::Request> ShaderPermutations::requests(uint32_t features) const
+{
+    ShaderCompiler::Request request;
+    request.filename = desc_.filename;
+    request.defines = desc_.defines;
+    for (size_t i = 0; i < desc_.features.size(); ++i)
+    {
+        if (features & (1u << i)) {
+            request.defines.emplace_back(desc_.features[i], "1");
+        }
+    }
+
+    std::vector<ShaderCompiler::Request> requests;
+    request.entrypoint = desc_.vs_entrypoint;
+    request.profile = "vs_5_0";
+    requests.push_back(request);
+    if (!desc_.ps_entrypoint.empty())
+    {
+        request.entrypoint = desc_.ps_entrypoint;
+        request.profile = "ps_5_0";
+        requests.push_back(request);
+    }
+    return requests;
+}
+
+void ShaderPermutations::create(Shader& shader, const std::vector<ID3DBlob*>& bytecode, uint32_t features)
+{
+    shader.set_vs_shader(bytecode[0]);
+    if (bytecode.size() > 1) {
+        shader.set_ps_shader(bytecode[1]);
+    }
+    if (!desc_.inputs.empty()) {
+        shader.set_input_layout(desc_.inputs.data(), desc_.inputs.size());
+    }
+#ifndef NDEBUG
+    if (!desc_.name.empty()) {
+        shader.set_name(desc_.features.empty() ? desc_.name : desc_.name + "_" + std::to_string(features));
+    }
+#endif
+}
+
+void ShaderPermutations::submit(uint32_t features)
+{
+    // object outlives callback: destroy() waits for queued variants
+    variants_[features] = std::make_unique<Shader>();
+    Shader* shader = variants_[features].get();
+    compiling_[features] = Game::inst()->render().shader_compiler()->submit(requests(features),
+        [this, shader, features](const std::vector<ID3DBlob*>& bytecode) {
+            for (auto stage : bytecode)
+            {
+                if (stage == nullptr)
+                {
+                    // compiler reported errors, shader stays empty until reload
+                    for (auto compiled : bytecode) {
+                        SAFE_RELEASE(compiled);
+                    }
+                    failed_[features] = true;
+                    return;
+                }
+            }
+            create(*shader, bytecode, features);
+        });
+}
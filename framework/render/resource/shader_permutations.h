@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <d3d11.h>
+
+#include "pipeline_state.h"
+#include "shader_compiler.h"
+
+class Shader;
+
+// Variants of one vertex + pixel shader file selected by feature bits.
+// Bit i of variant defines features[i] macro as "1", defines are passed to every variant.
+// Variants are compiled when first requested (through the shader cache) and kept until destroy(),
+// so only combinations which are drawn cost compilation. precompile() queues variants to the
+// shader compiler without waiting, variant() waits for a queued variant.
+// Variant which fails to compile (errors go to debug output) keeps empty stages until a reload
+// compiles it: failed() tells users to skip its draws, shader and pipeline pointers stay valid.
+// Optional fixed pipeline state gives one PipelineState per variant.
+// Registered in ShaderHotReload from initialize() to destroy().
+// Render thread.
+class ShaderPermutations final
+{
+public:
+    constexpr static uint32_t max_features = 8;
+
+    struct Desc
+    {
+        std::string filename;
+        std::string vs_entrypoint{ "VSMain" };
+        std::string ps_entrypoint{ "PSMain" };
+        std::vector<std::string> features; // macro of bit i
+        std::vector<std::pair<std::string, std::string>> defines; // same in all variants
+        // empty - no input layout, semantic names must outlive permutations
+        std::vector<D3D11_INPUT_ELEMENT_DESC> inputs;
+        std::string name; // debug name, variant bits appended
+    };
+
+    ShaderPermutations();
+    ~ShaderPermutations();
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    void initialize(const Desc& desc);
+    // state of pipeline(), desc.shader is ignored
+    void set_pipeline_state(const PipelineState::Desc& desc);
+    void destroy();
+
+    Shader* variant(uint32_t features);
+    PipelineState* pipeline(uint32_t features);
+    // compiled or failed, without waiting: queues the variant when it was not requested yet
+    bool ready(uint32_t features);
+    // waits for a queued variant as well
+    bool failed(uint32_t features);
+    // compile ahead of first use, on workers
+    void precompile(const std::vector<uint32_t>& variants);
+
+    // compile all created variants again, each replaces the old one when it compiles;
+    // a reload finishing after a later one of the same variant is dropped
+    void reload();
+
+    const std::string& filename() const;
+    uint32_t feature(const std::string& name) const; // bit of declared feature, 0 otherwise
+    uint32_t compiled_count() const; // including queued
+
+private:
+    Desc desc_;
+    std::vector<std::unique_ptr<Shader>> variants_;           // by feature bits
+    std::vector<std::unique_ptr<PipelineState>> pipelines_;   // by feature bits
+    std::vector<ShaderCompiler::Handle> compiling_;          // by feature bits, queued variants
+    std::vector<bool> failed_;                               // by feature bits
+    std::vector<ShaderCompiler::Handle> reloading_;
+    std::vector<uint32_t> reload_generations_;               // by feature bits, latest reload
+
+    std::vector<ShaderCompiler::Request> requests(uint32_t features) const;
+    void create(Shader& shader, const std::vector<ID3DBlob*>& bytecode, uint32_t features);
+    void submit(uint32_t features);
+
+    bool has_pipeline_state_{ false };
+    D3D11_PRIMITIVE_TOPOLOGY topology_{ D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST };
+    bool has_rasterizer_{ false };
+    D3D11_RASTERIZER_DESC rasterizer_{};
+    bool has_blend_{ false };
+    D3D11_BLEND_DESC blend_{};
+    bool has_depth_stencil_{ false };
+    D3D11_DEPTH_STENCIL_DESC depth_stencil_{};
+    UINT stencil_ref_{ 0 };
+};
@@ -0,0 +1,179 @@
+#include <cassert>
+
+#include "core/game.h"
+#include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/d3d11_common.h"
+#include "state_objects.h"
+
+StateObjects::StateObjects()
+{
+}
+
+StateObjects::~StateObjects()
+{
+    assert(samplers_.empty() && rasterizer_states_.empty() && blend_states_.empty() && depth_stencil_states_.empty());
+}
+
+HRESULT StateObjects::sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state)
+{
+    return get(samplers_, desc, state, [](RenderBackend* backend, const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) {
+        return backend->create_sampler_state(desc, state);
+    });
+}
+
+HRESULT StateObjects::rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state)
+{
+    return get(rasterizer_states_, desc, state, [](RenderBackend* backend, const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) {
+        return backend->create_rasterizer_state(desc, state);
+    });
+}
+
+HRESULT StateObjects::blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state)
+{
+    return get(blend_states_, desc, state, [](RenderBackend* backend, const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) {
+        return backend->create_blend_state(desc, state);
+    });
+}
+
+HRESULT StateObjects::depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state)
+{
+    return get(depth_stencil_states_, desc, state, [](RenderBackend* backend, const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) {
+        return backend->create_depth_stencil_state(desc, state);
+    });
+}
+
+void StateObjects::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    trim(samplers_);
+    trim(rasterizer_states_);
+    trim(blend_states_);
+    trim(depth_stencil_states_);
+}
+
+void StateObjects::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    release(samplers_);
+    release(rasterizer_states_);
+    release(blend_states_);
+    release(depth_stencil_states_);
+}
+
+StateObjects::Stats StateObjects::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.requests = requests_;
+    stats.created = created_;
+    stats.alive = uint32_t(samplers_.size() + rasterizer_states_.size() + blend_states_.size() + depth_stencil_states_.size());
+    return stats;
+}
+
+StateObjects::Key<D3D11_SAMPLER_DESC> StateObjects::make_key(const D3D11_SAMPLER_DESC& desc)
+{
+    // no padding in descriptor
+    Key<D3D11_SAMPLER_DESC> key;
+    std::memcpy(&key.desc, &desc, sizeof(desc));
+    return key;
+}
+
+StateObjects::Key<D3D11_RASTERIZER_DESC> StateObjects::make_key(const D3D11_RASTERIZER_DESC& desc)
+{
+    // no padding in descriptor
+    Key<D3D11_RASTERIZER_DESC> key;
+    std::memcpy(&key.desc, &desc, sizeof(desc));
+    return key;
+}
+
+StateObjects::Key<D3D11_BLEND_DESC> StateObjects::make_key(const D3D11_BLEND_DESC& desc)
+{
+    // render target descriptors end with padding, without independent blend only first one is used
+    Key<D3D11_BLEND_DESC> key;
+    std::memset(&key.desc, 0, sizeof(key.desc));
+    key.desc.AlphaToCoverageEnable = desc.AlphaToCoverageEnable;
+    key.desc.IndependentBlendEnable = desc.IndependentBlendEnable;
+    const UINT count = desc.IndependentBlendEnable ? D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+    for (UINT i = 0; i < count; ++i)
+    {
+        const auto& source = desc.RenderTarget[i];
+        auto& target = key.desc.RenderTarget[i];
+        target.BlendEnable = source.BlendEnable;
+        target.SrcBlend = source.SrcBlend;
+        target.DestBlend = source.DestBlend;
+        target.BlendOp = source.BlendOp;
+        target.SrcBlendAlpha = source.SrcBlendAlpha;
+        target.DestBlendAlpha = source.DestBlendAlpha;
+        target.BlendOpAlpha = source.BlendOpAlpha;
+        target.RenderTargetWriteMask = source.RenderTargetWriteMask;
+    }
+    return key;
+}
+
+StateObjects::Key<D3D11_DEPTH_STENCIL_DESC> StateObjects::make_key(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+    // padding after stencil masks
+    Key<D3D11_DEPTH_STENCIL_DESC> key;
+    std::memset(&key.desc, 0, sizeof(key.desc));
+    key.desc.DepthEnable = desc.DepthEnable;
+    key.desc.DepthWriteMask = desc.DepthWriteMask;
+    key.desc.DepthFunc = desc.DepthFunc;
+    key.desc.StencilEnable = desc.StencilEnable;
+    key.desc.StencilReadMask = desc.StencilReadMask;
+    key.desc.StencilWriteMask = desc.StencilWriteMask;
+    key.desc.FrontFace = desc.FrontFace;
+    key.desc.BackFace = desc.BackFace;
+    return key;
+}
+
+template<typename Desc, typename Object, typename Create>
+HRESULT StateObjects::get(Table<Desc, Object>& table, const Desc* desc, Object** object, Create create)
+{
+    Key<Desc> key = make_key(*desc);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_++;
+    auto it = table.find(key);
+    if (it == table.end())
+    {
+        Object* created = nullptr;
+        HRESULT result = create(Game::inst()->render().backend(), desc, &created);
+        if (FAILED(result)) {
+            *object = nullptr;
+            return result;
+        }
+        created_++;
+        it = table.emplace(key, created).first;
+    }
+
+    it->second->AddRef();
+    *object = it->second;
+    return S_OK;
+}
+
+template<typename Desc, typename Object>
+void StateObjects::trim(Table<Desc, Object>& table)
+{
+    for (auto it = table.begin(); it != table.end();)
+    {
+        // reference count after AddRef: 2 - only cache holds object
+        if (it->second->AddRef() == 2) {
+            it->second->Release();
+            SAFE_RELEASE(it->second);
+            it = table.erase(it);
+        } else {
+            it->second->Release();
+            ++it;
+        }
+    }
+}
+
+template<typename Desc, typename Object>
+void StateObjects::release(Table<Desc, Object>& table)
+{
+    for (auto& entry : table) {
+        SAFE_RELEASE(entry.second);
+    }
+    table.clear();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// Sampler, rasterizer, blend and depth stencil state objects shared by descriptor.
+// Requests with equal descriptors (compared by value, unused parts ignored) get the
+// same object, so bound state can be compared by pointer.
+// Returned objects carry a reference of the caller: release them with SAFE_RELEASE
+// as if they were created. The cache keeps own reference until trim() or destroy().
+// Objects are shared with every other user of the same descriptor: do not give them debug names.
+class StateObjects final
+{
+public:
+    struct Stats
+    {
+        uint64_t requests;
+        uint64_t created;
+        uint32_t alive; // objects in cache
+    };
+
+    StateObjects();
+    ~StateObjects();
+
+    StateObjects(const StateObjects&) = delete;
+    StateObjects& operator=(const StateObjects&) = delete;
+
+    HRESULT sampler_state(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state);
+    HRESULT rasterizer_state(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state);
+    HRESULT blend_state(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state);
+    HRESULT depth_stencil_state(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state);
+
+    // release objects which nobody but cache references
+    void trim();
+    void destroy();
+
+    Stats stats() const;
+
+private:
+    // descriptor copy without padding and ignored fields
+    template<typename Desc>
+    struct Key
+    {
+        Desc desc;
+
+        bool operator==(const Key& other) const
+        {
+            return std::memcmp(&desc, &other.desc, sizeof(Desc)) == 0;
+        }
+    };
+    struct KeyHash
+    {
+        template<typename Desc>
+        size_t operator()(const Key<Desc>& key) const
+        {
+            // FNV-1a
+            uint64_t hash = 14695981039346656037ull;
+            auto bytes = reinterpret_cast<const uint8_t*>(&key.desc);
+            for (size_t i = 0; i < sizeof(Desc); ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return size_t(hash);
+        }
+    };
+    template<typename Desc, typename Object>
+    using Table = std::unordered_map<Key<Desc>, Object*, KeyHash>;
+
+    static Key<D3D11_SAMPLER_DESC> make_key(const D3D11_SAMPLER_DESC& desc);
+    static Key<D3D11_RASTERIZER_DESC> make_key(const D3D11_RASTERIZER_DESC& desc);
+    static Key<D3D11_BLEND_DESC> make_key(const D3D11_BLEND_DESC& desc);
+    static Key<D3D11_DEPTH_STENCIL_DESC> make_key(const D3D11_DEPTH_STENCIL_DESC& desc);
+
+    template<typename Desc, typename Object, typename Create>
+    HRESULT get(Table<Desc, Object>& table, const Desc* desc, Object** object, Create create);
+
+    template<typename Desc, typename Object>
+    static void trim(Table<Desc, Object>& table);
+    template<typename Desc, typename Object>
+    static void release(Table<Desc, Object>& table);
+
+    mutable std::mutex mutex_;
+    Table<D3D11_SAMPLER_DESC, ID3D11SamplerState> samplers_;
+    Table<D3D11_RASTERIZER_DESC, ID3D11RasterizerState> rasterizer_states_;
+    Table<D3D11_BLEND_DESC, ID3D11BlendState> blend_states_;
+    Table<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> depth_stencil_states_;
+
+    uint64_t requests_{ 0 };
+    uint64_t created_{ 0 };
+};
@@ -1,14 +1,16 @@
 #include <cassert>
 
+#include <wincodec.h>
 #include <WICTextureLoader.h>
 using namespace DirectX;
 
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "render/d3d11_common.h"
 #include "texture.h"
 
-Texture::Texture()
+Texture::Texture() : Resource(ResourceCategory::texture)
 {
 }
 
@@ -17,18 +19,96 @@ Texture::~Texture()
     destroy(); // for default static material texture
 }
 
+void Texture::set_source(const std::string& path)
+{
+    source_ = path;
+}
+
+void Texture::set_upload_pending(bool pending)
+{
+    upload_pending_.store(pending, std::memory_order_relaxed);
+}
+
 void Texture::load(const std::string& path)
 {
     // load texture color
     assert(!path.empty());
     assert(texture_ == nullptr);
+    source_ = path;
     auto device = Game::inst()->render().device();
-    auto context = Game::inst()->render().context();
+    if (device == nullptr) {
+        // backend without D3D11 device: keep 1x1 placeholder instead of file contents
+        uint32_t pixel = 0xFFFFFFFF;
+        initialize(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &pixel);
+        return;
+    }
     std::wstring filenamew(path.begin(), path.end());
     CreateWICTextureFromFile(device, filenamew.c_str(), (ID3D11Resource**)&texture_, &resource_view_);
 
     assert(texture_ != nullptr);
     assert(resource_view_ != nullptr);
+    D3D11_TEXTURE2D_DESC desc;
+    texture_->GetDesc(&desc);
+    set_resident_bytes(size_t(desc.Width) * desc.Height * 4);
+}
+
+// static
+bool Texture::decode(const std::string& path, Image& image)
+{
+    assert(!path.empty());
+    if (Game::inst()->render().device() == nullptr) {
+        // backend without D3D11 device: 1x1 placeholder like load()
+        image.width = 1;
+        image.height = 1;
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.pixels.assign(4, 0xFF);
+        return true;
+    }
+
+    // job threads may have no COM yet
+    HRESULT com_result = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    IWICImagingFactory* factory = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = nullptr;
+    IWICFormatConverter* converter = nullptr;
+
+    std::wstring filenamew(path.begin(), path.end());
+    UINT width = 0;
+    UINT height = 0;
+    bool decoded =
+        SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))) &&
+        SUCCEEDED(factory->CreateDecoderFromFilename(filenamew.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)) &&
+        SUCCEEDED(decoder->GetFrame(0, &frame)) &&
+        SUCCEEDED(factory->CreateFormatConverter(&converter)) &&
+        SUCCEEDED(converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom)) &&
+        SUCCEEDED(converter->GetSize(&width, &height));
+    if (decoded)
+    {
+        image.width = width;
+        image.height = height;
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.pixels.resize(size_t(width) * height * 4);
+        decoded = SUCCEEDED(converter->CopyPixels(nullptr, width * 4, UINT(image.pixels.size()), image.pixels.data()));
+    }
+
+    SAFE_RELEASE(converter);
+    SAFE_RELEASE(frame);
+    SAFE_RELEASE(decoder);
+    SAFE_RELEASE(factory);
+    if (SUCCEEDED(com_result)) {
+        CoUninitialize();
+    }
+
+    if (!decoded) {
+        OutputDebugString(("Can not decode texture " + path + "\n").c_str());
+    }
+    return decoded;
+}
+
+void Texture::initialize(Image& image)
+{
+    initialize(image.width, image.height, image.format, image.pixels.data());
 }
 
 void Texture::initialize(uint32_t width, uint32_t height, DXGI_FORMAT format, void* pixel_data, D3D11_BIND_FLAG bind_flag)
@@ -73,8 +153,8 @@ void Texture::initialize(uint32_t width, uint32_t height, DXGI_FORMAT format, vo
     }
     subresourceData.SysMemSlicePitch = width * height * 4;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateTexture2D(&desc, &subresourceData, &texture_));
+    auto backend = Game::inst()->render().backend();
+    D3D11_CHECK(backend->create_texture_2d(&desc, &subresourceData, &texture_));
     assert(texture_ != nullptr);
 
     if (!(bind_flag & (D3D11_BIND_RENDER_TARGET))) {
@@ -84,14 +164,17 @@ void Texture::initialize(uint32_t width, uint32_t height, DXGI_FORMAT format, vo
             srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
             srv_desc.Format = DXGI_FORMAT_R32_FLOAT;
             srv_desc.Texture2D.MipLevels = 1;
-            D3D11_CHECK(device->CreateShaderResourceView(texture_, &srv_desc, &resource_view_));
+            D3D11_CHECK(backend->create_shader_resource_view(texture_, &srv_desc, &resource_view_));
         }
         else
         {
-            D3D11_CHECK(device->CreateShaderResourceView(texture_, nullptr, &resource_view_));
+            D3D11_CHECK(backend->create_shader_resource_view(texture_, nullptr, &resource_view_));
         }
         assert(resource_view_ != nullptr);
     }
+    // all supported formats have 4 byte texels
+    set_resident_bytes(size_t(width) * height * 4);
+    upload_pending_.store(false, std::memory_order_relaxed);
 }
 
 void Texture::destroy()
@@ -110,12 +193,13 @@ void Texture::destroy()
         delete[] own_pixel_data_;
         own_pixel_data_ = nullptr;
     }
+    set_resident_bytes(0);
 }
 
 void Texture::bind(UINT slot)
 {
-    auto context = Game::inst()->render().context();
-    context->PSSetShaderResources(slot, 1, &resource_view_);
+    auto backend = Game::inst()->render().backend();
+    backend->ps_set_shader_resources(slot, 1, &resource_view_);
 }
 
 ID3D11Resource* Texture::resource() const
@@ -127,3 +211,46 @@ ID3D11ShaderResourceView* Texture::view() const
 {
     return resource_view_;
 }
+
+bool Texture::evict()
+{
+    if (source_.empty() || restore_job_.valid()) {
+        return false;
+    }
+    destroy();
+    return true;
+}
+
+void Texture::restore()
+{
+    // materials bind default texture until decoded pixels are uploaded by used()
+    auto image = std::make_shared<Image>();
+    std::string source = source_;
+    restore_job_ = Game::inst()->jobs().run([image, source] {
+        Texture::decode(source, *image);
+    });
+    restore_image_ = std::move(image);
+}
+
+void Texture::used(ResourceManager& /* resources */)
+{
+    if (!restore_job_.valid())
+    {
+        // creator dropped it before upload, texture is shared by somebody else
+        if (texture_ == nullptr && !source_.empty() && !upload_pending_.load(std::memory_order_relaxed)) {
+            restore();
+        }
+        return;
+    }
+    if (!restore_job_.finished()) {
+        return;
+    }
+    if (restore_image_->pixels.empty()) {
+        // not decodable: stays default, no further attempts
+        source_.clear();
+    } else if (texture_ == nullptr) {
+        initialize(*restore_image_);
+    }
+    restore_job_ = JobHandle();
+    restore_image_.reset();
+}
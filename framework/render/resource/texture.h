@@ -1,27 +1,64 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 #include <dxgiformat.h>
 #include <d3d11.h>
 
-class Texture
+#include "core/job_system.h"
+#include "resource_manager.h"
+
+// Textures with source file can be evicted, they are decoded again on a job when used.
+// Texture with source which is neither uploaded nor waiting for upload is decoded on first use.
+class Texture : public Resource
 {
 public:
+    // decoded pixels, cpu side of texture
+    struct Image
+    {
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        DXGI_FORMAT format{ DXGI_FORMAT_R8G8B8A8_UNORM };
+        std::vector<uint8_t> pixels;
+    };
+
     Texture();
-    ~Texture();
+    ~Texture() override;
+
+    // decode image file to RGBA8 without GPU, safe on any thread
+    static bool decode(const std::string& path, Image& image);
+
+    // file to decode when evicted texture is used again, load() sets it
+    void set_source(const std::string& path);
+    // creator uploads decoded pixels itself, initialize() clears it
+    void set_upload_pending(bool pending);
 
     void load(const std::string& path);
+    void initialize(Image& image);
     void initialize(uint32_t width, uint32_t height, DXGI_FORMAT format, void* pixel_data, D3D11_BIND_FLAG bind_flag = D3D11_BIND_SHADER_RESOURCE);
-    void destroy();
+    void destroy() override;
 
     void bind(UINT slot);
 
     ID3D11Resource* resource() const;
     ID3D11ShaderResourceView* view() const;
 
+protected:
+    bool evict() override;
+    void restore() override;
+    void used(ResourceManager& resources) override;
+
 private:
     ID3D11Texture2D* texture_{ nullptr };
     ID3D11ShaderResourceView* resource_view_{ nullptr };
 
     void* own_pixel_data_{ nullptr };
+
+    std::string source_;
+    std::atomic<bool> upload_pending_{ false };
+    JobHandle restore_job_;
+    std::shared_ptr<Image> restore_image_; // written by restore job
+
 };
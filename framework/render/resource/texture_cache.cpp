@@ -0,0 +1,79 @@
+#include <cassert>
+
+#include "core/game.h"
+#include "core/path.h"
+#include "render/render.h"
+#include "texture.h"
+#include "texture_cache.h"
+
+TextureCache::TextureCache()
+{
+}
+
+TextureCache::~TextureCache()
+{
+    assert(textures_.empty());
+}
+
+TextureCache::Entry TextureCache::file(const std::string& path)
+{
+    return get(normalize_path(path), path);
+}
+
+TextureCache::Entry TextureCache::embedded(const void* data, size_t size)
+{
+    // FNV-1a of contents, size is part of key
+    uint64_t hash = 14695981039346656037ull;
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    // '*' never appears in file paths
+    return get("*" + std::to_string(hash) + "*" + std::to_string(size), {});
+}
+
+void TextureCache::trim()
+{
+    auto resources = Game::inst()->render().resources();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = textures_.begin(); it != textures_.end();)
+    {
+        if (resources->get(it->second) == nullptr) {
+            it = textures_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureCache::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    textures_.clear();
+}
+
+TextureCache::Stats TextureCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return { requests_, hits_, uint32_t(textures_.size()) };
+}
+
+TextureCache::Entry TextureCache::get(const std::string& key, const std::string& source)
+{
+    auto resources = Game::inst()->render().resources();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++requests_;
+    auto it = textures_.find(key);
+    // entry of released texture is replaced
+    if (it != textures_.end() && resources->try_add_ref(it->second)) {
+        ++hits_;
+        return { it->second, false };
+    }
+
+    auto texture = std::make_unique<Texture>();
+    texture->set_source(source);
+    texture->set_upload_pending(true);
+    ResourceHandle handle = resources->add(std::move(texture));
+    textures_[key] = handle;
+    return { handle, true };
+}
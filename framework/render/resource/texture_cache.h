@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "resource_manager.h"
+
+// Textures shared by source: files by normalised path, embedded textures by content hash.
+// Cache does not own textures, it remembers handles: a texture lives while materials reference
+// it and the next request after that creates it again.
+// Safe on any thread, models look up their textures on loader jobs.
+class TextureCache final
+{
+public:
+    struct Entry
+    {
+        ResourceHandle texture; // carries reference of the caller
+        bool created;           // new texture: caller decodes and uploads pixels
+    };
+
+    struct Stats
+    {
+        uint64_t requests;
+        uint64_t hits;
+        uint32_t entries;
+    };
+
+    TextureCache();
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    Entry file(const std::string& path);
+    Entry embedded(const void* data, size_t size);
+
+    // drop entries of destroyed textures
+    void trim();
+    void destroy();
+
+    Stats stats() const;
+
+private:
+    Entry get(const std::string& key, const std::string& source);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ResourceHandle> textures_;
+    uint64_t requests_{ 0 };
+    uint64_t hits_{ 0 };
+};
@@ -0,0 +1,282 @@
+#include <limits>
+
+#include "core/game.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
+#include "render/render.h"
+#include "asset_loader.h"
+#include "material.h"
+#include "mesh.h"
+#include "model.h"
+
+struct AssetLoader::Request
+{
+    enum class State : uint32_t
+    {
+        parsing,
+        parsed,
+        waiting, // for geometry of another model from same file
+        uploaded,
+        failed,
+    };
+
+    Model* model{ nullptr };
+    Callback callback;
+    std::promise<bool> promise;
+    std::shared_future<bool> future;
+    std::atomic<State> state{ State::parsing };
+    JobHandle job;
+    std::shared_ptr<Request> source; // in flight request of same file, when waiting
+};
+
+AssetLoader::AssetLoader()
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    destroy();
+}
+
+std::shared_future<bool> AssetLoader::load(Model* model, Callback callback)
+{
+    auto request = std::make_shared<Request>();
+    request->model = model;
+    request->callback = std::move(callback);
+    request->future = request->promise.get_future().share();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& other : requests_)
+        {
+            if (other->source == nullptr && other->model->filename() == model->filename()) {
+                request->source = other;
+                break;
+            }
+        }
+        auto geometry = geometries_.find(model->filename());
+        if (request->source != nullptr || (geometry != geometries_.end() && !geometry->second.expired())) {
+            request->state.store(Request::State::waiting, std::memory_order_relaxed);
+        }
+        requests_.push_back(request);
+        if (request->state.load(std::memory_order_relaxed) == Request::State::waiting) {
+            return request->future;
+        }
+        start_parse(request);
+    }
+    return request->future;
+}
+
+void AssetLoader::start_parse(const std::shared_ptr<Request>& request)
+{
+    // background: frame waits do not pick up parse of a whole file
+    request->job = Game::inst()->jobs().run_background([request] {
+        bool parsed = request->model->parse();
+        request->state.store(parsed ? Request::State::parsed : Request::State::failed, std::memory_order_release);
+    });
+}
+
+void AssetLoader::wait_parse()
+{
+    std::vector<JobHandle> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& request : requests_) {
+            jobs.push_back(request->job);
+        }
+    }
+    for (auto& job : jobs) {
+        Game::inst()->jobs().wait(job);
+    }
+}
+
+bool AssetLoader::share(Request& request)
+{
+    std::shared_ptr<ModelGeometry> geometry;
+    if (request.source != nullptr)
+    {
+        auto state = request.source->state.load(std::memory_order_acquire);
+        if (state == Request::State::failed) {
+            request.state.store(Request::State::failed, std::memory_order_release);
+            return true;
+        }
+        if (state != Request::State::uploaded) {
+            return false;
+        }
+        geometry = request.source->model->geometry();
+        request.source.reset();
+    }
+    else
+    {
+        auto it = geometries_.find(request.model->filename());
+        if (it != geometries_.end()) {
+            geometry = it->second.lock();
+        }
+    }
+
+    if (geometry == nullptr) {
+        // every model of this file was unloaded meanwhile
+        return false;
+    }
+    request.model->share(std::move(geometry));
+    request.state.store(Request::State::uploaded, std::memory_order_release);
+    return true;
+}
+
+void AssetLoader::upload()
+{
+    upload(upload_budget_.load(std::memory_order_relaxed));
+}
+
+void AssetLoader::upload(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (requests_.empty()) {
+        return;
+    }
+
+    ProfileScope upload_scope("asset upload");
+    for (auto& request : requests_)
+    {
+        auto state = request->state.load(std::memory_order_acquire);
+        if (state == Request::State::waiting)
+        {
+            // shared geometry costs no upload, requests of same file come after source
+            if (!share(*request) && request->source == nullptr) {
+                request->state.store(Request::State::parsing, std::memory_order_relaxed);
+                start_parse(request);
+            }
+            continue;
+        }
+
+        // oldest requests first, at least one step per frame
+        if (budget > 0 && state == Request::State::parsed) {
+            if (request->model->upload(budget)) {
+                request->state.store(Request::State::uploaded, std::memory_order_release);
+                geometries_[request->model->filename()] = request->model->geometry();
+            }
+        }
+    }
+}
+
+void AssetLoader::update()
+{
+    std::vector<std::shared_ptr<Request>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = requests_.begin(); it != requests_.end();)
+        {
+            auto state = (*it)->state.load(std::memory_order_acquire);
+            if (state == Request::State::uploaded || state == Request::State::failed) {
+                finished.push_back(*it);
+                it = requests_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto& request : finished)
+    {
+        if (request->state.load(std::memory_order_relaxed) == Request::State::failed) {
+            request->promise.set_value(false);
+            continue;
+        }
+
+        request->model->commit();
+        if (request->callback) {
+            request->callback(request->model);
+        }
+        request->promise.set_value(true);
+    }
+}
+
+void AssetLoader::flush()
+{
+    wait_parse();
+    while (pending() > 0)
+    {
+        upload(std::numeric_limits<size_t>::max());
+        // upload starts parsing waiting models whose shared geometry is gone
+        wait_parse();
+        update();
+    }
+}
+
+void AssetLoader::destroy()
+{
+    std::vector<std::shared_ptr<Request>> requests;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests.swap(requests_);
+    }
+    for (auto& request : requests)
+    {
+        // parse writes into model - it must finish before model is unloaded
+        Game::inst()->jobs().wait(request->job);
+        request->promise.set_value(false);
+    }
+
+    Game::inst()->render().resources()->release(placeholder_);
+    placeholder_ = {};
+}
+
+void AssetLoader::set_upload_budget(size_t bytes)
+{
+    upload_budget_.store(bytes, std::memory_order_relaxed);
+}
+
+size_t AssetLoader::upload_budget() const
+{
+    return upload_budget_.load(std::memory_order_relaxed);
+}
+
+size_t AssetLoader::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.size();
+}
+
+Mesh* AssetLoader::placeholder()
+{
+    auto resources = Game::inst()->render().resources();
+    if (!placeholder_)
+    {
+        // unit box around origin, model transform places it
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        const Vector3 normals[] = {
+            { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f },
+            { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f },
+            { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f },
+        };
+        for (const auto& normal : normals)
+        {
+            Vector3 u(normal.y, normal.z, normal.x); // perpendicular axes of the face
+            Vector3 v = normal.Cross(u);
+            auto first = uint32_t(vertices.size());
+            const float corners[4][2] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+            for (const auto& corner : corners)
+            {
+                Vector3 position = (normal + u * corner[0] + v * corner[1]) * 0.5f;
+                Vertex vertex;
+                vertex.position_uv_x = Vector4(position.x, position.y, position.z, (corner[0] + 1.f) * 0.5f);
+                vertex.normal_uv_y = Vector4(normal.x, normal.y, normal.z, (corner[1] + 1.f) * 0.5f);
+                vertices.push_back(vertex);
+            }
+            // both windings: visible with any cull mode
+            const uint32_t face_indices[] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+            for (uint32_t index : face_indices) {
+                indices.push_back(first + index);
+            }
+        }
+
+        auto material = std::make_unique<Material>("placeholder");
+        material->initialize();
+        auto mesh = std::make_unique<Mesh>(vertices, indices, resources->add(std::move(material)));
+        mesh->initialize();
+        placeholder_ = resources->add(std::move(mesh));
+    }
+    resources->use(placeholder_);
+    return resources->get<Mesh>(placeholder_);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "render/resource/resource_manager.h"
+
+class Model;
+class Mesh;
+struct ModelGeometry;
+
+// Streams models in background.
+// Import, vertex conversion and texture decode run as background jobs, GPU resources are created
+// on render thread within per frame byte budget, loaded models are published on
+// simulation thread. Models draw placeholder box until their meshes are uploaded.
+// Models of one file share geometry: only first of them is parsed and uploaded.
+class AssetLoader final
+{
+public:
+    using Callback = std::function<void(Model*)>;
+
+    constexpr static size_t default_upload_budget = 4 << 20; // bytes per frame
+
+    AssetLoader();
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Queue model loading. Callback runs on simulation thread when model becomes resident,
+    // future becomes true then (false if model can not be loaded).
+    std::shared_future<bool> load(Model* model, Callback callback = nullptr);
+
+    // render thread, once per frame: create GPU resources of parsed models
+    void upload();
+    // simulation thread, once per frame: publish uploaded models and run callbacks
+    void update();
+    // Block until all queued models are resident. Runs render and simulation stages
+    // on calling thread - only while frames are not running (initialization, benchmarks).
+    void flush();
+    // wait for parse jobs and drop queued models
+    void destroy();
+
+    void set_upload_budget(size_t bytes);
+    size_t upload_budget() const;
+    size_t pending() const; // queued models which are not resident yet
+
+    // render thread: box drawn instead of models which are not uploaded yet
+    Mesh* placeholder();
+
+private:
+    struct Request;
+
+    void upload(size_t budget);
+    void start_parse(const std::shared_ptr<Request>& request);
+    // parse jobs of queued requests, calling thread helps to run them
+    void wait_parse();
+    // waiting request: use geometry of source request or uploaded earlier,
+    // false while source is not uploaded or when geometry is gone
+    bool share(Request& request);
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Request>> requests_;
+    std::unordered_map<std::string, std::weak_ptr<ModelGeometry>> geometries_; // by filename
+    std::atomic<size_t> upload_budget_{ default_upload_budget };
+
+    ResourceHandle placeholder_;
+};
@@ -0,0 +1,31 @@
+#include "light.h"
+
+void Light::initialize_pipeline(Shader* shader, const D3D11_RASTERIZER_DESC* rasterizer)
+{
+    // lights add up over G-Buffer pixels, depth is read only
+    D3D11_BLEND_DESC blend_desc{};
+    blend_desc.RenderTarget[0].BlendEnable = true;
+    blend_desc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+    blend_desc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+    blend_desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blend_desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blend_desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blend_desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blend_desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+    D3D11_DEPTH_STENCIL_DESC depth_stencil_desc{};
+    depth_stencil_desc.DepthEnable = true;
+    depth_stencil_desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depth_stencil_desc.DepthFunc = D3D11_COMPARISON_LESS;
+
+    CD3D11_RASTERIZER_DESC fullscreen_rasterizer_desc = {};
+    fullscreen_rasterizer_desc.CullMode = D3D11_CULL_NONE;
+    fullscreen_rasterizer_desc.FillMode = D3D11_FILL_SOLID;
+
+    PipelineState::Desc desc;
+    desc.shader = shader;
+    desc.rasterizer = rasterizer != nullptr ? rasterizer : &fullscreen_rasterizer_desc;
+    desc.blend = &blend_desc;
+    desc.depth_stencil = &depth_stencil_desc;
+    pipeline_.initialize(desc);
+}
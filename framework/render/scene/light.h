@@ -11,7 +11,10 @@ using namespace DirectX::SimpleMath;
 
 #include "render/resource/texture.h"
 #include "render/resource/shader.h"
+#include "render/resource/shader_permutations.h"
+#include "render/resource/pipeline_state.h"
 #include "render/resource/buffer.h"
+#include "render/resource/constant_ring.h"
 
 class Light : public GameComponent
 {
@@ -32,6 +35,11 @@ public:
 
 protected:
     Light() = default;
+
+    // light pass pipeline: additive blend, read only depth, rasterizer nullptr - fullscreen triangle
+    void initialize_pipeline(Shader* shader, const D3D11_RASTERIZER_DESC* rasterizer = nullptr);
+
+    PipelineState pipeline_;
 };
 
 class AmbientLight : public Light
@@ -44,14 +52,16 @@ public:
     void imgui() override {};
     void reload() override {};
     void update() override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 private:
-    static std::unique_ptr<Shader> shader_;
+    static std::unique_ptr<ShaderPermutations> shaders_;
 
     struct {
         Vector4 color;
-    } ambient_data_;
-    ConstBuffer ambient_buffer_;
+    } ambient_data_, draw_ambient_data_;
+    ConstantRing::Allocation ambient_allocation_;
     Vector3 color_;
 };
 
@@ -79,20 +89,22 @@ public:
     void imgui() override {};
     void reload() override {};
     void update() override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 
     void set_color(const Vector3& color);
     void set_direction(const Vector3& direction);
 
 private:
-    static std::unique_ptr<Shader> shader_;
+    static std::unique_ptr<ShaderPermutations> shaders_;
 
     struct
     {
         Vector4 color;
         Vector4 direction;
-    } direction_data_;
-    ConstBuffer direction_buffer_;
+    } direction_data_, draw_direction_data_;
+    ConstantRing::Allocation direction_allocation_;
 
     Vector3 color_;
     Vector3 direction_;
@@ -116,17 +128,19 @@ public:
     void imgui() override {};
     void reload() override {};
     void update() override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 
 private:
-    static std::unique_ptr<Shader> shader_;
+    static std::unique_ptr<ShaderPermutations> shaders_;
 
     struct {
         Matrix transform;
         Vector4 color;
         Vector4 position_radius;
-    } point_data_;
-    ConstBuffer point_buffer_;
+    } point_data_, draw_point_data_;
+    ConstantRing::Allocation point_allocation_;
 
     Vector3 color_;
     Vector3 position_;
@@ -136,6 +150,4 @@ private:
     std::vector<uint32_t> indices_;
     Buffer vertex_buffer_;
     Buffer index_buffer_;
-
-    ID3D11RasterizerState* rasterizer_state_{ nullptr };
 };
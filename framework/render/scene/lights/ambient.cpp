@@ -1,31 +1,34 @@
 #include "core/game.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 
 #include "render/scene/light.h"
 
-std::unique_ptr<Shader> AmbientLight::shader_{ nullptr };
+std::unique_ptr<ShaderPermutations> AmbientLight::shaders_{ nullptr };
 
 AmbientLight::AmbientLight(Vector3 color) : color_{ color }
 {
-    if (shader_.get() == nullptr) {
-        // initialize shader_
-        shader_ = std::make_unique<Shader>();
-        shader_->set_vs_shader_from_file("./resources/shaders/deferred/light_pass/ambient.hlsl", "VSMain", nullptr, nullptr);
-        shader_->set_ps_shader_from_file("./resources/shaders/deferred/light_pass/ambient.hlsl", "PSMain", nullptr, nullptr);
-#ifndef NDEBUG
-        shader_->set_name("ambient");
-#endif
+    if (shaders_.get() == nullptr) {
+        // initialize shaders_
+        shaders_ = std::make_unique<ShaderPermutations>();
+        ShaderPermutations::Desc desc;
+        desc.filename = "./resources/shaders/deferred/light_pass/ambient.hlsl";
+        desc.name = "ambient";
+        shaders_->initialize(desc);
+        // compiles on workers until initialize()
+        shaders_->precompile({ 0 });
     }
 }
 
 void AmbientLight::initialize()
 {
-    ambient_buffer_.initialize(sizeof(ambient_data_), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    initialize_pipeline(shaders_->variant(0));
 }
 
 void AmbientLight::destroy_resources()
 {
-    ambient_buffer_.destroy();
+    pipeline_.destroy();
 }
 
 void AmbientLight::update()
@@ -33,16 +36,31 @@ void AmbientLight::update()
     ambient_data_.color.x = color_.x;
     ambient_data_.color.y = color_.y;
     ambient_data_.color.z = color_.z;
-    ambient_buffer_.update_data(&ambient_data_);
+}
+
+void AmbientLight::write_snapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.store(this, ambient_data_);
+}
+
+void AmbientLight::read_snapshot(const FrameSnapshot& snapshot)
+{
+    if (auto data = snapshot.load<decltype(ambient_data_)>(this)) {
+        draw_ambient_data_ = *data;
+    }
+    ambient_allocation_ = Game::inst()->render().constant_ring()->write(&draw_ambient_data_, sizeof(draw_ambient_data_));
 }
 
 void AmbientLight::draw()
 {
-    assert(shader_ != nullptr);
+    if (shaders_->failed(0)) {
+        // errors are in debug output, draws again once reloaded
+        return;
+    }
 
-    shader_->use();
+    pipeline_.apply();
 
-    ambient_buffer_.bind(1U);
+    Game::inst()->render().constant_ring()->bind(ambient_allocation_, 1U);
 
-    Game::inst()->render().context()->Draw(3, 0);
+    Game::inst()->render().backend()->draw(3, 0);
 }
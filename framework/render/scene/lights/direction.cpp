@@ -1,37 +1,36 @@
 #include "core/game.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 
 #include "render/scene/light.h"
 
-std::unique_ptr<Shader> DirectionLight::shader_{ nullptr };
+std::unique_ptr<ShaderPermutations> DirectionLight::shaders_{ nullptr };
 
 DirectionLight::DirectionLight(const Vector3& color, const Vector3& direction)
     : color_{ color }, direction_{ direction }
 {
-    if (shader_.get() == nullptr) {
-        // initialize shader_
-        shader_ = std::make_unique<Shader>();
-        std::string cascade_count_str = std::to_string(Light::shadow_cascade_count);
-        D3D_SHADER_MACRO macro[] = {
-            "CASCADE_COUNT", cascade_count_str.c_str(),
-            nullptr, nullptr
-        };
-        shader_->set_vs_shader_from_file("./resources/shaders/deferred/light_pass/direction.hlsl", "VSMain", macro, nullptr);
-        shader_->set_ps_shader_from_file("./resources/shaders/deferred/light_pass/direction.hlsl", "PSMain", macro, nullptr);
-#ifndef NDEBUG
-        shader_->set_name("direction");
-#endif
+    if (shaders_.get() == nullptr) {
+        // initialize shaders_
+        shaders_ = std::make_unique<ShaderPermutations>();
+        ShaderPermutations::Desc desc;
+        desc.filename = "./resources/shaders/deferred/light_pass/direction.hlsl";
+        desc.defines = { { "CASCADE_COUNT", std::to_string(Light::shadow_cascade_count) } };
+        desc.name = "direction";
+        shaders_->initialize(desc);
+        // compiles on workers until initialize()
+        shaders_->precompile({ 0 });
     }
 }
 
 void DirectionLight::initialize()
 {
-    direction_buffer_.initialize(sizeof(direction_data_));
+    initialize_pipeline(shaders_->variant(0));
 }
 
 void DirectionLight::destroy_resources()
 {
-    direction_buffer_.destroy();
+    pipeline_.destroy();
 }
 
 void DirectionLight::update()
@@ -42,16 +41,32 @@ void DirectionLight::update()
     direction_data_.direction.x = color_.x;
     direction_data_.direction.y = color_.y;
     direction_data_.direction.z = color_.z;
-    direction_buffer_.update_data(&direction_data_);
+}
+
+void DirectionLight::write_snapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.store(this, direction_data_);
+}
+
+void DirectionLight::read_snapshot(const FrameSnapshot& snapshot)
+{
+    if (auto data = snapshot.load<decltype(direction_data_)>(this)) {
+        draw_direction_data_ = *data;
+    }
+    direction_allocation_ = Game::inst()->render().constant_ring()->write(&draw_direction_data_, sizeof(draw_direction_data_));
 }
 
 void DirectionLight::draw()
 {
+    if (shaders_->failed(0)) {
+        // errors are in debug output, draws again once reloaded
+        return;
+    }
+
     // calc shadows
     /// TODO
 
-    assert(shader_ != nullptr);
-    shader_->use();
-    direction_buffer_.bind(1U);
-    Game::inst()->render().context()->Draw(3, 0);
+    pipeline_.apply();
+    Game::inst()->render().constant_ring()->bind(direction_allocation_, 1U);
+    Game::inst()->render().backend()->draw(3, 0);
 }
@@ -1,32 +1,29 @@
 #include "core/game.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "render/d3d11_common.h"
 
 #include "render/scene/light.h"
 
-std::unique_ptr<Shader> PointLight::shader_{ nullptr };
+std::unique_ptr<ShaderPermutations> PointLight::shaders_{ nullptr };
 
 PointLight::PointLight(const Vector3& color, const Vector3& position, float radius) :
     color_{ color }, position_{ position }, radius_{ radius }
 {
-    if (shader_.get() == nullptr) {
-        // initialize shader_
-        shader_ = std::make_unique<Shader>();
-        std::string cascade_count_str = std::to_string(Light::shadow_cascade_count);
-        D3D_SHADER_MACRO macro[] = {
-            "CASCADE_COUNT", cascade_count_str.c_str(),
-            nullptr, nullptr
-        };
-        shader_->set_vs_shader_from_file("./resources/shaders/deferred/light_pass/point.hlsl", "VSMain", macro, nullptr);
-        shader_->set_ps_shader_from_file("./resources/shaders/deferred/light_pass/point.hlsl", "PSMain", macro, nullptr);
-        D3D11_INPUT_ELEMENT_DESC inputs[] =
-        {
+    if (shaders_.get() == nullptr) {
+        // initialize shaders_
+        shaders_ = std::make_unique<ShaderPermutations>();
+        ShaderPermutations::Desc desc;
+        desc.filename = "./resources/shaders/deferred/light_pass/point.hlsl";
+        desc.defines = { { "CASCADE_COUNT", std::to_string(Light::shadow_cascade_count) } };
+        desc.inputs = {
             { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         };
-        shader_->set_input_layout(inputs, std::size(inputs));
-#ifndef NDEBUG
-        shader_->set_name("point");
-#endif
+        desc.name = "point";
+        shaders_->initialize(desc);
+        // compiles on workers until initialize()
+        shaders_->precompile({ 0 });
     }
 }
 
@@ -84,37 +81,36 @@ void PointLight::initialize()
     vertex_buffer_.initialize(D3D11_BIND_VERTEX_BUFFER, vertices_.data(), sizeof(Vector3), uint32_t(vertices_.size()));
     index_buffer_.initialize(D3D11_BIND_INDEX_BUFFER, indices_.data(), sizeof(uint32_t), uint32_t(indices_.size()));
 
-    point_buffer_.initialize(sizeof(point_data_));
-
-    auto device = Game::inst()->render().device();
     CD3D11_RASTERIZER_DESC rast_desc = {};
     rast_desc.CullMode = D3D11_CULL_NONE;
     rast_desc.FillMode = D3D11_FILL_SOLID;
     rast_desc.FrontCounterClockwise = true;
-    D3D11_CHECK(device->CreateRasterizerState(&rast_desc, &rasterizer_state_));
+    initialize_pipeline(shaders_->variant(0), &rast_desc);
 }
 
 void PointLight::destroy_resources()
 {
-    point_buffer_.destroy();
     vertex_buffer_.destroy();
     index_buffer_.destroy();
-    SAFE_RELEASE(rasterizer_state_);
+    pipeline_.destroy();
 }
 
 void PointLight::draw()
 {
+    if (shaders_->failed(0)) {
+        // errors are in debug output, draws again once reloaded
+        return;
+    }
+
     // calc shadows
     /// TODO
 
-    assert(shader_ != nullptr);
-    shader_->use();
-    point_buffer_.bind(1U);
-    auto context = Game::inst()->render().context();
+    pipeline_.apply();
+    Game::inst()->render().constant_ring()->bind(point_allocation_, 1U);
+    auto backend = Game::inst()->render().backend();
     vertex_buffer_.bind();
     index_buffer_.bind();
-    context->RSSetState(rasterizer_state_);
-    context->DrawIndexed(UINT(indices_.size()), 0, 0);
+    backend->draw_indexed(UINT(indices_.size()), 0, 0);
 }
 
 void PointLight::update()
@@ -122,5 +118,17 @@ void PointLight::update()
     point_data_.transform = Matrix::CreateScale(radius_) * Matrix::CreateTranslation(position_);
     point_data_.color = Vector4(color_.x, color_.y, color_.z, 0.f);
     point_data_.position_radius = Vector4(position_.x, position_.y, position_.z, radius_);
-    point_buffer_.update_data(&point_data_);
+}
+
+void PointLight::write_snapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.store(this, point_data_);
+}
+
+void PointLight::read_snapshot(const FrameSnapshot& snapshot)
+{
+    if (auto data = snapshot.load<decltype(point_data_)>(this)) {
+        draw_point_data_ = *data;
+    }
+    point_allocation_ = Game::inst()->render().constant_ring()->write(&draw_point_data_, sizeof(draw_point_data_));
 }
@@ -1,17 +1,18 @@
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "render/d3d11_common.h"
 
+#include "render/resource/resource_manager.h"
+#include "render/resource/state_objects.h"
 #include "render/resource/texture.h"
 #include "material.h"
 
 Texture Material::default_texture_;
+std::atomic<uint32_t> Material::next_sort_id_{ 0 };
 
-Material::Material(const std::string& path) : path_{ path }
+Material::Material(const std::string& path) : path_{ path }, sort_id_{ next_sort_id_++ }
 {
-    if (default_texture_.resource() == nullptr) {
-        default_texture_.initialize(512, 512, DXGI_FORMAT_R8G8B8A8_UNORM, nullptr);
-    }
 }
 
 Material::~Material()
@@ -20,6 +21,11 @@ Material::~Material()
 
 void Material::initialize()
 {
+    // render thread only: materials are constructed on loader jobs
+    if (default_texture_.resource() == nullptr) {
+        default_texture_.initialize(512, 512, DXGI_FORMAT_R8G8B8A8_UNORM, nullptr);
+    }
+
     D3D11_SAMPLER_DESC sampler_desc{};
     sampler_desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
     sampler_desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -28,35 +34,46 @@ void Material::initialize()
     sampler_desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
     sampler_desc.MinLOD = 0;
     sampler_desc.MaxLOD = D3D11_FLOAT32_MAX;
-    D3D11_CHECK(Game::inst()->render().device()->CreateSamplerState(&sampler_desc, &sampler_state_));
+    // same sampler for all materials
+    D3D11_CHECK(Game::inst()->render().state_objects()->sampler_state(&sampler_desc, &sampler_state_));
 }
 
 void Material::bind()
 {
-    auto context = Game::inst()->render().context();
-    context->PSSetSamplers(0, 1, &sampler_state_);
+    auto backend = Game::inst()->render().backend();
+    backend->ps_set_samplers(0, 1, &sampler_state_);
 
     { // Phong
-        // bind defaults, then overwrite
-        default_texture_.bind(1);
-        default_texture_.bind(2);
-        default_texture_.bind(3);
-
-        if (diffuse_) {
-            diffuse_->bind(1);
-        }
-        if (specular_) {
-            specular_->bind(2);
-        }
-        if (ambient_) {
-            ambient_->bind(3);
-        }
+        // one bind per slot: missing textures and textures which are still streaming use default
+        auto resources = Game::inst()->render().resources();
+        auto bound_texture = [resources](ResourceHandle handle) {
+            Texture* texture = resources->get<Texture>(handle);
+            return texture != nullptr && texture->view() != nullptr ? texture : &default_texture_;
+        };
+        bound_texture(diffuse_)->bind(1);
+        bound_texture(specular_)->bind(2);
+        bound_texture(ambient_)->bind(3);
     }
 }
 
 bool Material::is_pbr()
 {
-    return base_color_ != nullptr;
+    return bool(base_color_);
+}
+
+uint32_t Material::sort_id() const
+{
+    return sort_id_;
+}
+
+void Material::used(ResourceManager& resources)
+{
+#define USE_MATERIAL_TYPE(material_type)    \
+    resources.use(material_type##_);
+
+    MATERIALS(USE_MATERIAL_TYPE)
+
+#undef USE_MATERIAL_TYPE
 }
 
 void Material::destroy()
@@ -66,12 +83,10 @@ void Material::destroy()
         sampler_state_ = nullptr;
     }
 
+    auto resources = Game::inst()->render().resources();
 #define DESTROY_MATERIAL_TYPE(material_type)    \
-    if (material_type##_ != nullptr) {          \
-        material_type##_->destroy();            \
-        delete material_type##_;                \
-        material_type##_ = nullptr;             \
-    }
+    resources->release(material_type##_);       \
+    material_type##_ = {};
 
     MATERIALS(DESTROY_MATERIAL_TYPE)
 
@@ -79,11 +94,12 @@ void Material::destroy()
 }
 
 #define TEXTURE_TYPE_IMPL(texture_type) \
-    void Material::set_##texture_type(Texture* texture) {   \
-        texture_type##_ = texture;                          \
-    }                                                       \
-    const Texture* Material::get_##texture_type() const {   \
-        return texture_type##_;                             \
+    void Material::set_##texture_type(ResourceHandle texture) { \
+        Game::inst()->render().resources()->release(texture_type##_); \
+        texture_type##_ = texture;                              \
+    }                                                           \
+    ResourceHandle Material::get_##texture_type() const {       \
+        return texture_type##_;                                 \
     }
 
 TEXTURE_TYPE_IMPL(diffuse)
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
+#include "render/resource/resource_manager.h"
+
+class Texture;
+
 #define MATERIALS(FUNC)     \
     FUNC(diffuse)           \
     FUNC(specular)          \
@@ -21,39 +27,47 @@
     FUNC(diffuse_roughness) \
     FUNC(ambient_occlusion)
 
-class Material
+// Owns the reference of every texture set to it, released when replaced or by destroy()
+class Material : public Resource
 {
 public:
     Material(const std::string& path);
-    ~Material();
+    ~Material() override;
 
     void initialize();
 
-    void destroy();
+    void destroy() override;
 
     void bind();
 
     bool is_pbr();
 
+    uint32_t sort_id() const; // groups draws with this material
+
 #define DECL_MATERIAL_TYPE(material_type)           \
-    void set_##material_type(class Texture*);       \
-    const class Texture* get_##material_type() const;
+    void set_##material_type(ResourceHandle);       \
+    ResourceHandle get_##material_type() const;
 
     MATERIALS(DECL_MATERIAL_TYPE)
 
 #undef DECL_MATERIAL_TYPE
 
+protected:
+    void used(ResourceManager& resources) override;
+
 private:
     std::string path_;
 
 #define MATERIAL_TYPE_PRIVATE_DECL(material_type)   \
-    class Texture* material_type##_{ nullptr };
+    ResourceHandle material_type##_;
 
     MATERIALS(MATERIAL_TYPE_PRIVATE_DECL)
 
 #undef MATERIAL_TYPE_PRIVATE_DECL
 
     ID3D11SamplerState* sampler_state_{ nullptr };
+    const uint32_t sort_id_;
 
     static Texture default_texture_;
+    static std::atomic<uint32_t> next_sort_id_; // materials are created on loader jobs
 };
@@ -1,92 +1,79 @@
+#include <cassert>
+
 #include "core/game.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/resource_manager.h"
 #include "mesh.h"
 
-Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, Material* material) :
-    vertices_{ vertices }, indices_{ indices }, material_{ material }, uniform_data_{}
+std::atomic<uint32_t> Mesh::next_sort_id_{ 0 };
+
+Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ResourceHandle material) :
+    Resource(ResourceCategory::geometry),
+    vertices_{ vertices }, indices_{ indices }, material_{ material }, sort_id_{ next_sort_id_++ }
 {
 }
 
 Mesh::~Mesh()
 {
-    if (material_ != nullptr) {
-        material_->destroy();
-        delete material_;
-        material_ = nullptr;
-    }
 }
 
 void Mesh::initialize()
 {
-    vertex_buffer_.initialize(D3D11_BIND_VERTEX_BUFFER, vertices_.data(), sizeof(vertices_[0]), static_cast<UINT>(vertices_.size()));
-    index_buffer_.initialize(D3D11_BIND_INDEX_BUFFER, indices_.data(), sizeof(indices_[0]), static_cast<UINT>(indices_.size()));
-#ifndef NDEBUG
-    vertex_buffer_.set_name("vertex_buffer");
-    index_buffer_.set_name("index_buffer");
-#endif
-
-    uniform_data_.is_pbr = material_->is_pbr();
-    uniform_data_.material_flags = 0;
-    if (uniform_data_.is_pbr) {
-        if (material_->get_base_color()) {
-            uniform_data_.material_flags |= 1 << 0;
-        }
-
-        if (material_->get_normal_camera()) {
-            uniform_data_.material_flags |= 1 << 1;
-        }
-
-        if (material_->get_emission_color()) {
-            uniform_data_.material_flags |= 1 << 2;
-        }
-
-        if (material_->get_metalness()) {
-            uniform_data_.material_flags |= 1 << 3;
-        }
-
-        if (material_->get_diffuse_roughness()) {
-            uniform_data_.material_flags |= 1 << 4;
-        }
-
-        if (material_->get_ambient_occlusion()) {
-            uniform_data_.material_flags |= 1 << 5;
-        }
-    } else {
-        if (material_->get_diffuse()) {
-            uniform_data_.material_flags |= 1 << 0;
-        }
-
-        if (material_->get_specular()) {
-            uniform_data_.material_flags |= 1 << 1;
-        }
-
-        if (material_->get_ambient()) {
-            uniform_data_.material_flags |= 1 << 2;
-        }
+    assert(geometry_ == GeometryPool::invalid_handle);
+    geometry_ = Game::inst()->render().geometry_pool()->allocate(vertices_.data(), UINT(vertices_.size()),
+                                                                 indices_.data(), UINT(indices_.size()));
+
+    // material textures never change
+    Material* material = this->material();
+    features_ = 0;
+    if (material->get_diffuse()) {
+        features_ |= diffuse_map;
+    }
+    if (material->get_specular()) {
+        features_ |= specular_map;
+    }
+    if (material->get_ambient()) {
+        features_ |= ambient_map;
     }
 
-    uniform_buffer_.initialize(sizeof(uniform_data_), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
-    uniform_buffer_.update_data(&uniform_data_);
+    set_resident_bytes(byte_size());
 }
 
 void Mesh::destroy()
 {
-    uniform_buffer_.destroy();
-    index_buffer_.destroy();
-    vertex_buffer_.destroy();
+    free_geometry();
+    Game::inst()->render().resources()->release(material_);
+    material_ = {};
 }
 
 void Mesh::draw()
 {
-    uniform_buffer_.bind(2);
+    bind();
+    material()->bind();
+
+    auto backend = Game::inst()->render().backend();
+    backend->draw_indexed(index_count(), first_index(), base_vertex());
+}
+
+void Mesh::bind()
+{
+    Game::inst()->render().geometry_pool()->bind(geometry_);
+}
 
-    vertex_buffer_.bind(0);
-    index_buffer_.bind(0);
+UINT Mesh::index_count() const
+{
+    return UINT(indices_.size());
+}
 
-    material_->bind();
+UINT Mesh::first_index() const
+{
+    return Game::inst()->render().geometry_pool()->range(geometry_).first_index;
+}
 
-    auto context = Game::inst()->render().context();
-    context->DrawIndexed(index_buffer_.count(), 0, 0);
+INT Mesh::base_vertex() const
+{
+    return INT(Game::inst()->render().geometry_pool()->range(geometry_).base_vertex);
 }
 
 void Mesh::centrate(Vector3 center)
@@ -98,3 +85,48 @@ void Mesh::centrate(Vector3 center)
         vertex.position_uv_x.z -= center.z;
     }
 }
+
+size_t Mesh::byte_size() const
+{
+    return vertices_.size() * sizeof(vertices_[0]) + indices_.size() * sizeof(indices_[0]);
+}
+
+Material* Mesh::material() const
+{
+    return Game::inst()->render().resources()->get<Material>(material_);
+}
+
+uint32_t Mesh::sort_id() const
+{
+    return sort_id_;
+}
+
+uint32_t Mesh::features() const
+{
+    return features_;
+}
+
+bool Mesh::evict()
+{
+    free_geometry();
+    return true;
+}
+
+void Mesh::restore()
+{
+    initialize();
+}
+
+void Mesh::used(ResourceManager& resources)
+{
+    resources.use(material_);
+}
+
+void Mesh::free_geometry()
+{
+    if (geometry_ != GeometryPool::invalid_handle) {
+        Game::inst()->render().geometry_pool()->free(geometry_);
+        geometry_ = GeometryPool::invalid_handle;
+    }
+    set_resident_bytes(0);
+}
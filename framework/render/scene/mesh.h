@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include <SimpleMath.h>
 using namespace DirectX::SimpleMath;
 
 #include "render/resource/buffer.h"
+#include "render/resource/geometry_pool.h"
+#include "render/resource/resource_manager.h"
 #include "material.h"
 
 struct Vertex
@@ -14,29 +18,56 @@ struct Vertex
     Vector4 normal_uv_y;
 };
 
-class Mesh
+// Owns the reference of its material, released by destroy().
+// Evicted mesh keeps its vertices and indices and uploads them again when used.
+class Mesh : public Resource
 {
 public:
-    Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, Material* material);
-    ~Mesh();
+    // opaque pass shader features, bit i is variant macro i of Scene opaque pass
+    enum Feature : uint32_t
+    {
+        diffuse_map = 1 << 0,
+        specular_map = 1 << 1,
+        ambient_map = 1 << 2,
+    };
+    constexpr static uint32_t feature_count = 3;
+
+    Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ResourceHandle material);
+    ~Mesh() override;
 
     void initialize();
-    void destroy();
+    void destroy() override;
 
     void draw();
+    // vertex and index buffers, material is bound separately
+    void bind();
+    // arguments of DrawIndexed, mesh lives in geometry pool
+    UINT index_count() const;
+    UINT first_index() const;
+    INT base_vertex() const;
 
     void centrate(Vector3 center);
+
+    size_t byte_size() const; // vertex and index data
+    Material* material() const; // nullptr after destroy
+    uint32_t sort_id() const; // groups draws of this mesh
+    uint32_t features() const; // textures of material, known after initialize()
+
+protected:
+    bool evict() override;
+    void restore() override;
+    void used(ResourceManager& resources) override;
+
 private:
+    void free_geometry();
+
     std::vector<Vertex> vertices_;
-    Buffer vertex_buffer_;
     std::vector<uint32_t> indices_;
-    Buffer index_buffer_;
-    Material* material_;
-
-    struct {
-        uint32_t is_pbr;
-        uint32_t material_flags;
-        float dummy[2];
-    } uniform_data_;
-    ConstBuffer uniform_buffer_;
+    GeometryPool::Handle geometry_{ GeometryPool::invalid_handle };
+    ResourceHandle material_;
+
+    uint32_t features_{ 0 };
+
+    const uint32_t sort_id_;
+    static std::atomic<uint32_t> next_sort_id_; // meshes are created on loader jobs
 };
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -6,10 +7,17 @@
 #define NOMINMAX
 
 #include "core/game.h"
+#include "core/frame_snapshot.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
 #include "render/render.h"
 #include "render/camera.h"
 #include "render/annotation.h"
+#include "render/draw_bucket.h"
+#include "render/frustum_culling.h"
 #include "render/resource/texture.h"
+#include "render/resource/texture_cache.h"
+#include "asset_loader.h"
 #include "model.h"
 #include "mesh.h"
 #include "render/d3d11_common.h"
@@ -17,45 +25,163 @@
 // public
 Model::Model(const std::string& filename) :
     filename_{ filename },
-    meshes_{},
+    parsed_min_{ std::numeric_limits<float>::max() },
+    parsed_max_{ std::numeric_limits<float>::lowest() },
     uniform_data_{ Matrix::Identity, Matrix::Identity },
-    min_{ std::numeric_limits<float>::max() },
-    max_{ std::numeric_limits<float>::min() }
+    draw_uniform_data_{ Matrix::Identity, Matrix::Identity },
+    min_{ -0.5f }, // placeholder box until loaded
+    max_{ 0.5f }
 {
 }
 
 void Model::load()
 {
     // check not initialized
-    assert(meshes_.empty());
+    assert(geometry_ == nullptr && pending_meshes_.empty());
+
+    ProfileScope load_scope("model load");
+
+    if (parse())
+    {
+        size_t budget = std::numeric_limits<size_t>::max();
+        upload(budget);
+        commit();
+    }
+}
+
+ModelGeometry::~ModelGeometry()
+{
+    auto resources = Game::inst()->render().resources();
+    for (auto& mesh : meshes) {
+        resources->release(mesh);
+    }
+}
+
+void Model::unload()
+{
+    // meshes are destroyed with last model which shares them
+    geometry_.reset();
+
+    // textures belong to materials of meshes
+    auto resources = Game::inst()->render().resources();
+    for (auto& mesh : pending_meshes_) {
+        resources->release(mesh);
+    }
+    pending_meshes_.clear();
+    // textures shared with other models are decoded on their first use instead
+    for (auto& pending : pending_textures_)
+    {
+        if (auto texture = resources->get<Texture>(pending.texture)) {
+            texture->set_upload_pending(false);
+        }
+    }
+    pending_textures_.clear();
+    uploaded_mesh_count_ = 0;
+
+    resident_ = false;
+    min_ = Vector3(-0.5f);
+    max_ = Vector3(0.5f);
+}
+
+bool Model::parse()
+{
+    ProfileScope parse_scope("model parse");
 
     Assimp::Importer importer;
     auto scene = importer.ReadFile(filename_, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
-    assert(scene != nullptr);
+    if (scene == nullptr) {
+        OutputDebugString(("Can not load model " + filename_ + ": " + importer.GetErrorString() + "\n").c_str());
+        return false;
+    }
     load_node(scene->mRootNode, scene);
 
     // centrate all meshes
-    for (auto& mesh : meshes_)
+    auto resources = Game::inst()->render().resources();
+    for (auto& mesh : pending_meshes_) {
+        resources->get<Mesh>(mesh)->centrate((parsed_max_ + parsed_min_) / 2);
+    }
+
+    // decode texture files in parallel, failed ones stay default
+    Game::inst()->jobs().parallel_for(uint32_t(pending_textures_.size()), 1, [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            auto& pending = pending_textures_[i];
+            if (!pending.path.empty()) {
+                Texture::decode(pending.path, pending.image);
+            }
+        }
+    });
+    return true;
+}
+
+bool Model::upload(size_t& budget)
+{
+    ProfileScope upload_scope("model upload");
+
+    // geometry appears at once, when all meshes are created
+    auto resources = Game::inst()->render().resources();
+    while (uploaded_mesh_count_ < pending_meshes_.size() && budget > 0)
     {
-        mesh->centrate((max_ + min_) / 2);
+        auto mesh = resources->get<Mesh>(pending_meshes_[uploaded_mesh_count_++]);
+        mesh->material()->initialize();
         mesh->initialize();
+        budget -= (std::min)(budget, mesh->byte_size());
+    }
+    if (uploaded_mesh_count_ < pending_meshes_.size()) {
+        return false;
+    }
+    if (geometry_ == nullptr)
+    {
+        geometry_ = std::make_shared<Geometry>();
+        geometry_->meshes.swap(pending_meshes_);
+        geometry_->min = parsed_min_;
+        geometry_->max = parsed_max_;
+        uploaded_mesh_count_ = 0;
     }
 
-    uniform_buffer_.initialize(sizeof(uniform_data_), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    // then textures one by one, materials show default texture meanwhile
+    while (!pending_textures_.empty() && budget > 0)
+    {
+        auto& pending = pending_textures_.back();
+        auto texture = resources->get<Texture>(pending.texture);
+        if (texture != nullptr && !pending.image.pixels.empty()) {
+            texture->initialize(pending.image);
+        }
+        budget -= (std::min)(budget, pending.image.pixels.size());
+        pending_textures_.pop_back();
+    }
+    return pending_textures_.empty();
 }
 
-void Model::unload()
+void Model::commit()
 {
-    // check initialized
-    assert(!meshes_.empty());
+    min_ = parsed_min_;
+    max_ = parsed_max_;
+    resident_ = true;
+}
 
-    uniform_buffer_.destroy();
+std::shared_ptr<Model::Geometry> Model::geometry() const
+{
+    return geometry_;
+}
 
-    for (auto& mesh : meshes_) {
-        mesh->destroy();
-        delete mesh;
-    }
-    meshes_.clear();
+void Model::share(std::shared_ptr<Geometry> geometry)
+{
+    assert(geometry_ == nullptr && pending_meshes_.empty());
+    geometry_ = std::move(geometry);
+    // published by commit like parsed extents
+    parsed_min_ = geometry_->min;
+    parsed_max_ = geometry_->max;
+}
+
+bool Model::resident() const
+{
+    return resident_;
+}
+
+const std::string& Model::filename() const
+{
+    return filename_;
 }
 
 void Model::set_position(Vector3 in_position)
@@ -103,16 +229,83 @@ Quaternion Model::rotation()
     return ret_rotation;
 }
 
-void Model::draw()
+void Model::write_snapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.store(this, uniform_data_);
+}
+
+void Model::read_snapshot(const FrameSnapshot& snapshot)
+{
+    if (auto data = snapshot.load<UniformData>(this)) {
+        draw_uniform_data_ = *data;
+    }
+    uniform_allocation_ = Game::inst()->render().constant_ring()->write(&draw_uniform_data_, sizeof(draw_uniform_data_));
+}
+
+void Model::draw(DrawBucket& bucket, ShaderPermutations& pipelines, uint32_t instanced_feature, const Vector3& camera_position, const Vector3& camera_direction)
 {
-    Annotation annotation("draw:" + filename_);
+    auto constant_ring = Game::inst()->render().constant_ring();
+    if (!constant_ring->valid(uniform_allocation_)) {
+        // drawn without read_snapshot this frame
+        uniform_allocation_ = constant_ring->write(&draw_uniform_data_, sizeof(draw_uniform_data_));
+    }
 
-    uniform_buffer_.update_data(&uniform_data_);
-    uniform_buffer_.bind(1);
+    float depth = (draw_uniform_data_.transform.Translation() - camera_position).Dot(camera_direction);
+    // variant of mesh is ready(): nothing waits for compilation on render thread
+    auto add_mesh = [&](Mesh* mesh) {
+        if (pipelines.failed(mesh->features())) {
+            return;
+        }
+        PipelineState* pipeline = pipelines.pipeline(mesh->features());
+        // instanced variant which is compiling or failed draws one by one
+        const uint32_t instanced_features = mesh->features() | instanced_feature;
+        const bool instanced = instanced_feature != 0 && pipelines.ready(instanced_features) && !pipelines.failed(instanced_features);
+        PipelineState* instanced_pipeline = instanced ? pipelines.pipeline(instanced_features) : nullptr;
+        uint64_t key = DrawBucket::make_key(DrawBucket::Pass::opaque, pipeline->id(), mesh->material()->sort_id(), mesh->sort_id(), depth);
+        bucket.add(key, pipeline, instanced_pipeline, mesh, &uniform_allocation_, &draw_uniform_data_);
+    };
+
+    auto add_placeholder = [&] {
+        Mesh* placeholder = Game::inst()->assets().placeholder();
+        if (pipelines.ready(placeholder->features())) {
+            add_mesh(placeholder);
+        }
+    };
 
-    for (auto& mesh : meshes_) {
-        mesh->draw();
+    if (geometry_ == nullptr) {
+        // not uploaded yet
+        add_placeholder();
+        return;
     }
+
+    // evicted meshes are uploaded again before they are added;
+    // first draw of uploaded model queues variants of its meshes, placeholder is drawn until they compile
+    auto resources = Game::inst()->render().resources();
+    bool compiled = true;
+    for (auto& mesh : geometry_->meshes)
+    {
+        resources->use(mesh);
+        const uint32_t features = resources->get<Mesh>(mesh)->features();
+        compiled = pipelines.ready(features) && compiled;
+        if (instanced_feature != 0) {
+            // queued along, meshes draw one by one until it compiles
+            pipelines.ready(features | instanced_feature);
+        }
+    }
+    if (!compiled) {
+        add_placeholder();
+        return;
+    }
+    for (auto& mesh : geometry_->meshes) {
+        add_mesh(resources->get<Mesh>(mesh));
+    }
+}
+
+void Model::draw_bounds(Vector3& center, Vector3& extent) const
+{
+    // meshes are centered at parse, placeholder is unit box around origin
+    const Vector3 local_extent = geometry_ != nullptr ? (geometry_->max - geometry_->min) * 0.5f : Vector3(0.5f);
+    transform_box(Vector3::Zero, local_extent, draw_uniform_data_.transform, center, extent);
 }
 
 Vector3 Model::extent_min()
@@ -154,6 +347,7 @@ void Model::load_node(aiNode* node, const aiScene* scene)
 
 void Model::load_mesh(aiMesh* mesh, const aiScene* scene)
 {
+    ProfileScope load_mesh_scope("model load mesh");
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
 
@@ -176,24 +370,24 @@ void Model::load_mesh(aiMesh* mesh, const aiScene* scene)
         vertices.push_back(vertex);
 
         // update extents
-        if (min_.x > mesh->mVertices[i].x) {
-            min_.x = mesh->mVertices[i].x;
+        if (parsed_min_.x > mesh->mVertices[i].x) {
+            parsed_min_.x = mesh->mVertices[i].x;
         }
-        if (min_.y > mesh->mVertices[i].y) {
-            min_.y = mesh->mVertices[i].y;
+        if (parsed_min_.y > mesh->mVertices[i].y) {
+            parsed_min_.y = mesh->mVertices[i].y;
         }
-        if (min_.z > mesh->mVertices[i].z) {
-            min_.z = mesh->mVertices[i].z;
+        if (parsed_min_.z > mesh->mVertices[i].z) {
+            parsed_min_.z = mesh->mVertices[i].z;
         }
 
-        if (max_.x < mesh->mVertices[i].x) {
-            max_.x = mesh->mVertices[i].x;
+        if (parsed_max_.x < mesh->mVertices[i].x) {
+            parsed_max_.x = mesh->mVertices[i].x;
         }
-        if (max_.y < mesh->mVertices[i].y) {
-            max_.y = mesh->mVertices[i].y;
+        if (parsed_max_.y < mesh->mVertices[i].y) {
+            parsed_max_.y = mesh->mVertices[i].y;
         }
-        if (max_.z < mesh->mVertices[i].z) {
-            max_.z = mesh->mVertices[i].z;
+        if (parsed_max_.z < mesh->mVertices[i].z) {
+            parsed_max_.z = mesh->mVertices[i].z;
         }
     }
 
@@ -205,24 +399,42 @@ void Model::load_mesh(aiMesh* mesh, const aiScene* scene)
         }
     }
 
-    Material* material = nullptr;
+    auto resources = Game::inst()->render().resources();
+    std::unique_ptr<Material> material;
 
     if (mesh->mMaterialIndex >= 0) {
         auto mat = scene->mMaterials[mesh->mMaterialIndex];
-        material = new Material(mat->GetName().C_Str());
-
-        auto load_texture = [this, &scene](aiString& str) -> Texture* {
-            auto texture = new Texture();
+        material = std::make_unique<Material>(mat->GetName().C_Str());
+
+        // textures are shared through cache and created on upload, here only collect pixels
+        // or files of textures nobody has requested before
+        auto texture_cache = Game::inst()->render().texture_cache();
+        auto load_texture = [this, &scene, texture_cache](aiString& str) -> ResourceHandle {
+            PendingTexture pending;
+            TextureCache::Entry entry;
             auto embedded_texture = scene->GetEmbeddedTexture(str.C_Str());
             if (embedded_texture != nullptr) {
-                if (embedded_texture->mHeight != 0) {
-                    texture->initialize(embedded_texture->mWidth, embedded_texture->mHeight, DXGI_FORMAT_B8G8R8A8_UNORM, embedded_texture->pcData);
+                // compressed embedded textures have mHeight 0 and mWidth bytes
+                const size_t size = embedded_texture->mHeight != 0 ?
+                    size_t(embedded_texture->mWidth) * embedded_texture->mHeight * 4 : embedded_texture->mWidth;
+                entry = texture_cache->embedded(embedded_texture->pcData, size);
+                if (entry.created && embedded_texture->mHeight != 0) {
+                    auto texels = reinterpret_cast<const uint8_t*>(embedded_texture->pcData);
+                    pending.image.width = embedded_texture->mWidth;
+                    pending.image.height = embedded_texture->mHeight;
+                    pending.image.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+                    pending.image.pixels.assign(texels, texels + size);
                 }
             } else {
                 auto model_path = filename_.substr(0, filename_.find_last_of('/') + 1);
-                texture->load((model_path + str.C_Str()).c_str());
+                pending.path = model_path + str.C_Str();
+                entry = texture_cache->file(pending.path);
+            }
+            if (entry.created) {
+                pending.texture = entry.texture;
+                pending_textures_.push_back(std::move(pending));
             }
-            return texture;
+            return entry.texture;
         };
 
         // diffuse
@@ -248,9 +460,9 @@ void Model::load_mesh(aiMesh* mesh, const aiScene* scene)
     }
 
     {
-        material->initialize();
-        auto new_mesh = new Mesh(vertices, indices, material);
-        // new_mesh->initialize();
-        meshes_.push_back(new_mesh);
+        // material and mesh GPU resources are created on upload
+        // mesh takes reference of material
+        auto material_handle = material != nullptr ? resources->add(std::move(material)) : ResourceHandle{};
+        pending_meshes_.push_back(resources->add(std::make_unique<Mesh>(vertices, indices, material_handle)));
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -9,17 +10,50 @@ using namespace DirectX::SimpleMath;
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "render/resource/pipeline_state.h"
 #include "render/resource/shader.h"
+#include "render/resource/shader_permutations.h"
 #include "render/resource/buffer.h"
+#include "render/resource/constant_ring.h"
+#include "render/draw_bucket.h"
+#include "render/resource/resource_manager.h"
+#include "render/resource/texture.h"
+
+// uploaded meshes of one file, shared by all models loaded from it
+struct ModelGeometry
+{
+    std::vector<ResourceHandle> meshes;
+    Vector3 min;
+    Vector3 max;
+
+    ~ModelGeometry(); // render thread: releases meshes
+};
 
 class Model
 {
 public:
+    using Geometry = ModelGeometry;
+
     Model(const std::string& filename);
 
+    // synchronous: all loading stages on calling thread
     void load();
     void unload();
 
+    // Loading stages, AssetLoader runs them on different threads.
+    // Until model is uploaded it draws placeholder box, until committed extents are placeholder's.
+    bool parse();                   // any thread: import file, convert meshes, decode textures
+    bool upload(size_t& budget);    // render thread: create GPU resources while budget lasts, true when done
+    void commit();                  // simulation thread: publish extents of loaded model
+    bool resident() const;          // simulation thread
+
+    // render thread: geometry of uploaded model (nullptr before) and use of geometry
+    // uploaded by another model instead of upload
+    std::shared_ptr<Geometry> geometry() const;
+    void share(std::shared_ptr<Geometry> geometry);
+
+    const std::string& filename() const;
+
     void set_position(Vector3 position);
     void set_scale(Vector3 scale);
     void set_rotation(Quaternion rotation);
@@ -28,7 +62,16 @@ public:
     Vector3 scale();
     Quaternion rotation();
 
-    void draw();
+    // simulation side: store transform
+    void write_snapshot(class FrameSnapshot& snapshot) const;
+    // render side: write transform to constant ring
+    void read_snapshot(const class FrameSnapshot& snapshot);
+    // render side: add draw of every mesh, depth is distance along camera direction.
+    // Pipeline of mesh is variant of its features, draws of shared geometry are merged into
+    // instanced draws with variant which also has instanced_feature (0 - never instanced).
+    void draw(DrawBucket& bucket, ShaderPermutations& pipelines, uint32_t instanced_feature, const Vector3& camera_position, const Vector3& camera_direction);
+    // render side: world box of what draw() adds, for culling
+    void draw_bounds(Vector3& center, Vector3& extent) const;
 
     Vector3 extent_min();
     Vector3 extent_max();
@@ -41,13 +84,26 @@ private:
 
     const std::string filename_; // model filename
 
-    std::vector<class Mesh*> meshes_;
+    std::shared_ptr<Geometry> geometry_; // uploaded, render thread
+
+    // parsed, not uploaded yet
+    struct PendingTexture
+    {
+        ResourceHandle texture; // reference belongs to material
+        std::string path; // empty for embedded texture
+        Texture::Image image;
+    };
+    std::vector<ResourceHandle> pending_meshes_;
+    std::vector<PendingTexture> pending_textures_;
+    size_t uploaded_mesh_count_{ 0 };
+    Vector3 parsed_min_;
+    Vector3 parsed_max_;
+    bool resident_{ false };
 
-    ConstBuffer uniform_buffer_;
-    struct {
-        Matrix transform;
-        Matrix inverse_transpose_transform;
-    } uniform_data_;
+    using UniformData = DrawBucket::Instance;
+    UniformData uniform_data_;  // simulation side
+    UniformData draw_uniform_data_; // render side, last snapshot
+    ConstantRing::Allocation uniform_allocation_;
 
     // model extents
     Vector3 min_;
@@ -1,12 +1,30 @@
+#include <atomic>
+
 #include "core/game.h"
+#include "core/frame_arena.h"
+#include "core/frame_snapshot.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
 #include "win32/win.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
 #include "render/camera.h"
 #include "render/d3d11_common.h"
 #include "render/annotation.h"
+#include "render/draw_bucket.h"
+#include "render/command_list.h"
+#include "render/resource/state_objects.h"
 
 #include "scene.h"
 #include "model.h"
+#include "mesh.h"
+
+namespace
+{
+// last frame's, overwritten by every draw()
+std::atomic<uint32_t> culling_total{ 0 };
+std::atomic<uint32_t> culling_visible{ 0 };
+}
 
 Scene::Scene() : uniform_data_{}
 {
@@ -18,41 +36,43 @@ Scene::~Scene()
 
 void Scene::initialize()
 {
-    auto device = Game::inst()->render().device();
+    auto backend = Game::inst()->render().backend();
+    auto state_objects = Game::inst()->render().state_objects();
 
     {
-        D3D11_INPUT_ELEMENT_DESC inputs[] = {
+        ShaderPermutations::Desc desc;
+        desc.filename = "./resources/shaders/deferred/opaque_pass.hlsl";
+        // order of Mesh::Feature bits
+        desc.features = { "DIFFUSE_MAP", "SPECULAR_MAP", "AMBIENT_MAP", "INSTANCED" };
+        static_assert(Mesh::feature_count == 3, "opaque pass features follow Mesh::Feature");
+        desc.inputs = {
             { "POSITION_UV_X", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
             { "NORMAL_UV_Y", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         };
-        opaque_pass_shader_.set_vs_shader_from_file("./resources/shaders/deferred/opaque_pass.hlsl", "VSMain", nullptr, nullptr);
-        opaque_pass_shader_.set_ps_shader_from_file("./resources/shaders/deferred/opaque_pass.hlsl", "PSMain", nullptr, nullptr);
-        opaque_pass_shader_.set_input_layout(inputs, std::size(inputs));
-#ifndef NDEBUG
-        opaque_pass_shader_.set_name("opaque_pass");
-#endif
+        desc.name = "opaque_pass";
+        opaque_pass_.initialize(desc);
+        instanced_feature_ = opaque_pass_.feature("INSTANCED");
+        // untextured variants draw placeholder and meshes without material,
+        // they compile on workers while the rest of the scene is created
+        opaque_pass_.precompile({ 0, instanced_feature_ });
     }
 
     {
-        present_shader_.set_vs_shader_from_file("./resources/shaders/deferred/present_shader.hlsl", "VSMain", nullptr, nullptr);
-        present_shader_.set_ps_shader_from_file("./resources/shaders/deferred/present_shader.hlsl", "PSMain", nullptr, nullptr);
-#ifndef NDEBUG
-        present_shader_.set_name("present");
-#endif
+        ShaderPermutations::Desc desc;
+        desc.filename = "./resources/shaders/deferred/present_shader.hlsl";
+        desc.name = "present";
+        present_.initialize(desc);
+        present_.precompile({ 0 });
     }
 
     CD3D11_RASTERIZER_DESC opaque_rast_desc = {};
     opaque_rast_desc.CullMode = D3D11_CULL_BACK;
     opaque_rast_desc.FillMode = D3D11_FILL_SOLID;
     opaque_rast_desc.FrontCounterClockwise = true;
-    D3D11_CHECK(device->CreateRasterizerState(&opaque_rast_desc, &opaque_rasterizer_state_));
 
     CD3D11_RASTERIZER_DESC assemble_rast_desc = {};
     assemble_rast_desc.CullMode = D3D11_CULL_NONE;
     assemble_rast_desc.FillMode = D3D11_FILL_SOLID;
-    D3D11_CHECK(device->CreateRasterizerState(&assemble_rast_desc, &assemble_rasterizer_state_));
-
-    uniform_buffer_.initialize(sizeof(uniform_data_), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
 
     D3D11_SAMPLER_DESC tex_sampler_desc{};
     tex_sampler_desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -62,7 +82,7 @@ void Scene::initialize()
     tex_sampler_desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
     tex_sampler_desc.MinLOD = 0;
     tex_sampler_desc.MaxLOD = D3D11_FLOAT32_MAX;
-    D3D11_CHECK(device->CreateSamplerState(&tex_sampler_desc, &texture_sampler_state_));
+    D3D11_CHECK(state_objects->sampler_state(&tex_sampler_desc, &texture_sampler_state_));
 
     // D3D11_SAMPLER_DESC depth_sampler_desc{};
     // depth_sampler_desc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
@@ -72,7 +92,7 @@ void Scene::initialize()
     // depth_sampler_desc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
     // depth_sampler_desc.MinLOD = 0;
     // depth_sampler_desc.MaxLOD = D3D11_FLOAT32_MAX;
-    // D3D11_CHECK(device->CreateSamplerState(&depth_sampler_desc, &depth_sampler_state_));
+    // D3D11_CHECK(backend->create_sampler_state(&depth_sampler_desc, &depth_sampler_state_));
 
     // deferred initialize
     UINT width = UINT(Game::inst()->win().screen_width());
@@ -92,13 +112,13 @@ void Scene::initialize()
     rtv_tex_desc.MiscFlags = 0;
 
     for (uint32_t i = 0; i < gbuffer_count_; ++i) {
-        D3D11_CHECK(device->CreateTexture2D(&rtv_tex_desc, nullptr, &deferred_gbuffers_[i]));
-        D3D11_CHECK(device->CreateRenderTargetView((ID3D11Resource*)deferred_gbuffers_[i], nullptr, &deferred_gbuffers_target_view_[i]));
-        D3D11_CHECK(device->CreateShaderResourceView((ID3D11Resource*)deferred_gbuffers_[i], nullptr, &deferred_gbuffers_view_[i]));
+        D3D11_CHECK(backend->create_texture_2d(&rtv_tex_desc, nullptr, &deferred_gbuffers_[i]));
+        D3D11_CHECK(backend->create_render_target_view((ID3D11Resource*)deferred_gbuffers_[i], nullptr, &deferred_gbuffers_target_view_[i]));
+        D3D11_CHECK(backend->create_shader_resource_view((ID3D11Resource*)deferred_gbuffers_[i], nullptr, &deferred_gbuffers_view_[i]));
     }
-    D3D11_CHECK(device->CreateTexture2D(&rtv_tex_desc, nullptr, &light_buffer_));
-    D3D11_CHECK(device->CreateRenderTargetView((ID3D11Resource*)light_buffer_, nullptr, &light_buffer_target_view_));
-    D3D11_CHECK(device->CreateShaderResourceView((ID3D11Resource*)light_buffer_, nullptr, &light_buffer_view_));
+    D3D11_CHECK(backend->create_texture_2d(&rtv_tex_desc, nullptr, &light_buffer_));
+    D3D11_CHECK(backend->create_render_target_view((ID3D11Resource*)light_buffer_, nullptr, &light_buffer_target_view_));
+    D3D11_CHECK(backend->create_shader_resource_view((ID3D11Resource*)light_buffer_, nullptr, &light_buffer_view_));
 
     D3D11_DEPTH_STENCIL_DESC depth_stencil_desc = {};
     depth_stencil_desc.DepthEnable = true;
@@ -118,7 +138,15 @@ void Scene::initialize()
     depth_stencil_desc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
     depth_stencil_desc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
     depth_stencil_desc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-    D3D11_CHECK(device->CreateDepthStencilState(&depth_stencil_desc, &deferred_depth_state_));
+
+    PipelineState::Desc pipeline_desc;
+    pipeline_desc.rasterizer = &opaque_rast_desc;
+    pipeline_desc.depth_stencil = &depth_stencil_desc;
+    opaque_pass_.set_pipeline_state(pipeline_desc);
+
+    pipeline_desc = PipelineState::Desc{};
+    pipeline_desc.rasterizer = &assemble_rast_desc;
+    present_.set_pipeline_state(pipeline_desc);
 
     D3D11_TEXTURE2D_DESC depth_desc{};
     depth_desc.Width = width;
@@ -132,13 +160,13 @@ void Scene::initialize()
     depth_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
     depth_desc.CPUAccessFlags = 0;
     depth_desc.MiscFlags = 0;
-    D3D11_CHECK(device->CreateTexture2D(&depth_desc, nullptr, &deferred_depth_buffer_));
+    D3D11_CHECK(backend->create_texture_2d(&depth_desc, nullptr, &deferred_depth_buffer_));
 
     D3D11_DEPTH_STENCIL_VIEW_DESC ds_desc{};
     ds_desc.Format = DXGI_FORMAT_D32_FLOAT;
     ds_desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
     ds_desc.Texture2D.MipSlice = 0;
-    D3D11_CHECK(device->CreateDepthStencilView(deferred_depth_buffer_, &ds_desc, &deferred_depth_target_view_));
+    D3D11_CHECK(backend->create_depth_stencil_view(deferred_depth_buffer_, &ds_desc, &deferred_depth_target_view_));
 
     D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc{};
     srv_desc.Format = DXGI_FORMAT_R32_FLOAT;
@@ -147,30 +175,7 @@ void Scene::initialize()
     srv_desc.Texture2DArray.MipLevels = 1;
     srv_desc.Texture2DArray.FirstArraySlice = 0;
     srv_desc.Texture2DArray.ArraySize = 1;
-    D3D11_CHECK(device->CreateShaderResourceView(deferred_depth_buffer_, &srv_desc, &deferred_depth_view_));
-
-    // light pass blend state
-    D3D11_RENDER_TARGET_BLEND_DESC rt_blend_desc;
-    rt_blend_desc.BlendEnable = true;
-    rt_blend_desc.SrcBlend = D3D11_BLEND_ONE;
-    rt_blend_desc.DestBlend = D3D11_BLEND_ONE;
-    rt_blend_desc.BlendOp = D3D11_BLEND_OP_ADD;
-    rt_blend_desc.SrcBlendAlpha = D3D11_BLEND_ONE;
-    rt_blend_desc.DestBlendAlpha = D3D11_BLEND_ONE;
-    rt_blend_desc.BlendOpAlpha = D3D11_BLEND_OP_ADD;
-    rt_blend_desc.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-
-    D3D11_BLEND_DESC blend_desc;
-    blend_desc.AlphaToCoverageEnable = false;
-    blend_desc.IndependentBlendEnable = false;
-    blend_desc.RenderTarget[0] = rt_blend_desc;
-    D3D11_CHECK(device->CreateBlendState(&blend_desc, &light_blend_state_));
-
-    D3D11_DEPTH_STENCIL_DESC light_depth_stencil_desc{};
-    light_depth_stencil_desc.DepthEnable = true;
-    light_depth_stencil_desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-    light_depth_stencil_desc.DepthFunc = D3D11_COMPARISON_LESS;
-    device->CreateDepthStencilState(&light_depth_stencil_desc, &light_depth_state_);
+    D3D11_CHECK(backend->create_shader_resource_view(deferred_depth_buffer_, &srv_desc, &deferred_depth_view_));
 
     for (auto& l : lights_) {
         l->initialize();
@@ -184,12 +189,10 @@ void Scene::destroy()
         l->destroy_resources();
     }
     lights_.clear();
-    uniform_buffer_.destroy();
-    SAFE_RELEASE(opaque_rasterizer_state_);
-    SAFE_RELEASE(assemble_rasterizer_state_);
+    opaque_pass_.destroy();
+    present_.destroy();
     SAFE_RELEASE(texture_sampler_state_);
     // SAFE_RELEASE(depth_sampler_state_);
-    SAFE_RELEASE(deferred_depth_state_);
     SAFE_RELEASE(deferred_depth_view_);
     SAFE_RELEASE(deferred_depth_target_view_);
     SAFE_RELEASE(deferred_depth_buffer_);
@@ -198,7 +201,8 @@ void Scene::destroy()
         SAFE_RELEASE(deferred_gbuffers_view_[i]);
         SAFE_RELEASE(deferred_gbuffers_[i]);
     }
-    opaque_pass_shader_.destroy();
+    instance_buffer_.destroy();
+    instance_capacity_ = 0;
 }
 
 void Scene::add_model(Model* model)
@@ -213,95 +217,162 @@ void Scene::add_light(Light* light)
 
 void Scene::update()
 {
-    auto camera = Game::inst()->render().camera();
-    uniform_data_.view_proj = camera->view_proj();
-    uniform_data_.inv_view_proj = camera->view_proj().Invert();
-    uniform_data_.camera_pos = camera->position();
-    uniform_data_.camera_dir = camera->direction();
+    for (auto& l : lights_) {
+        l->update();
+    }
+}
+
+void Scene::write_snapshot(FrameSnapshot& snapshot) const
+{
+    for (auto& model : models_) {
+        model->write_snapshot(snapshot);
+    }
+    for (auto& l : lights_) {
+        l->write_snapshot(snapshot);
+    }
+}
+
+void Scene::read_snapshot(const FrameSnapshot& snapshot)
+{
+    uniform_data_.view_proj = snapshot.camera.view_proj;
+    uniform_data_.inv_view_proj = snapshot.camera.view_proj.Invert();
+    uniform_data_.camera_pos = snapshot.camera.position;
+    uniform_data_.camera_dir = snapshot.camera.direction;
     uniform_data_.screen_width = Game::inst()->win().screen_width();
     uniform_data_.screen_height = Game::inst()->win().screen_height();
+    uniform_allocation_ = Game::inst()->render().constant_ring()->write(&uniform_data_, sizeof(uniform_data_));
 
+    for (auto& model : models_) {
+        model->read_snapshot(snapshot);
+    }
     for (auto& l : lights_) {
-        l->update();
+        l->read_snapshot(snapshot);
     }
 }
 
 void Scene::draw()
 {
-    auto context = Game::inst()->render().context();
-    auto camera = Game::inst()->render().camera();
+    auto backend = Game::inst()->render().backend();
+    auto constant_ring = Game::inst()->render().constant_ring();
+    if (!constant_ring->valid(uniform_allocation_)) {
+        // no snapshot this frame, keep last camera
+        uniform_allocation_ = constant_ring->write(&uniform_data_, sizeof(uniform_data_));
+    }
 
     // generate G-Buffers
     {
         Annotation annotation("Generate G-Buffers");
-        // restore default render target and depth stencil
+        // clear G-Buffers
         {
-            context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-            context->OMSetRenderTargets(gbuffer_count_, deferred_gbuffers_target_view_, deferred_depth_target_view_);
-
             float clear_color[4] = { 0.f, 0.f, 0.f, 1.f };
             for (uint32_t i = 0; i < gbuffer_count_; ++i) {
-                context->ClearRenderTargetView(deferred_gbuffers_target_view_[i], clear_color);
+                backend->clear_render_target_view(deferred_gbuffers_target_view_[i], clear_color);
             }
 
-            context->OMSetDepthStencilState(deferred_depth_state_, 0);
-            context->ClearDepthStencilView(deferred_depth_target_view_, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0xFF);
-
-            D3D11_VIEWPORT viewport = {};
-            viewport.Width = Game::inst()->win().screen_width();
-            viewport.Height = Game::inst()->win().screen_height();
-            viewport.TopLeftX = 0;
-            viewport.TopLeftY = 0;
-            viewport.MinDepth = 0;
-            viewport.MaxDepth = 1.0f;
-
-            context->RSSetViewports(1, &viewport);
+            backend->clear_depth_stencil_view(deferred_depth_target_view_, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0xFF);
         }
 
-        context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        context->RSSetState(opaque_rasterizer_state_);
-
-        // draw models
-        opaque_pass_shader_.use();
-        uniform_buffer_.update_data(&uniform_data_);
-        uniform_buffer_.bind(0);
+        // draw models inside camera frustum: sorted by state, then front to back
+        auto& arena = *FrameArena::current();
+        Span<uint32_t> visible = arena.allocate_span<uint32_t>(models_.size());
+        uint32_t visible_count = 0;
+        {
+            ProfileScope culling_scope("frustum culling");
+            culling_boxes_.clear();
+            culling_boxes_.reserve(uint32_t(models_.size()));
+            for (auto& model : models_)
+            {
+                Vector3 center, extent;
+                model->draw_bounds(center, extent);
+                culling_boxes_.add(center, extent);
+            }
+            visible_count = culling_boxes_.cull(Frustum::from_view_proj(uniform_data_.view_proj), visible.data());
+        }
+        culling_total = uint32_t(models_.size());
+        culling_visible = visible_count;
 
-        for (auto& model : models_) {
-            model->draw();
+        DrawBucket bucket(arena);
+        for (uint32_t i = 0; i < visible_count; ++i) {
+            models_[visible[i]]->draw(bucket, opaque_pass_, instanced_feature_, uniform_data_.camera_pos, uniform_data_.camera_dir);
         }
+        bucket.sort();
+        if (bucket.instance_count() > instance_capacity_)
+        {
+            while (instance_capacity_ < bucket.instance_count()) {
+                instance_capacity_ = instance_capacity_ == 0 ? 64 : instance_capacity_ * 2;
+            }
+            instance_buffer_.destroy();
+            // default usage: unchanged instances are not uploaded again
+            instance_buffer_.initialize(D3D11_BIND_SHADER_RESOURCE, nullptr, sizeof(DrawBucket::Instance), instance_capacity_);
+        }
+        bucket.prepare(&instance_buffer_);
+
+        // ranges of sorted draws are recorded on job threads and executed in order
+        Game::inst()->render().command_lists()->record(Game::inst()->jobs(), bucket.draw_count(), min_draws_per_command_list_,
+            [this, &bucket](uint32_t begin, uint32_t end) {
+                bind_gbuffer_targets();
+                bucket.submit(&instance_buffer_, begin, end);
+            });
     }
 
     // lights pass
     {
         Annotation annotation("Light pass");
-        context->OMSetBlendState(light_blend_state_, nullptr, 0xFFFFFFFF);
-        context->OMSetRenderTargets(1, &light_buffer_target_view_, deferred_depth_target_view_);
-        context->OMSetDepthStencilState(light_depth_state_, 0);
+        // command lists leave default state behind
+        backend->om_set_render_targets(1, &light_buffer_target_view_, deferred_depth_target_view_);
+        bind_screen_viewport();
         float clear_color[4] = { 0.f, 0.f, 0.f, 1.f };
-        context->ClearRenderTargetView(light_buffer_target_view_, clear_color);
-        context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        context->RSSetState(assemble_rasterizer_state_);
-        context->PSSetShaderResources(0, gbuffer_count_, deferred_gbuffers_view_);
-        // context->PSSetShaderResources(gbuffer_count_, 1, &deferred_depth_view_);
-        context->PSSetSamplers(0, 1, &texture_sampler_state_);
-        uniform_buffer_.bind(0);
+        backend->clear_render_target_view(light_buffer_target_view_, clear_color);
+        backend->ps_set_shader_resources(0, gbuffer_count_, deferred_gbuffers_view_);
+        // backend->ps_set_shader_resources(gbuffer_count_, 1, &deferred_depth_view_);
+        backend->ps_set_samplers(0, 1, &texture_sampler_state_);
+        constant_ring->bind(uniform_allocation_, 0);
 
+        // each light applies own pipeline
         for (auto& l : lights_) {
             l->draw();
         }
     }
 
-    // present
+    // present, failed shader leaves the frame cleared
+    if (!present_.failed(0))
     {
         Annotation annotation("Present pass");
-        context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
         // restore default render target and depth stencil
         Game::inst()->render().prepare_resources();
-        present_shader_.use();
-        context->PSSetShaderResources(0, gbuffer_count_, deferred_gbuffers_view_);
-        context->PSSetShaderResources(gbuffer_count_, 1, &deferred_depth_view_);
-        context->PSSetShaderResources(gbuffer_count_ + 1, 1, &light_buffer_view_);
+        present_.pipeline(0)->apply();
+        backend->ps_set_shader_resources(0, gbuffer_count_, deferred_gbuffers_view_);
+        backend->ps_set_shader_resources(gbuffer_count_, 1, &deferred_depth_view_);
+        backend->ps_set_shader_resources(gbuffer_count_ + 1, 1, &light_buffer_view_);
 
-        context->Draw(3, 0);
+        backend->draw(3, 0);
     }
 }
+
+void Scene::bind_gbuffer_targets()
+{
+    Game::inst()->render().backend()->om_set_render_targets(gbuffer_count_, deferred_gbuffers_target_view_, deferred_depth_target_view_);
+    bind_screen_viewport();
+    Game::inst()->render().constant_ring()->bind(uniform_allocation_, 0);
+}
+
+void Scene::bind_screen_viewport()
+{
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = Game::inst()->win().screen_width();
+    viewport.Height = Game::inst()->win().screen_height();
+    viewport.TopLeftX = 0;
+    viewport.TopLeftY = 0;
+    viewport.MinDepth = 0;
+    viewport.MaxDepth = 1.0f;
+    Game::inst()->render().backend()->rs_set_viewports(1, &viewport);
+}
+
+// static
+Scene::CullingCounters Scene::culling_counters()
+{
+    CullingCounters counters;
+    counters.total = culling_total.load();
+    counters.visible = culling_visible.load();
+    return counters;
+}
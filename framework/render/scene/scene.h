@@ -8,8 +8,12 @@ using namespace DirectX::SimpleMath;
 
 #include "light.h"
 
+#include "render/frustum_culling.h"
 #include "render/resource/buffer.h"
+#include "render/resource/constant_ring.h"
+#include "render/resource/pipeline_state.h"
 #include "render/resource/shader.h"
+#include "render/resource/shader_permutations.h"
 
 class Scene
 {
@@ -27,12 +31,28 @@ public:
     void add_light(Light* light);
 
     void update();
+    // simulation side: store models and lights state
+    void write_snapshot(class FrameSnapshot& snapshot) const;
+    // render side: upload camera, models and lights state
+    void read_snapshot(const class FrameSnapshot& snapshot);
     void draw();
+
+    // models tested by frustum culling and drawn in the last frame
+    struct CullingCounters
+    {
+        uint32_t total;
+        uint32_t visible;
+    };
+    static CullingCounters culling_counters();
 private:
+    // G-Buffers, viewport and frame constants: again in every command list
+    void bind_gbuffer_targets();
+    void bind_screen_viewport();
+
     std::vector<class Model*> models_;
     std::vector<Light*> lights_;
 
-    ConstBuffer uniform_buffer_;
+    ConstantRing::Allocation uniform_allocation_;
     struct
     {
         Matrix view_proj;
@@ -43,16 +63,17 @@ private:
         float screen_height;
     } uniform_data_;
 
-    // opaque pass
-    Shader opaque_pass_shader_;
-    ID3D11RasterizerState* opaque_rasterizer_state_{ nullptr };
-
-    ID3D11DepthStencilState* light_depth_state_{ nullptr };
+    // opaque pass: variants by Mesh::Feature and instanced_feature_
+    ShaderPermutations opaque_pass_;
+    uint32_t instanced_feature_{ 0 };
+    CullingBoxes culling_boxes_; // world boxes of models, by model index
+    StructuredBuffer instance_buffer_; // grows to power of two, uploads changed instances
+    uint32_t instance_capacity_{ 0 };
+    constexpr static uint32_t min_draws_per_command_list_ = 256;
 
     // assemble
-    Shader present_shader_;
+    ShaderPermutations present_;
     ID3D11SamplerState* texture_sampler_state_{ nullptr };
-    ID3D11RasterizerState* assemble_rasterizer_state_{ nullptr };
 
     constexpr static uint32_t gbuffer_count_ = 5;
     // position
@@ -64,13 +85,11 @@ private:
     ID3D11ShaderResourceView* deferred_gbuffers_view_[gbuffer_count_]{ nullptr };
     ID3D11RenderTargetView* deferred_gbuffers_target_view_[gbuffer_count_]{ nullptr };
     // depth
-    ID3D11DepthStencilState* deferred_depth_state_{ nullptr };
     ID3D11Texture2D* deferred_depth_buffer_{ nullptr };
     ID3D11ShaderResourceView* deferred_depth_view_{ nullptr };
     ID3D11DepthStencilView* deferred_depth_target_view_{ nullptr };
 
     // light pass buffer
-    ID3D11BlendState* light_blend_state_{ nullptr };
     ID3D11Texture2D* light_buffer_{ nullptr };
     ID3D11ShaderResourceView* light_buffer_view_{ nullptr };
     ID3D11RenderTargetView* light_buffer_target_view_{ nullptr };
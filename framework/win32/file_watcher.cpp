@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "file_watcher.h"
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+bool FileWatcher::start(const std::string& directory)
+{
+    stop();
+    directory_handle_ = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (directory_handle_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    directory_ = directory;
+    if (!directory_.empty() && directory_.back() != '/' && directory_.back() != '\\') {
+        directory_ += '/';
+    }
+    thread_ = std::thread(&FileWatcher::watch, this);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (thread_.joinable())
+    {
+        SetEvent(stop_event_);
+        thread_.join();
+    }
+    if (stop_event_ != NULL)
+    {
+        CloseHandle(stop_event_);
+        stop_event_ = NULL;
+    }
+    if (directory_handle_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(directory_handle_);
+        directory_handle_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+std::vector<std::string> FileWatcher::changes()
+{
+    std::vector<std::string> changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes.swap(changes_);
+    }
+    // editors write a file in several steps
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    return changes;
+}
+
+void FileWatcher::watch()
+{
+    // DWORD aligned, as ReadDirectoryChangesW requires
+    DWORD buffer[16 * 1024];
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    HANDLE events[] = { overlapped.hEvent, stop_event_ };
+    for (;;)
+    {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(directory_handle_, buffer, sizeof(buffer), TRUE,
+                                   FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                   nullptr, &overlapped, nullptr)) {
+            break;
+        }
+        if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIo(directory_handle_);
+            GetOverlappedResult(directory_handle_, &overlapped, nullptr, TRUE);
+            break;
+        }
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(directory_handle_, &overlapped, &bytes, FALSE)) {
+            break;
+        }
+        if (bytes == 0) {
+            continue; // buffer overflow, changes are lost
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer);
+        for (;;)
+        {
+            if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+            {
+                const int length = int(info->FileNameLength / sizeof(WCHAR));
+                const int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr, nullptr);
+                std::string name(size_t(size), '\0');
+                WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, &name[0], size, nullptr, nullptr);
+                changes_.push_back(directory_ + name);
+            }
+            if (info->NextEntryOffset == 0) {
+                break;
+            }
+            info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const uint8_t*>(info) + info->NextEntryOffset);
+        }
+    }
+    CloseHandle(overlapped.hEvent);
+}
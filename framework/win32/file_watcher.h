@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Windows.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Files written, created or renamed under a directory and its subdirectories.
+// ReadDirectoryChangesW waits on own thread, changes() hands collected paths to any thread.
+class FileWatcher final
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool start(const std::string& directory);
+    void stop();
+
+    // paths (directory + name) changed since previous call, each once
+    std::vector<std::string> changes();
+
+private:
+    void watch();
+
+    std::string directory_;
+    HANDLE directory_handle_{ INVALID_HANDLE_VALUE };
+    HANDLE stop_event_{ NULL };
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::vector<std::string> changes_;
+};
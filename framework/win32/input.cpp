@@ -4,8 +4,14 @@
 #include <string>
 #include "input.h"
 #include "core/game.h"
+#include "core/profiler.h"
 
 Input::Input(HWND hWnd) {
+    if (hWnd == NULL) {
+        // headless: no window to receive raw input
+        return;
+    }
+
     RAWINPUTDEVICE raw_input_devices[2];
     raw_input_devices[0].usUsagePage = HID_USAGE_PAGE_GENERIC;
     raw_input_devices[0].usUsage = HID_USAGE_GENERIC_MOUSE;
@@ -30,6 +36,8 @@ Input::~Input() {}
 
 void Input::handle_win_input(WPARAM wparam, LPARAM lparam)
 {
+    ProfileScope input_scope("input events");
+
     UINT dwSize;
     GetRawInputData((HRAWINPUT)lparam, RID_INPUT, NULL, &dwSize, sizeof(RAWINPUTHEADER));
     BYTE* buffer = (BYTE*)alloca(dwSize);
@@ -52,7 +60,9 @@ void Input::handle_win_input(WPARAM wparam, LPARAM lparam)
         button_state.pressed = (keyboard.Message == WM_KEYDOWN);
         button_state.released = (keyboard.Message == WM_KEYUP);
 
+        std::lock_guard<std::mutex> lock(queue_mutex_);
         keyboard_event_queue_.push({ keyboard.VKey, button_state });
+        queued_event_time_ = std::chrono::steady_clock::now();
     }
     else if (raw_input->header.dwType == RIM_TYPEMOUSE)
     {
@@ -81,7 +91,9 @@ void Input::handle_win_input(WPARAM wparam, LPARAM lparam)
             mouse_state.delta_y = float(mouse.lLastY);
         }
 
+        std::lock_guard<std::mutex> lock(queue_mutex_);
         mouse_event_queue_.push(mouse_state);
+        queued_event_time_ = std::chrono::steady_clock::now();
     }
 
     DefRawInputProc(&raw_input, 1, sizeof(RAWINPUTHEADER));
@@ -89,6 +101,11 @@ void Input::handle_win_input(WPARAM wparam, LPARAM lparam)
 
 void Input::process_win_input()
 {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (!keyboard_event_queue_.empty() || !mouse_event_queue_.empty()) {
+        last_event_time_ = queued_event_time_;
+    }
+
     if (!keyboard_event_queue_.empty())
     {
         KeyboardEvent keyboard_event = keyboard_event_queue_.front();
@@ -168,6 +185,10 @@ void Input::clear_after_process()
 #undef CLEAR_RELEASED
 }
 
+std::chrono::steady_clock::time_point Input::last_event_time() const
+{
+    return last_event_time_;
+}
 
 const Input::MouseState& Input::mouse() const
 {
@@ -178,3 +199,9 @@ const Input::KeyboardState& Input::keyboard() const
 {
     return keyboard_state_;
 }
+
+void Input::set_state(const KeyboardState& keyboard, const MouseState& mouse)
+{
+    keyboard_state_ = keyboard;
+    mouse_state_ = mouse;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Windows.h>
+#include <chrono>
+#include <mutex>
 #include <queue>
 #include <cstdint>
 
@@ -81,17 +83,28 @@ public:
     Input(HWND hWnd);
     ~Input();
 
+    // window thread
     void handle_win_input(WPARAM wparam, LPARAM lparam);
+    // simulation thread (may differ from window thread)
     void process_win_input();
     void clear_after_process(); // call after components handling in game main loop
 
+    // arrival time of the newest queued event at last process_win_input
+    std::chrono::steady_clock::time_point last_event_time() const;
+
     const KeyboardState& keyboard() const;
     const MouseState& mouse() const;
 
+    // replay: replaces state processed from window events for current frame
+    void set_state(const KeyboardState& keyboard, const MouseState& mouse);
+
 private:
     MouseState mouse_state_;
     KeyboardState keyboard_state_;
 
+    std::mutex queue_mutex_; // queues are filled by window thread
     std::queue<KeyboardEvent> keyboard_event_queue_;
     std::queue<MouseState> mouse_event_queue_;
+    std::chrono::steady_clock::time_point queued_event_time_{};
+    std::chrono::steady_clock::time_point last_event_time_{};
 };
@@ -0,0 +1,216 @@
+#include <cstring>
+#include "input_record.h"
+
+namespace
+{
+constexpr char record_magic[4] = { 'I', 'N', 'P', 'R' };
+constexpr uint32_t record_version = 1;
+
+constexpr uint32_t button_count()
+{
+    uint32_t count = 0;
+#define COUNT_BUTTON(button, unused) ++count
+    FOR_EACH_BUTTON(COUNT_BUTTON);
+#undef COUNT_BUTTON
+    return count;
+}
+static_assert(button_count() <= 64, "keyboard state does not fit into record mask");
+
+struct RecordHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t button_count;
+    uint32_t frame_count; // 0 - recorder was not closed, count by file size
+};
+
+#pragma pack(push, 1)
+struct FrameRecord
+{
+    float delta_time;
+    uint64_t keys_pressed;  // bit per button in FOR_EACH_BUTTON order
+    uint64_t keys_released;
+    float mouse_delta[3];
+    uint8_t mouse_buttons;  // pressed and released bits of left, middle, right
+};
+#pragma pack(pop)
+
+FrameRecord pack(const InputFrame& frame)
+{
+    FrameRecord record{};
+    record.delta_time = frame.delta_time;
+
+    uint32_t bit = 0;
+#define PACK_BUTTON(button, unused)                                                 \
+    do {                                                                            \
+        record.keys_pressed |= uint64_t(frame.keyboard.button.pressed) << bit;      \
+        record.keys_released |= uint64_t(frame.keyboard.button.released) << bit;    \
+        ++bit;                                                                      \
+    } while ((void)0, 0)
+    FOR_EACH_BUTTON(PACK_BUTTON);
+#undef PACK_BUTTON
+
+    record.mouse_delta[0] = frame.mouse.delta_x;
+    record.mouse_delta[1] = frame.mouse.delta_y;
+    record.mouse_delta[2] = frame.mouse.delta_z;
+    record.mouse_buttons = uint8_t(frame.mouse.lbutton.pressed << 0 | frame.mouse.lbutton.released << 1 |
+                                   frame.mouse.mbutton.pressed << 2 | frame.mouse.mbutton.released << 3 |
+                                   frame.mouse.rbutton.pressed << 4 | frame.mouse.rbutton.released << 5);
+    return record;
+}
+
+InputFrame unpack(const FrameRecord& record)
+{
+    InputFrame frame;
+    frame.delta_time = record.delta_time;
+
+    uint32_t bit = 0;
+#define UNPACK_BUTTON(button, unused)                                               \
+    do {                                                                            \
+        frame.keyboard.button.pressed = ((record.keys_pressed >> bit) & 1) != 0;    \
+        frame.keyboard.button.released = ((record.keys_released >> bit) & 1) != 0;  \
+        ++bit;                                                                      \
+    } while ((void)0, 0)
+    FOR_EACH_BUTTON(UNPACK_BUTTON);
+#undef UNPACK_BUTTON
+
+    frame.mouse.delta_x = record.mouse_delta[0];
+    frame.mouse.delta_y = record.mouse_delta[1];
+    frame.mouse.delta_z = record.mouse_delta[2];
+    frame.mouse.lbutton.pressed = (record.mouse_buttons & (1 << 0)) != 0;
+    frame.mouse.lbutton.released = (record.mouse_buttons & (1 << 1)) != 0;
+    frame.mouse.mbutton.pressed = (record.mouse_buttons & (1 << 2)) != 0;
+    frame.mouse.mbutton.released = (record.mouse_buttons & (1 << 3)) != 0;
+    frame.mouse.rbutton.pressed = (record.mouse_buttons & (1 << 4)) != 0;
+    frame.mouse.rbutton.released = (record.mouse_buttons & (1 << 5)) != 0;
+    return frame;
+}
+
+RecordHeader make_header(uint32_t frame_count)
+{
+    RecordHeader header{};
+    std::memcpy(header.magic, record_magic, sizeof(record_magic));
+    header.version = record_version;
+    header.button_count = button_count();
+    header.frame_count = frame_count;
+    return header;
+}
+}
+
+// InputRecorder
+InputRecorder::~InputRecorder()
+{
+    close();
+}
+
+bool InputRecorder::open(const std::string& filename)
+{
+    close();
+    file_ = std::fopen(filename.c_str(), "wb");
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    frame_count_ = 0;
+    RecordHeader header = make_header(0);
+    std::fwrite(&header, sizeof(header), 1, file_);
+    return true;
+}
+
+void InputRecorder::write(const InputFrame& frame)
+{
+    if (file_ == nullptr) {
+        return;
+    }
+    FrameRecord record = pack(frame);
+    std::fwrite(&record, sizeof(record), 1, file_);
+    frame_count_++;
+}
+
+void InputRecorder::close()
+{
+    if (file_ == nullptr) {
+        return;
+    }
+    RecordHeader header = make_header(frame_count_);
+    std::fseek(file_, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+uint32_t InputRecorder::frame_count() const
+{
+    return frame_count_;
+}
+
+// InputPlayer
+InputPlayer::~InputPlayer()
+{
+    close();
+}
+
+bool InputPlayer::open(const std::string& filename)
+{
+    close();
+    file_ = std::fopen(filename.c_str(), "rb");
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    RecordHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        std::memcmp(header.magic, record_magic, sizeof(record_magic)) != 0 ||
+        header.version != record_version ||
+        header.button_count != button_count())
+    {
+        close();
+        return false;
+    }
+
+    frame_count_ = header.frame_count;
+    if (frame_count_ == 0)
+    {
+        // recording was interrupted - take all complete records
+        std::fseek(file_, 0, SEEK_END);
+        long size = std::ftell(file_);
+        frame_count_ = uint32_t((size - long(sizeof(RecordHeader))) / long(sizeof(FrameRecord)));
+        std::fseek(file_, long(sizeof(RecordHeader)), SEEK_SET);
+    }
+    frame_index_ = 0;
+    return true;
+}
+
+bool InputPlayer::read(InputFrame& frame)
+{
+    if (file_ == nullptr || frame_index_ >= frame_count_) {
+        return false;
+    }
+
+    FrameRecord record;
+    if (std::fread(&record, sizeof(record), 1, file_) != 1) {
+        frame_count_ = frame_index_;
+        return false;
+    }
+    frame = unpack(record);
+    frame_index_++;
+    return true;
+}
+
+void InputPlayer::close()
+{
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+uint32_t InputPlayer::frame_count() const
+{
+    return frame_count_;
+}
+
+uint32_t InputPlayer::frame_index() const
+{
+    return frame_index_;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "input.h"
+
+// Processed input and simulation step of one frame
+struct InputFrame
+{
+    float delta_time{ 0.f };
+    Input::KeyboardState keyboard;
+    Input::MouseState mouse;
+};
+
+// Binary stream of InputFrame, one record per simulated frame.
+// Layout: header { magic, version, button count, frame count }, then per frame
+// { delta time, pressed keys mask, released keys mask, mouse deltas, mouse buttons mask }.
+// Values are stored in native (little endian) byte order.
+class InputRecorder final
+{
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const std::string& filename);
+    void write(const InputFrame& frame);
+    // writes frame count into header
+    void close();
+
+    uint32_t frame_count() const;
+
+private:
+    FILE* file_{ nullptr };
+    uint32_t frame_count_{ 0 };
+};
+
+class InputPlayer final
+{
+public:
+    InputPlayer() = default;
+    ~InputPlayer();
+
+    InputPlayer(const InputPlayer&) = delete;
+    InputPlayer& operator=(const InputPlayer&) = delete;
+
+    bool open(const std::string& filename);
+    // false when stream is over
+    bool read(InputFrame& frame);
+    void close();
+
+    uint32_t frame_count() const; // frames in stream
+    uint32_t frame_index() const; // frames read
+
+private:
+    FILE* file_{ nullptr };
+    uint32_t frame_count_{ 0 };
+    uint32_t frame_index_{ 0 };
+};
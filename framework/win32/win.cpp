@@ -117,6 +117,16 @@ bool Win::initialize(uint32_t w, uint32_t h)
     return true;
 }
 
+bool Win::initialize_headless(uint32_t w, uint32_t h)
+{
+    width_ = w;
+    height_ = h;
+
+    input_ = new Input(NULL);
+
+    return true;
+}
+
 void Win::run()
 {
     MSG msg{};
@@ -144,6 +154,9 @@ Input* Win::input() const
 
 float Win::screen_width() const
 {
+    if (hWnd_ == NULL) {
+        return static_cast<float>(width_);
+    }
     RECT rc;
     GetWindowRect(Game::inst()->win().window(), &rc);
     return static_cast<float>(rc.right - rc.left);
@@ -151,6 +164,9 @@ float Win::screen_width() const
 
 float Win::screen_height() const
 {
+    if (hWnd_ == NULL) {
+        return static_cast<float>(height_);
+    }
     RECT rc;
     GetWindowRect(Game::inst()->win().window(), &rc);
     return static_cast<float>(rc.bottom - rc.top);
@@ -11,12 +11,18 @@ private:
     HWND hWnd_{ NULL };
     Input* input_{ nullptr };
 
+    // size of headless "window"
+    uint32_t width_{ 0 };
+    uint32_t height_{ 0 };
+
     static LRESULT CALLBACK WndProc(HWND hwnd, UINT umessage, WPARAM wparam, LPARAM lparam);
 public:
     Win() = default;
     ~Win() = default;
 
     bool initialize(uint32_t, uint32_t);
+    // no window: only size and empty input
+    bool initialize_headless(uint32_t, uint32_t);
     void run();
     void destroy();
 
@@ -31,26 +31,49 @@ cbuffer SceneData : register(b0)
     float screen_heght;
 };
 
-cbuffer ModelData : register(b1)
+#ifdef INSTANCED
+struct InstanceData
 {
     float4x4 transform;
     float4x4 inverse_transpose_transform;
 };
+StructuredBuffer<InstanceData> instances : register(t0);
 
-cbuffer MeshData : register(b2)
+cbuffer InstanceOffset : register(b1)
 {
-    uint is_pbr;
-    uint material_flags;
-    float2 MeshData_dummy;
+    uint instance_offset;
+    uint3 InstanceOffset_dummy;
+};
+#else
+cbuffer ModelData : register(b1)
+{
+    float4x4 transform;
+    float4x4 inverse_transpose_transform;
 };
+#endif
 
+// variant features: DIFFUSE_MAP, SPECULAR_MAP, AMBIENT_MAP - material has the texture
+#ifdef DIFFUSE_MAP
 Texture2D<float4> diffuse_tex   : register(t1);
+#endif
+#ifdef SPECULAR_MAP
 Texture2D<float4> specular_tex  : register(t2);
+#endif
+#ifdef AMBIENT_MAP
 Texture2D<float4> ambient_tex   : register(t3);
+#endif
 SamplerState tex_sampler : register(s0);
 
+#ifdef INSTANCED
+PS_IN VSMain(VS_IN input, uint instance_id : SV_InstanceID)
+{
+    // SV_InstanceID does not include start instance
+    float4x4 transform = instances[instance_offset + instance_id].transform;
+    float4x4 inverse_transpose_transform = instances[instance_offset + instance_id].inverse_transpose_transform;
+#else
 PS_IN VSMain(VS_IN input)
 {
+#endif
     PS_IN res = (PS_IN)0;
     res.world_model_pos = mul(transform, float4(input.pos_uv_x.xyz, 1.f));
     res.pos = mul(view_proj, float4(res.world_model_pos.xyz, 1.f));
@@ -72,30 +95,26 @@ PS_OUT PSMain(PS_IN input)
     res.normal = float4(normalize(input.normal.xyz), 1.f);
 
     { // Phong light model
-        float4 diffuse_color = (0).xxxx;
-        float4 specular_color = (0).xxxx;
-        float4 ambient_color = (0).xxxx;
-
-        if (material_flags & 1) {
-            diffuse_color = diffuse_tex.Sample(tex_sampler, input.uv);
-            diffuse_color = pow(abs(diffuse_color), 2.2f);
-        }
-        if (material_flags & 2) {
-            specular_color = specular_tex.Sample(tex_sampler, input.uv);
-        }
-        if (material_flags & 4) {
-            ambient_color = ambient_tex.Sample(tex_sampler, input.uv);
-        }
-
-        if ((material_flags & 7) == 0) { // no material provided - draw gray
-            diffuse_color = float4(.2f, .2f, .2f, 1.f);
-            specular_color = (0.5).xxxx;
-            ambient_color = (0.1).xxxx;
-        }
-
-        res.diffuse = diffuse_color;
-        res.specular = specular_color;
-        res.ambient = ambient_color;
+#if !defined(DIFFUSE_MAP) && !defined(SPECULAR_MAP) && !defined(AMBIENT_MAP)
+        // no material provided - draw gray
+        res.diffuse = float4(.2f, .2f, .2f, 1.f);
+        res.specular = (0.5).xxxx;
+        res.ambient = (0.1).xxxx;
+#else
+        res.diffuse = (0).xxxx;
+        res.specular = (0).xxxx;
+        res.ambient = (0).xxxx;
+#endif
+
+#ifdef DIFFUSE_MAP
+        res.diffuse = pow(abs(diffuse_tex.Sample(tex_sampler, input.uv)), 2.2f);
+#endif
+#ifdef SPECULAR_MAP
+        res.specular = specular_tex.Sample(tex_sampler, input.uv);
+#endif
+#ifdef AMBIENT_MAP
+        res.ambient = ambient_tex.Sample(tex_sampler, input.uv);
+#endif
     }
 
     return res;
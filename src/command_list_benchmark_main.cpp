@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "core/game.h"
+#include "core/job_system.h"
+#include "render/render.h"
+#include "render/command_list.h"
+#include "render/d3d11_common.h"
+#include "render/backend/null_backend.h"
+#include "render/backend/state_cache.h"
+#include "render/resource/constant_ring.h"
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxguid.lib")
+
+namespace
+{
+// vertex buffer, texture and constants per draw, like sorted draw bucket of distinct meshes
+struct DrawResources
+{
+    std::vector<ID3D11Buffer*> vertex_buffers;
+    std::vector<ID3D11Buffer*> index_buffers;
+    std::vector<ID3D11Texture2D*> textures;
+    std::vector<ID3D11ShaderResourceView*> views;
+    std::vector<ConstantRing::Allocation> constants;
+};
+
+void create_resources(DrawResources& resources, uint32_t mesh_count)
+{
+    auto backend = Game::inst()->render().backend();
+    for (uint32_t i = 0; i < mesh_count; ++i)
+    {
+        D3D11_BUFFER_DESC buffer_desc{};
+        buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+        buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        buffer_desc.ByteWidth = 1024;
+        ID3D11Buffer* vertex_buffer = nullptr;
+        D3D11_CHECK(backend->create_buffer(&buffer_desc, nullptr, &vertex_buffer));
+        resources.vertex_buffers.push_back(vertex_buffer);
+
+        buffer_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        ID3D11Buffer* index_buffer = nullptr;
+        D3D11_CHECK(backend->create_buffer(&buffer_desc, nullptr, &index_buffer));
+        resources.index_buffers.push_back(index_buffer);
+
+        D3D11_TEXTURE2D_DESC texture_desc{};
+        texture_desc.Width = 64;
+        texture_desc.Height = 64;
+        texture_desc.MipLevels = 1;
+        texture_desc.ArraySize = 1;
+        texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texture_desc.SampleDesc.Count = 1;
+        texture_desc.Usage = D3D11_USAGE_DEFAULT;
+        texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        ID3D11Texture2D* texture = nullptr;
+        D3D11_CHECK(backend->create_texture_2d(&texture_desc, nullptr, &texture));
+        resources.textures.push_back(texture);
+
+        ID3D11ShaderResourceView* view = nullptr;
+        D3D11_CHECK(backend->create_shader_resource_view(texture, nullptr, &view));
+        resources.views.push_back(view);
+    }
+}
+
+void destroy_resources(DrawResources& resources)
+{
+    for (auto& buffer : resources.vertex_buffers) {
+        SAFE_RELEASE(buffer);
+    }
+    for (auto& buffer : resources.index_buffers) {
+        SAFE_RELEASE(buffer);
+    }
+    for (auto& texture : resources.textures) {
+        SAFE_RELEASE(texture);
+    }
+    for (auto& view : resources.views) {
+        SAFE_RELEASE(view);
+    }
+}
+}
+
+// usage: command_list_benchmark [draw_count] [mesh_count] [frame_count] [draws_per_list]
+// records draws into command lists with 1..hardware_concurrency job threads on null render backend,
+// prints CPU submission time per frame. Calls reaching the backend do not depend on thread count,
+// only state calls issued at the start of every list grow with list count.
+int main(int argc, char** argv)
+{
+    const uint32_t draw_count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 20000;
+    const uint32_t mesh_count = argc > 2 ? uint32_t(std::atoi(argv[2])) : 256;
+    const uint32_t frame_count = argc > 3 ? uint32_t(std::atoi(argv[3])) : 100;
+    const uint32_t draws_per_list = argc > 4 ? uint32_t(std::atoi(argv[4])) : 256;
+
+    const uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    Game::inst()->initialize_headless(800, 800);
+    auto& render = Game::inst()->render();
+    auto state_cache = render.state_cache();
+    auto null_backend = static_cast<NullBackend*>(state_cache->backend());
+    auto constant_ring = render.constant_ring();
+
+    DrawResources resources;
+    create_resources(resources, mesh_count);
+    resources.constants.resize(draw_count);
+
+    auto record = [&resources, mesh_count](uint32_t begin, uint32_t end) {
+        auto backend = Game::inst()->render().backend();
+        auto constant_ring = Game::inst()->render().constant_ring();
+        const UINT stride = 32;
+        const UINT offset = 0;
+        backend->ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            // neighbour draws share mesh, like sorted bucket
+            const uint32_t mesh = uint32_t(uint64_t(i) * mesh_count / resources.constants.size());
+            backend->ia_set_vertex_buffers(0, 1, &resources.vertex_buffers[mesh], &stride, &offset);
+            backend->ia_set_index_buffer(resources.index_buffers[mesh], DXGI_FORMAT_R32_UINT, 0);
+            backend->ps_set_shader_resources(1, 1, &resources.views[mesh]);
+            constant_ring->bind(resources.constants[i], 1);
+            backend->draw_indexed(36, 0, 0);
+        }
+    };
+
+    std::printf("draws: %u, meshes: %u, frames: %u, draws per list: %u\n", draw_count, mesh_count, frame_count, draws_per_list);
+    std::printf("%8s %8s %14s %10s %14s %14s\n", "threads", "lists", "ms per frame", "speedup", "draws/frame", "states/frame");
+
+    double single_thread_ms = 0.0;
+    for (uint32_t thread_count = 1; thread_count <= max_threads; ++thread_count)
+    {
+        JobSystem jobs(thread_count);
+        null_backend->reset();
+        state_cache->reset_counters();
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            state_cache->clear_state();
+            constant_ring->begin_frame();
+            for (uint32_t i = 0; i < draw_count; ++i)
+            {
+                const float constants[16] = { float(i), float(frame) };
+                resources.constants[i] = constant_ring->write(constants, sizeof(constants));
+            }
+            render.command_lists()->record(jobs, draw_count, draws_per_list, record);
+            state_cache->end_frame();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / frame_count;
+        if (thread_count == 1) {
+            single_thread_ms = frame_ms;
+        }
+
+        uint64_t issued_states = 0;
+        const StateCache::Counters& counters = state_cache->total_counters();
+        for (uint32_t i = 0; i < uint32_t(StateCache::State::count); ++i) {
+            issued_states += counters.issued[i];
+        }
+        const uint64_t draws = null_backend->counter(NullBackend::Call::draw_indexed);
+        std::printf("%8u %8u %14.3f %10.2f %14.1f %14.1f\n", thread_count, render.command_lists()->last_range_count(), frame_ms,
+                    single_thread_ms / frame_ms, double(draws) / frame_count, double(issued_states) / frame_count);
+    }
+
+    destroy_resources(resources);
+    Game::inst()->destroy();
+
+    return 0;
+}
@@ -10,6 +10,8 @@
 #include <tiny_gltf.h>
 
 #include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/state_objects.h"
 #include "render/camera.h"
 #include "render/annotation.h"
 #include "core/game.h"
@@ -269,13 +271,7 @@ void GLTFModelComponent::initialize()
     rastDesc.CullMode = D3D11_CULL_NONE;
     rastDesc.FillMode = D3D11_FILL_SOLID; // D3D11_FILL_WIREFRAME;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateRasterizerState(&rastDesc, &rasterizer_state_));
-
-#ifndef NDEBUG
-    std::string rasterizer_state_name = "gltf_rasterizer_state";
-    rasterizer_state_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(rasterizer_state_name.size()), rasterizer_state_name.c_str());
-#endif
+    D3D11_CHECK(Game::inst()->render().state_objects()->rasterizer_state(&rastDesc, &rasterizer_state_));
 
     uniform_buffer_.initialize(sizeof(UniformData), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
 #ifndef NDEBUG
@@ -286,12 +282,12 @@ void GLTFModelComponent::initialize()
 void GLTFModelComponent::draw()
 {
     Annotation annotation("gltf model draw");
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
     auto device = Game::inst()->render().device();
 
     shader_.use();
 
-    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    backend->ia_set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     vertices_.buffer.bind();
     indices_.buffer.bind();
@@ -305,13 +301,13 @@ void GLTFModelComponent::draw()
     uniform_buffer_.update_data(&data);
     uniform_buffer_.bind(0);
 
-    context->RSSetState(rasterizer_state_);
+    backend->rs_set_state(rasterizer_state_);
 
     for (auto& node : nodes_)
     {
         for (auto& primitive: node.mesh.primitives)
         {
-            context->DrawIndexed(primitive.indexCount, primitive.firstIndex, 0);
+            backend->draw_indexed(primitive.indexCount, primitive.firstIndex, 0);
         }
     }
 }
@@ -1,7 +1,10 @@
 #include "katamari_component.h"
 #include "core/game.h"
+#include "core/job_system.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
 #include "render/camera.h"
+#include "render/scene/asset_loader.h"
 #include "render/scene/scene.h"
 #include "render/scene/model.h"
 #include "win32/win.h"
@@ -38,7 +41,7 @@ void KatamariComponent::initialize()
         plane_->set_scale(Vector3(10.f));
         plane_->set_rotation(Quaternion::CreateFromAxisAngle(Vector3(1.f, 0.f, 0.f), 1.57079632679f));
         scene_->add_model(plane_);
-        plane_->load();
+        Game::inst()->assets().load(plane_);
     }
 
     // { // setup free objects
@@ -75,22 +78,35 @@ void KatamariComponent::initialize()
     //     scene_->add_model(free_models_.back());
     // }
 
+    // models stream in, placeholders roll until then
+    radius_t_ = 1.f;
     for (auto& model : attached_models_) {
-        model.model->load();
-        radius_a_ = model.model->radius();
-        radius_b_ = model.model->radius();
-        radius_t_ = 1.f;
-        Vector3 pos = model.model->position();
-        model.model->set_position(Vector3(pos.x, model.model->radius(), pos.z));
+        Game::inst()->assets().load(model.model, [this](Model* loaded) {
+            radius_a_ = loaded->radius();
+            radius_b_ = loaded->radius();
+            radius_t_ = 1.f;
+            Vector3 pos = loaded->position();
+            loaded->set_position(Vector3(pos.x, loaded->radius(), pos.z));
+        });
     }
 
     for (auto& model : free_models_) {
-        model->load();
+        Game::inst()->assets().load(model);
     }
 
     Game::inst()->render().camera()->set_camera(Vector3(-10, 10, 10), Vector3(1.f, -1.f, -1.f));
 }
 
+void KatamariComponent::write_snapshot(FrameSnapshot& snapshot) const
+{
+    scene_->write_snapshot(snapshot);
+}
+
+void KatamariComponent::read_snapshot(const FrameSnapshot& snapshot)
+{
+    scene_->read_snapshot(snapshot);
+}
+
 void KatamariComponent::draw()
 {
     scene_->draw();
@@ -110,11 +126,6 @@ void KatamariComponent::update()
     time += Game::inst()->delta_time();
 
     scene_->update();
-    for (auto& model : free_models_)
-    {
-        auto old_pos = model->position();
-        model->set_position(Vector3(old_pos.x, (model->extent_max().y - model->extent_min().y) / 2, old_pos.z));
-    }
     auto camera = Game::inst()->render().camera();
 
     const auto& keyboard = Game::inst()->win().input()->keyboard();
@@ -207,6 +218,20 @@ void KatamariComponent::update()
     camera->focus(attached_models_[0].model->position(), attached_models_[0].model->radius());
 }
 
+void KatamariComponent::update_jobs(TaskGroup& group)
+{
+    // free models are independent - put them on the ground in parallel
+    constexpr uint32_t models_per_job = 64;
+    group.parallel_for(uint32_t(free_models_.size()), models_per_job, [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            auto& model = free_models_[i];
+            auto old_pos = model->position();
+            model->set_position(Vector3(old_pos.x, (model->extent_max().y - model->extent_min().y) / 2, old_pos.z));
+        }
+    });
+}
+
 void KatamariComponent::destroy_resources()
 {
     plane_->unload();
@@ -23,6 +23,9 @@ public:
     void imgui() override;
     void reload() override;
     void update() override;
+    void update_jobs(TaskGroup& group) override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 private:
     class Scene* scene_{ nullptr };
@@ -2,7 +2,11 @@
 #include <imgui/imgui.h>
 
 #include "core/game.h"
+#include "core/job_system.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/state_objects.h"
 #include "render/camera.h"
 #include "render/d3d11_common.h"
 #include "orbit_component.h"
@@ -59,22 +63,17 @@ Matrix OrbitComponent::Sphere::transform() const
     return parent_->transform() * Matrix::CreateTranslation(translation.x, translation.y, translation.z);
 }
 
-void OrbitComponent::Sphere::draw(Buffer& sphere_index_buffer, ConstBuffer& sphere_info_buffer, const Matrix& view_proj)
+void OrbitComponent::Sphere::collect(std::vector<SphereInfo>& infos) const
 {
-    SphereInfo info;
+    SphereInfo info{};
     info.color = color_;
     info.transform = Matrix::CreateRotationY(local_angle_) * Matrix::CreateScale(radius_) * transform();
     info.inverse_transp_transform = info.transform.Invert().Transpose();
-    info.view_proj = view_proj;
-    sphere_info_buffer.update_data(&info);
-    sphere_info_buffer.bind(0);
-
-    auto context = Game::inst()->render().context();
-    context->DrawIndexed(sphere_index_buffer.count(), 0, 0);
+    infos.push_back(info);
 
     for (auto& child : children_)
     {
-        child->draw(sphere_index_buffer, sphere_info_buffer, view_proj);
+        child->collect(infos);
     }
 }
 
@@ -89,6 +88,18 @@ void OrbitComponent::Sphere::update()
     }
 }
 
+void OrbitComponent::Sphere::update_jobs(TaskGroup& group)
+{
+    // each subtree is independent
+    for (auto& child : children_) {
+        group.run([child] { child->update(); });
+    }
+
+    float delta_time = Game::inst()->delta_time();
+    angle_ += delta_time * angle_speed_;
+    local_angle_ += delta_time * local_speed_;
+}
+
 void OrbitComponent::Sphere::get_position(int &depth, Vector3 &res)
 {
     if (depth < 0) {
@@ -207,15 +218,13 @@ void OrbitComponent::initialize()
 
         sphere_vertex_buffer_.initialize(D3D11_BIND_VERTEX_BUFFER, vertices.data(), sizeof(Vertex), uint32_t(vertices.size()));
         sphere_index_buffer_.initialize(D3D11_BIND_INDEX_BUFFER, indices.data(), sizeof(uint32_t), uint32_t(indices.size()));
-        sphere_info_buffer_.initialize(sizeof(SphereInfo), D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
     }
 
     CD3D11_RASTERIZER_DESC rastDesc = {};
     rastDesc.CullMode = D3D11_CULL_NONE;
     rastDesc.FillMode = D3D11_FILL_SOLID;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateRasterizerState(&rastDesc, &rasterizer_state_));
+    D3D11_CHECK(Game::inst()->render().state_objects()->rasterizer_state(&rastDesc, &rasterizer_state_));
 
     // setup CPU
     system_root_ = new Sphere(100, 0, 0.f, 10.f, Vector3(1.f, 1.f, 0.f));
@@ -235,16 +244,41 @@ void OrbitComponent::initialize()
 
 void OrbitComponent::draw()
 {
-    auto context = Game::inst()->render().context();
-    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    context->RSSetState(rasterizer_state_);
+    auto backend = Game::inst()->render().backend();
+    backend->ia_set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    backend->rs_set_state(rasterizer_state_);
 
     sphere_draw_shader_.use();
 
+    // write all spheres first: ring page is mapped once
+    auto constant_ring = Game::inst()->render().constant_ring();
+    draw_allocations_.clear();
+    for (auto& info : draw_infos_)
+    {
+        info.view_proj = view_proj_;
+        draw_allocations_.push_back(constant_ring->write(&info, sizeof(info)));
+    }
+
     sphere_vertex_buffer_.bind(0);
     sphere_index_buffer_.bind();
-    auto camera = Game::inst()->render().camera();
-    system_root_->draw(sphere_index_buffer_, sphere_info_buffer_, camera->view_proj());
+    for (auto& allocation : draw_allocations_)
+    {
+        constant_ring->bind(allocation, 0);
+        backend->draw_indexed(sphere_index_buffer_.count(), 0, 0);
+    }
+}
+
+void OrbitComponent::write_snapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.store(this, sphere_infos_.data(), sphere_infos_.size());
+}
+
+void OrbitComponent::read_snapshot(const FrameSnapshot& snapshot)
+{
+    size_t count = 0;
+    const SphereInfo* infos = snapshot.load<SphereInfo>(this, &count);
+    draw_infos_.assign(infos, infos + count);
+    view_proj_ = snapshot.camera.view_proj;
 }
 
 void OrbitComponent::imgui()
@@ -259,18 +293,24 @@ void OrbitComponent::imgui()
 
     ImGui::Begin("Info", nullptr, window_flags);
     {
+        bool camera_perspective = camera_perspective_;
         ImGui::Text("Perspective camera");
         ImGui::SameLine();
-        ImGui::Checkbox("   ", &camera_perspective_);
+        ImGui::Checkbox("   ", &camera_perspective);
+        camera_perspective_ = camera_perspective;
 
+        bool focus_on = focus_on_;
         ImGui::Text("Focus");
         ImGui::SameLine();
-        ImGui::Checkbox("  ", &focus_on_);
+        ImGui::Checkbox("  ", &focus_on);
+        focus_on_ = focus_on;
 
-        if (focus_on_) {
+        if (focus_on) {
+            int focus_target = focus_target_;
             ImGui::Text("Focus target");
             ImGui::SameLine();
-            ImGui::SliderInt(" ", &focus_target_, 0, (int)system_root_->child_count());
+            ImGui::SliderInt(" ", &focus_target, 0, (int)system_root_->child_count());
+            focus_target_ = focus_target;
         }
     }
     ImGui::End();
@@ -281,10 +321,13 @@ void OrbitComponent::reload()
 
 }
 
-void OrbitComponent::update()
+void OrbitComponent::update_jobs(TaskGroup& group)
 {
-    system_root_->update();
+    system_root_->update_jobs(group);
+}
 
+void OrbitComponent::update()
+{
     auto camera = Game::inst()->render().camera();
     camera->set_type(camera_perspective_ ? Camera::CameraType::perspective : Camera::CameraType::orthographic);
 
@@ -296,6 +339,9 @@ void OrbitComponent::update()
     } else {
         camera->reset_focus();
     }
+
+    sphere_infos_.clear();
+    system_root_->collect(sphere_infos_);
 }
 
 void OrbitComponent::destroy_resources()
@@ -308,7 +354,6 @@ void OrbitComponent::destroy_resources()
 
     sphere_vertex_buffer_.destroy();
     sphere_index_buffer_.destroy();
-    sphere_info_buffer_.destroy();
     sphere_draw_shader_.destroy();
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <SimpleMath.h>
@@ -7,6 +8,7 @@ using namespace DirectX::SimpleMath;
 
 #include "component/game_component.h"
 #include "render/resource/buffer.h"
+#include "render/resource/constant_ring.h"
 #include "render/resource/shader.h"
 
 class OrbitComponent : public GameComponent
@@ -19,6 +21,9 @@ public:
     void imgui() override;
     void reload() override;
     void update() override;
+    void update_jobs(TaskGroup& group) override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 private:
     struct SphereInfo
@@ -38,8 +43,10 @@ private:
         void clear();
         size_t child_count() const;
         Matrix transform() const;
-        void draw(Buffer& sphere_index_buffer, ConstBuffer& sphere_info_buffer, const Matrix& view_proj);
+        // append draw info of this sphere and its children
+        void collect(std::vector<SphereInfo>& infos) const;
         void update();
+        void update_jobs(TaskGroup& group);
         void get_position(int& depth, Vector3& res);
     private:
         class Sphere* parent_;
@@ -54,20 +61,24 @@ private:
     };
     Sphere* system_root_;
 
+    std::vector<SphereInfo> sphere_infos_; // simulation side
+    std::vector<SphereInfo> draw_infos_; // render side
+    Matrix view_proj_;
+
     int horizontal_segments_count_{ 10 };
     int vertical_segments_count_{ 10 };
 
     Buffer sphere_vertex_buffer_;
     Buffer sphere_index_buffer_;
-    ConstBuffer sphere_info_buffer_;
+    std::vector<ConstantRing::Allocation> draw_allocations_; // sphere infos of the frame
 
     static std::string sphere_draw_shader_source_;
     Shader sphere_draw_shader_;
 
     ID3D11RasterizerState* rasterizer_state_{ nullptr };
 
-    // imgui controls
-    bool camera_perspective_;
-    bool focus_on_;
-    int focus_target_;
+    // imgui controls, written on render thread and read by simulation
+    std::atomic<bool> camera_perspective_;
+    std::atomic<bool> focus_on_;
+    std::atomic<int> focus_target_;
 };
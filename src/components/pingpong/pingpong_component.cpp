@@ -1,6 +1,9 @@
 #include <imgui/imgui.h>
 #include "core/game.h"
+#include "core/frame_snapshot.h"
 #include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/state_objects.h"
 #include "win32/win.h"
 #include "win32/input.h"
 #include "pingpong_component.h"
@@ -86,49 +89,63 @@ void PingpongComponent::initialize()
     rastDesc.CullMode = D3D11_CULL_NONE;
     rastDesc.FillMode = D3D11_FILL_SOLID; // D3D11_FILL_WIREFRAME;
 
-    auto device = Game::inst()->render().device();
-    D3D11_CHECK(device->CreateRasterizerState(&rastDesc, &rasterizer_state_));
-
-#ifndef NDEBUG
-    std::string rasterizer_state_name = "pingpong_rasterizer_state";
-    rasterizer_state_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(rasterizer_state_name.size()), rasterizer_state_name.c_str());
-#endif
+    D3D11_CHECK(Game::inst()->render().state_objects()->rasterizer_state(&rastDesc, &rasterizer_state_));
 }
 
 void PingpongComponent::draw()
 {
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
 
-    context->RSSetState(rasterizer_state_);
+    backend->rs_set_state(rasterizer_state_);
 
-    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    backend->ia_set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     // draw net
     net_shader_.use();
     brick_index_buffer_.bind();
     net_info_buffer_.bind(0);
-    context->DrawIndexedInstanced(brick_index_buffer_.count(), net_info_.net_elements_count, 0, 0, 0);
+    backend->draw_indexed_instanced(brick_index_buffer_.count(), net_info_.net_elements_count, 0, 0, 0);
 
     // draw bricks
     brick_shader_.use();
     brick_index_buffer_.bind();
 
     // player brick
-    player_brick_info_buffer_.update_data(&player_);
     player_brick_info_buffer_.bind(0);
-    context->DrawIndexed(brick_index_buffer_.count(), 0, 0);
+    backend->draw_indexed(brick_index_buffer_.count(), 0, 0);
 
     // opponent brick
-    opponent_brick_info_buffer_.update_data(&opponent_);
     opponent_brick_info_buffer_.bind(0);
-    context->DrawIndexed(brick_index_buffer_.count(), 0, 0);
+    backend->draw_indexed(brick_index_buffer_.count(), 0, 0);
 
     // draw circle
     circle_shader_.use();
     circle_index_buffer_.bind();
-    circle_info_buffer_.update_data(&circle_);
     circle_info_buffer_.bind(0);
-    context->DrawIndexed(circle_index_buffer_.count(), 0, 0);
+    backend->draw_indexed(circle_index_buffer_.count(), 0, 0);
+}
+
+void PingpongComponent::write_snapshot(FrameSnapshot& snapshot) const
+{
+    DrawState state;
+    state.player = player_;
+    state.opponent = opponent_;
+    state.circle = circle_;
+    state.circle_move_direction = circle_move_direction_;
+    state.circle_move_speed = circle_move_speed_;
+    state.score[0] = score_.first;
+    state.score[1] = score_.second;
+    snapshot.store(this, state);
+}
+
+void PingpongComponent::read_snapshot(const FrameSnapshot& snapshot)
+{
+    if (auto state = snapshot.load<DrawState>(this)) {
+        draw_state_ = *state;
+        player_brick_info_buffer_.update_data(&draw_state_.player);
+        opponent_brick_info_buffer_.update_data(&draw_state_.opponent);
+        circle_info_buffer_.update_data(&draw_state_.circle);
+    }
 }
 
 void PingpongComponent::imgui()
@@ -146,15 +163,15 @@ void PingpongComponent::imgui()
     {
         ImGui::Text("Score");
         ImGui::SameLine();
-        ImGui::Text("%d", score_.first);
+        ImGui::Text("%d", draw_state_.score[0]);
 
         ImGui::Text("Size");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", player_.width, player_.height);
+        ImGui::Text("%.2fx%.2f", draw_state_.player.width, draw_state_.player.height);
 
         ImGui::Text("Position");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", player_.position.x, player_.position.y);
+        ImGui::Text("%.2fx%.2f", draw_state_.player.position.x, draw_state_.player.position.y);
     }
     ImGui::End();
 
@@ -164,15 +181,15 @@ void PingpongComponent::imgui()
     {
         ImGui::Text("Score");
         ImGui::SameLine();
-        ImGui::Text("%d", score_.second);
+        ImGui::Text("%d", draw_state_.score[1]);
 
         ImGui::Text("Size");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", opponent_.width, opponent_.height);
+        ImGui::Text("%.2fx%.2f", draw_state_.opponent.width, draw_state_.opponent.height);
 
         ImGui::Text("Position");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", opponent_.position.x, opponent_.position.y);
+        ImGui::Text("%.2fx%.2f", draw_state_.opponent.position.x, draw_state_.opponent.position.y);
     }
     ImGui::End();
 
@@ -184,23 +201,25 @@ void PingpongComponent::imgui()
     {
         ImGui::Text("Radius");
         ImGui::SameLine();
-        ImGui::Text("%.2f", circle_.radius);
+        ImGui::Text("%.2f", draw_state_.circle.radius);
 
         ImGui::Text("Position");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", circle_.position.x, circle_.position.y);
+        ImGui::Text("%.2fx%.2f", draw_state_.circle.position.x, draw_state_.circle.position.y);
 
         ImGui::Text("Triangle count");
         ImGui::SameLine();
-        ImGui::SliderInt("triangle_count", &circle_.triangle_count, 3, max_triangle_count_);
+        int32_t triangle_count = triangle_count_;
+        ImGui::SliderInt("triangle_count", &triangle_count, 3, max_triangle_count_);
+        triangle_count_ = triangle_count;
 
         ImGui::Text("Direction");
         ImGui::SameLine();
-        ImGui::Text("%.2fx%.2f", circle_move_direction_.x, circle_move_direction_.y);
+        ImGui::Text("%.2fx%.2f", draw_state_.circle_move_direction.x, draw_state_.circle_move_direction.y);
 
         ImGui::Text("Speed");
         ImGui::SameLine();
-        ImGui::Text("%.2f", circle_move_speed_);
+        ImGui::Text("%.2f", draw_state_.circle_move_speed);
     }
     ImGui::End();
 }
@@ -210,9 +229,8 @@ void PingpongComponent::reload()
     // setup game components
     player_ = default_player_;
     opponent_ = default_opponent_;
-    int32_t triangle_count_save = circle_.triangle_count;
     circle_ = default_circle_;
-    circle_.triangle_count = triangle_count_save;
+    circle_.triangle_count = triangle_count_;
     circle_move_direction_ = default_circle_move_direction_;
     circle_move_speed_ = default_circle_move_speed_;
 }
@@ -223,6 +241,8 @@ void PingpongComponent::update()
     const float brick_move_delta = Game::inst()->delta_time() * 1e0f * 1.3f;
     const float circle_move_delta = Game::inst()->delta_time() * 1e0f * 2.f;
 
+    circle_.triangle_count = triangle_count_;
+
     // toggle pause
     if (keyboard.p.released) {
         paused_ = !paused_;
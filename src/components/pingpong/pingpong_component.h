@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <SimpleMath.h>
 using namespace DirectX::SimpleMath;
 
@@ -47,6 +48,18 @@ private:
     std::pair<uint32_t, uint32_t> score_; // player points; opponent points
     bool paused_{ false }; // 'P'
     bool self_mode_{ true }; // 'S'
+    std::atomic<int32_t> triangle_count_{ 10 }; // set from imgui
+
+    // state passed to render thread
+    struct DrawState
+    {
+        BrickInfo player;
+        BrickInfo opponent;
+        CircleInfo circle;
+        Vector2 circle_move_direction;
+        float circle_move_speed;
+        uint32_t score[2];
+    } draw_state_{};
 
     // resources
     Buffer brick_index_buffer_;
@@ -71,5 +84,7 @@ public:
     void imgui() override;
     void reload() override;
     void update() override;
+    void write_snapshot(FrameSnapshot& snapshot) const override;
+    void read_snapshot(const FrameSnapshot& snapshot) override;
     void destroy_resources() override;
 };
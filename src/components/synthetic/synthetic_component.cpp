@@ -0,0 +1,77 @@
+#include <cmath>
+
+#include "core/job_system.h"
+#include "synthetic_component.h"
+
+SyntheticComponent::SyntheticComponent(uint32_t entity_count, uint32_t iterations, uint32_t entities_per_job) :
+    entities_(entity_count), iterations_{ iterations }, entities_per_job_{ entities_per_job }
+{
+}
+
+void SyntheticComponent::initialize()
+{
+    for (uint32_t i = 0; i < entities_.size(); ++i)
+    {
+        auto& entity = entities_[i];
+        entity.position[0] = float(i);
+        entity.position[1] = 0.f;
+        entity.position[2] = -float(i);
+        entity.velocity[0] = 1.f;
+        entity.velocity[1] = 0.5f;
+        entity.velocity[2] = 0.25f;
+    }
+}
+
+void SyntheticComponent::draw()
+{
+    // stub
+}
+
+void SyntheticComponent::imgui()
+{
+    // stub
+}
+
+void SyntheticComponent::reload()
+{
+    initialize();
+}
+
+void SyntheticComponent::update()
+{
+    // all work is done in update_jobs
+}
+
+void SyntheticComponent::update_jobs(TaskGroup& group)
+{
+    group.parallel_for(uint32_t(entities_.size()), entities_per_job_, [this](uint32_t begin, uint32_t end) {
+        constexpr float dt = 1.f / 60.f;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            auto& entity = entities_[i];
+            for (uint32_t it = 0; it < iterations_; ++it)
+            {
+                // spring to origin - some transcendental math to make work measurable
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    entity.velocity[axis] -= std::sin(entity.position[axis]) * dt;
+                    entity.position[axis] += entity.velocity[axis] * dt;
+                }
+            }
+        }
+    });
+}
+
+void SyntheticComponent::destroy_resources()
+{
+    entities_.clear();
+}
+
+float SyntheticComponent::checksum() const
+{
+    float sum = 0.f;
+    for (auto& entity : entities_) {
+        sum += entity.position[0] + entity.position[1] + entity.position[2];
+    }
+    return sum;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "component/game_component.h"
+
+// CPU-only component with configurable update cost, used to measure job system scaling
+class SyntheticComponent : public GameComponent
+{
+private:
+    struct Entity
+    {
+        float position[3];
+        float velocity[3];
+    };
+
+    std::vector<Entity> entities_;
+    uint32_t iterations_; // per entity work amount
+    uint32_t entities_per_job_;
+
+public:
+    SyntheticComponent(uint32_t entity_count, uint32_t iterations, uint32_t entities_per_job = 256);
+
+    void initialize() override;
+    void draw() override;
+    void imgui() override;
+    void reload() override;
+    void update() override;
+    void update_jobs(TaskGroup& group) override;
+    void destroy_resources() override;
+
+    float checksum() const;
+};
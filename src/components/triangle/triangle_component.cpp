@@ -1,4 +1,6 @@
 #include "render/render.h"
+#include "render/backend/render_backend.h"
+#include "render/resource/state_objects.h"
 #include "core/game.h"
 #include "render/d3d11_common.h"
 #include "triangle_component.h"
@@ -21,7 +23,6 @@ void TriangleComponent::initialize()
 #endif
 
     // create buffers
-    auto device = Game::inst()->render().device();
     Vector4 points[] = { // full-screen triangle
         Vector4(3.f, -1.f, 0.f, 1.0f), Vector4(1.0f, 0.0f, 0.0f, 1.0f),
         Vector4(-1.f, 3.f, 0.f, 1.0f), Vector4(0.0f, 0.0f, 1.0f, 1.0f),
@@ -43,12 +44,7 @@ void TriangleComponent::initialize()
     rastDesc.CullMode = D3D11_CULL_NONE;
     rastDesc.FillMode = D3D11_FILL_SOLID; // D3D11_FILL_WIREFRAME;
 
-    D3D11_CHECK(device->CreateRasterizerState(&rastDesc, &rasterizer_state_));
-
-#ifndef NDEBUG
-    std::string rasterizer_state_name = "triangle_rasterizer_state";
-    rasterizer_state_->SetPrivateData(WKPDID_D3DDebugObjectName, UINT(rasterizer_state_name.size()), rasterizer_state_name.c_str());
-#endif
+    D3D11_CHECK(Game::inst()->render().state_objects()->rasterizer_state(&rastDesc, &rasterizer_state_));
 
     // D3D11_BUFFER_DESC vertexBufDesc = {};
     // vertexBufDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -84,22 +80,22 @@ void TriangleComponent::initialize()
 
 void TriangleComponent::draw()
 {
-    auto context = Game::inst()->render().context();
+    auto backend = Game::inst()->render().backend();
     auto device = Game::inst()->render().device();
 
     // bind current shader
     shader_.use();
 
     // setup tiangles draw
-    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    backend->ia_set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     // bind draw pipeline input buffers
     index_buffer_.bind();
     vertex_buffer_.bind();
 
-    context->RSSetState(rasterizer_state_);
+    backend->rs_set_state(rasterizer_state_);
 
-    context->DrawIndexed(index_buffer_.count(), 0, 0);
+    backend->draw_indexed(index_buffer_.count(), 0, 0);
 }
 
 void TriangleComponent::imgui()
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "render/frustum_culling.h"
+
+// usage: culling_benchmark [box_count] [iterations]
+// culls random boxes around camera with scalar and SIMD paths, checks that they agree
+int main(int argc, char** argv)
+{
+    const uint32_t box_count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 100000;
+    const uint32_t iterations = argc > 2 ? uint32_t(std::atoi(argv[2])) : 100;
+
+    // same projection as Camera, looking along +x
+    const Matrix view = Matrix::CreateLookAt(Vector3::Zero, Vector3(1.f, 0.f, 0.f), Vector3(0.f, 1.f, 0.f));
+    const Matrix proj = Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PI / 3.f, 16.f / 9.f, 0.1f, 500.f);
+    const Frustum frustum = Frustum::from_view_proj(view * proj);
+
+    // rotated and scaled unit boxes scattered around camera
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::uniform_real_distribution<float> scale(0.5f, 10.f);
+    std::uniform_real_distribution<float> angle(0.f, DirectX::XM_2PI);
+    CullingBoxes boxes;
+    boxes.reserve(box_count);
+    for (uint32_t i = 0; i < box_count; ++i)
+    {
+        const Matrix transform = Matrix::CreateScale(scale(random), scale(random), scale(random)) *
+                                 Matrix::CreateFromYawPitchRoll(angle(random), angle(random), angle(random)) *
+                                 Matrix::CreateTranslation(position(random), position(random), position(random));
+        Vector3 center, extent;
+        transform_box(Vector3::Zero, Vector3(0.5f), transform, center, extent);
+        boxes.add(center, extent);
+    }
+
+    std::vector<uint32_t> scalar_visible(box_count);
+    std::vector<uint32_t> simd_visible(box_count);
+    uint32_t scalar_count = 0;
+    uint32_t simd_count = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        scalar_count = boxes.cull_scalar(frustum, scalar_visible.data());
+    }
+    const double scalar_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        simd_count = boxes.cull(frustum, simd_visible.data());
+    }
+    const double simd_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    bool match = scalar_count == simd_count;
+    for (uint32_t i = 0; match && i < simd_count; ++i) {
+        match = scalar_visible[i] == simd_visible[i];
+    }
+
+#if defined(__AVX2__)
+    const char* simd_name = "avx2";
+#else
+    const char* simd_name = "sse";
+#endif
+    std::printf("boxes: %u, iterations: %u, visible: %u\n", box_count, iterations, simd_count);
+    std::printf("%8s %14s %10s\n", "path", "ms per cull", "speedup");
+    std::printf("%8s %14.4f %10.2f\n", "scalar", scalar_ms, 1.0);
+    std::printf("%8s %14.4f %10.2f\n", simd_name, simd_ms, scalar_ms / simd_ms);
+    if (!match)
+    {
+        std::printf("SIMD result differs from scalar: %u of %u visible\n", simd_count, scalar_count);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "core/game.h"
+#include "core/heap_tracker.h"
+#include "core/profiler.h"
+#include "render/render.h"
+#include "render/backend/null_backend.h"
+#include "render/backend/state_cache.h"
+#include "render/resource/buffer.h"
+#include "render/resource/geometry_pool.h"
+#include "render/resource/resource_manager.h"
+#include "render/resource/shader_cache.h"
+#include "render/resource/shader_compiler.h"
+#include "render/resource/state_objects.h"
+#include "render/resource/texture_cache.h"
+#include "render/scene/asset_loader.h"
+#include "render/scene/scene.h"
+#include "win32/input_record.h"
+#include "components/katamari/katamari_component.h"
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxguid.lib")
+
+// usage: frame_benchmark [frame_count] [width] [height] [trace.json|-] [input_replay|-] [texture_budget_mb]
+// runs katamari frames on null render backend, prints CPU time, backend calls, state calls elided by
+// state cache, resource memory by category and profiler scopes per frame.
+// with input replay (recorded by "katamari.exe -record <file>") frames get recorded input and delta time,
+// so every run simulates exactly the same session.
+// Fails when shaders do not compile or the scene draws no meshes: ctest runs it on Windows as the
+// headless check of Scene, Model and Mesh draw paths, no GPU needed.
+int main(int argc, char** argv)
+{
+    uint32_t frame_count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 100;
+    const uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 800;
+    const uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 800;
+    const char* trace_filename = argc > 4 && std::strcmp(argv[4], "-") != 0 ? argv[4] : nullptr;
+    const char* replay_filename = argc > 5 && std::strcmp(argv[5], "-") != 0 ? argv[5] : nullptr;
+    const size_t texture_budget = argc > 6 ? size_t(std::atoi(argv[6])) << 20 : 0;
+
+    auto katamari = std::make_unique<KatamariComponent>();
+    Game::inst()->add_component(katamari.get());
+    auto initialize_start = std::chrono::steady_clock::now();
+    Game::inst()->initialize_headless(width, height);
+    const double initialize_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initialize_start).count();
+    Game::inst()->assets().flush(); // measure frames with resident models only
+    Game::inst()->render().resources()->set_budget(ResourceCategory::texture, texture_budget);
+
+    constexpr uint32_t warmup_frame_count = 10;
+    if (replay_filename != nullptr)
+    {
+        if (!Game::inst()->replay_input(replay_filename)) {
+            std::printf("failed to open input replay %s\n", replay_filename);
+            return 1;
+        }
+        uint32_t recorded_frame_count = Game::inst()->input_player()->frame_count();
+        if (recorded_frame_count <= warmup_frame_count) {
+            std::printf("input replay %s is too short: %u frames\n", replay_filename, recorded_frame_count);
+            return 1;
+        }
+        frame_count = std::min(frame_count, recorded_frame_count - warmup_frame_count);
+    }
+
+    // warm up: caches, arenas and job pool reach steady state
+    for (uint32_t frame = 0; frame < warmup_frame_count; ++frame) {
+        Game::inst()->frame();
+    }
+
+    // count only frame calls, not resources creation
+    auto state_cache = Game::inst()->render().state_cache();
+    auto backend = static_cast<NullBackend*>(state_cache->backend());
+    backend->reset();
+    state_cache->reset_counters();
+    StructuredBuffer::reset_upload_counters();
+    Profiler::clear();
+    const HeapTracker::Stats heap_before = HeapTracker::total();
+
+    uint64_t culling_total = 0;
+    uint64_t culling_visible = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        Game::inst()->frame();
+        auto culling = Scene::culling_counters();
+        culling_total += culling.total;
+        culling_visible += culling.visible;
+    }
+    auto end = std::chrono::steady_clock::now();
+    const HeapTracker::Stats heap_after = HeapTracker::total();
+    const uint64_t frame_heap_allocations = heap_after.count - heap_before.count;
+
+    double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / frame_count;
+    std::printf("frames: %u, resolution: %ux%u, ms per frame: %.3f\n", frame_count, width, height, frame_ms);
+    if (replay_filename != nullptr) {
+        std::printf("input replay: %s\n", replay_filename);
+    }
+    std::printf("initialization: %.1f ms\n", initialize_ms);
+    auto geometry_pool = Game::inst()->render().geometry_pool();
+    std::printf("geometry pool: %u pages, %.1f of %.1f Mb used\n", geometry_pool->page_count(),
+                geometry_pool->used_bytes() / double(1 << 20), geometry_pool->capacity_bytes() / double(1 << 20));
+    auto resources = Game::inst()->render().resources();
+    for (uint32_t i = 0; i < uint32_t(ResourceCategory::count); ++i)
+    {
+        auto category = ResourceCategory(i);
+        auto usage = resources->usage(category);
+        std::printf("%s: %.1f Mb resident, %.1f Mb peak, budget %.1f Mb, %u evicted, %llu evictions, %llu restores\n",
+                    ResourceManager::category_name(category), usage.bytes / double(1 << 20), usage.peak_bytes / double(1 << 20),
+                    usage.budget / double(1 << 20), usage.evicted, (unsigned long long)usage.evictions, (unsigned long long)usage.restores);
+    }
+    auto texture_cache = Game::inst()->render().texture_cache()->stats();
+    std::printf("texture cache: %u entries, %llu hits of %llu requests\n", texture_cache.entries,
+                (unsigned long long)texture_cache.hits, (unsigned long long)texture_cache.requests);
+    auto shader_cache = Game::inst()->render().shader_cache()->stats();
+    std::printf("shader cache: %u entries, %llu hits, %llu compiled\n", shader_cache.entries,
+                (unsigned long long)shader_cache.hits, (unsigned long long)shader_cache.misses);
+    auto shader_compiler = Game::inst()->render().shader_compiler()->stats();
+    std::printf("shader compiler: %llu shaders, %llu stages, %llu failed\n", (unsigned long long)shader_compiler.batches,
+                (unsigned long long)shader_compiler.compiled, (unsigned long long)shader_compiler.failed);
+    auto state_objects = Game::inst()->render().state_objects()->stats();
+    std::printf("state objects: %u alive, %llu created for %llu requests\n", state_objects.alive,
+                (unsigned long long)state_objects.created, (unsigned long long)state_objects.requests);
+    auto uploads = StructuredBuffer::upload_counters();
+    std::printf("structured buffers: %.1f of %.1f Kb per frame uploaded, %.1f range updates per frame\n",
+                uploads.uploaded_bytes / 1024.0 / frame_count, uploads.updated_bytes / 1024.0 / frame_count,
+                double(uploads.range_updates) / frame_count);
+    std::printf("frustum culling: %.1f of %.1f models visible per frame\n",
+                double(culling_visible) / frame_count, double(culling_total) / frame_count);
+    std::printf("%28s %12s %12s\n", "call", "total", "per frame");
+    for (uint32_t i = 0; i < uint32_t(NullBackend::Call::count); ++i)
+    {
+        auto call = NullBackend::Call(i);
+        uint64_t count = backend->counter(call);
+        if (count == 0) {
+            continue;
+        }
+        std::printf("%28s %12llu %12.1f\n", NullBackend::call_name(call), (unsigned long long)count, double(count) / frame_count);
+    }
+    std::printf("%28s %12llu %12.1f\n", "mapped bytes", (unsigned long long)backend->mapped_bytes(), double(backend->mapped_bytes()) / frame_count);
+    if (HeapTracker::available()) {
+        std::printf("%28s %12llu %12.1f\n", "heap allocations", (unsigned long long)frame_heap_allocations, double(frame_heap_allocations) / frame_count);
+    }
+
+    std::printf("\n%28s %12s %12s\n", "state", "issued", "elided");
+    const StateCache::Counters& state_counters = state_cache->total_counters();
+    for (uint32_t i = 0; i < uint32_t(StateCache::State::count); ++i)
+    {
+        std::printf("%28s %12.1f %12.1f\n", StateCache::state_name(StateCache::State(i)),
+                    double(state_counters.issued[i]) / frame_count, double(state_counters.elided[i]) / frame_count);
+    }
+
+    std::printf("\n%28s %10s %10s %10s %10s %10s\n", "scope", "count", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (const auto& stats : Profiler::scope_stats())
+    {
+        std::printf("%28s %10llu %10.4f %10.4f %10.4f %10.4f\n", stats.name.c_str(), (unsigned long long)stats.count,
+                    stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+    }
+
+    if (HeapTracker::available())
+    {
+        std::printf("\n%28s %12s %12s %12s %12s\n", "heap by scope", "count", "bytes", "live bytes", "peak bytes");
+        for (const auto& stats : HeapTracker::top(10))
+        {
+            std::printf("%28s %12llu %12llu %12llu %12llu\n", stats.scope.c_str(), (unsigned long long)stats.count,
+                        (unsigned long long)stats.bytes, (unsigned long long)stats.live_bytes, (unsigned long long)stats.peak_bytes);
+        }
+    }
+
+    if (trace_filename != nullptr) {
+        if (Profiler::export_chrome_trace(trace_filename)) {
+            std::printf("trace written to %s\n", trace_filename);
+        } else {
+            std::printf("failed to write trace to %s\n", trace_filename);
+        }
+    }
+
+    // regression check (ctest): frames went through culling and mesh draws of the real scene
+    bool passed = true;
+    const uint64_t mesh_draws = backend->counter(NullBackend::Call::draw_indexed) + backend->counter(NullBackend::Call::draw_indexed_instanced);
+    if (mesh_draws == 0 || culling_visible == 0) {
+        std::printf("check failed: scene drew no meshes\n");
+        passed = false;
+    }
+    if (shader_compiler.failed != 0) {
+        std::printf("check failed: %llu shader stages failed to compile\n", (unsigned long long)shader_compiler.failed);
+        passed = false;
+    }
+
+    Game::inst()->destroy();
+
+    return passed ? 0 : 1;
+}
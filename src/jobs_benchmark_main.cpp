@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "core/job_system.h"
+#include "components/synthetic/synthetic_component.h"
+
+// usage: jobs_benchmark [component_count] [entity_count] [iterations] [frame_count]
+// runs update_jobs of synthetic components with 1..hardware_concurrency workers
+int main(int argc, char** argv)
+{
+    const uint32_t component_count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 16;
+    const uint32_t entity_count = argc > 2 ? uint32_t(std::atoi(argv[2])) : 10000;
+    const uint32_t iterations = argc > 3 ? uint32_t(std::atoi(argv[3])) : 8;
+    const uint32_t frame_count = argc > 4 ? uint32_t(std::atoi(argv[4])) : 100;
+
+    const uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("components: %u, entities per component: %u, iterations: %u, frames: %u\n",
+                component_count, entity_count, iterations, frame_count);
+    std::printf("%8s %14s %10s %12s\n", "threads", "ms per frame", "speedup", "checksum");
+
+    double single_thread_ms = 0.0;
+    for (uint32_t thread_count = 1; thread_count <= max_threads; ++thread_count)
+    {
+        std::vector<std::unique_ptr<SyntheticComponent>> components;
+        for (uint32_t i = 0; i < component_count; ++i)
+        {
+            components.push_back(std::make_unique<SyntheticComponent>(entity_count, iterations));
+            components.back()->initialize();
+        }
+
+        JobSystem jobs(thread_count);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            TaskGroup update_group(jobs);
+            for (auto& component : components) {
+                component->update_jobs(update_group);
+            }
+            update_group.wait();
+
+            for (auto& component : components) {
+                component->update();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / frame_count;
+        if (thread_count == 1) {
+            single_thread_ms = frame_ms;
+        }
+
+        float checksum = 0.f;
+        for (auto& component : components) {
+            checksum += component->checksum();
+            component->destroy_resources();
+        }
+
+        std::printf("%8u %14.3f %10.2f %12.3f\n", thread_count, frame_ms, single_thread_ms / frame_ms, checksum);
+    }
+
+    return 0;
+}
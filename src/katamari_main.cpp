@@ -7,12 +7,14 @@
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "dxguid.lib")
 
-int WINAPI WinMain(HINSTANCE, HINSTANCE, char*, int)
+int WINAPI WinMain(HINSTANCE, HINSTANCE, char* command_line, int)
 {
     auto katamari = std::make_unique<KatamariComponent>();
     Game::inst()->add_component(katamari.get());
 
     Game::inst()->initialize(800, 800);
+    Game::inst()->set_threaded(true);
+    Game::inst()->parse_command_line(command_line); // -record <file> / -replay <file>
     Game::inst()->run();
     Game::inst()->destroy();
 
@@ -15,6 +15,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, char*, int)
     Game::inst()->add_component(orbit.get());
 
     Game::inst()->initialize(800, 800);
+    Game::inst()->set_threaded(true);
     Game::inst()->run();
     Game::inst()->destroy();
 
@@ -0,0 +1,86 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "core/job_system.h"
+
+// Checks of background jobs: waits of frame jobs never run them, waits for them do.
+
+namespace
+{
+int failures = 0;
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);           \
+            ++failures;                                                                         \
+        }                                                                                       \
+    } while (0)
+
+void test_single_thread()
+{
+    // no workers: background jobs run only when waited for
+    JobSystem jobs(1);
+    std::atomic<uint32_t> chunks{ 0 };
+    JobHandle background = jobs.run_background([&jobs, &chunks] {
+        // chunks are background jobs too, waiting for them inside is allowed
+        jobs.parallel_for(16, 1, [&chunks](uint32_t begin, uint32_t end) { chunks += end - begin; });
+    });
+
+    TaskGroup group(jobs);
+    std::atomic<uint32_t> frame_jobs{ 0 };
+    group.parallel_for(8, 1, [&frame_jobs](uint32_t begin, uint32_t end) { frame_jobs += end - begin; });
+    group.wait();
+    CHECK(frame_jobs == 8);
+    CHECK(!background.finished());
+    CHECK(chunks == 0);
+
+    jobs.wait(background);
+    CHECK(background.finished());
+    CHECK(chunks == 16);
+}
+
+void test_workers()
+{
+    // frame waits on creator thread never pick a background job, idle workers do
+    JobSystem jobs(4);
+    const std::thread::id creator = std::this_thread::get_id();
+    std::atomic<bool> on_creator{ false };
+    std::atomic<uint32_t> done{ 0 };
+    JobHandle background[4];
+    for (auto& job : background)
+    {
+        job = jobs.run_background([&] {
+            on_creator = on_creator || std::this_thread::get_id() == creator;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            ++done;
+        });
+    }
+    for (uint32_t frame = 0; frame < 20; ++frame)
+    {
+        TaskGroup group(jobs);
+        group.parallel_for(64, 4, [](uint32_t, uint32_t) { std::this_thread::yield(); });
+        group.wait();
+    }
+    CHECK(!on_creator);
+    for (auto& job : background) {
+        jobs.wait(job);
+    }
+    CHECK(done == 4);
+}
+}
+
+int main()
+{
+    test_single_thread();
+    test_workers();
+
+    if (failures != 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
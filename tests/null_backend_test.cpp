@@ -0,0 +1,409 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "render/backend/null_backend.h"
+#include "render/backend/state_cache.h"
+
+// Regression check of backend layer: scripted frame of a deferred renderer goes through
+// StateCache into NullBackend, call counters, elided state and command log must match what
+// the frame does. Prints CPU time of the frame.
+// Scene, Model and Mesh do not run here (they need DirectXMath, Assimp and D3DCompiler):
+// frame_benchmark test drives the real scene through NullBackend on Windows.
+// usage: null_backend_test [frame_count]
+
+namespace
+{
+int failures = 0;
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);           \
+            ++failures;                                                                         \
+        }                                                                                       \
+    } while (0)
+
+constexpr uint32_t mesh_count = 3;
+constexpr uint32_t material_count = 2;
+constexpr uint32_t draw_count = 300;
+constexpr uint32_t index_count = 36;
+
+struct Transform
+{
+    float m[16];
+};
+
+// objects of the scripted scene
+struct Resources
+{
+    ID3D11Buffer* vertex_buffers[mesh_count]{};
+    ID3D11Buffer* index_buffers[mesh_count]{};
+    ID3D11Buffer* frame_constants{ nullptr };
+    ID3D11Buffer* draw_constants{ nullptr };
+    ID3D11Texture2D* textures[material_count]{};
+    ID3D11ShaderResourceView* texture_views[material_count]{};
+    ID3D11Texture2D* target{ nullptr };
+    ID3D11RenderTargetView* target_view{ nullptr };
+    ID3D11Texture2D* depth{ nullptr };
+    ID3D11DepthStencilView* depth_view{ nullptr };
+    ID3D11VertexShader* vertex_shader{ nullptr };
+    ID3D11PixelShader* pixel_shader{ nullptr };
+    ID3D11InputLayout* input_layout{ nullptr };
+    ID3D11RasterizerState* rasterizer_state{ nullptr };
+    ID3D11SamplerState* sampler_state{ nullptr };
+
+    void create(RenderBackend& backend)
+    {
+        for (uint32_t i = 0; i < mesh_count; ++i)
+        {
+            D3D11_BUFFER_DESC desc{};
+            desc.ByteWidth = 24 * 32;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            CHECK(SUCCEEDED(backend.create_buffer(&desc, nullptr, &vertex_buffers[i])));
+            desc.ByteWidth = index_count * sizeof(uint32_t);
+            desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+            CHECK(SUCCEEDED(backend.create_buffer(&desc, nullptr, &index_buffers[i])));
+        }
+
+        D3D11_BUFFER_DESC constants_desc{};
+        constants_desc.ByteWidth = 256;
+        constants_desc.Usage = D3D11_USAGE_DEFAULT;
+        constants_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        CHECK(SUCCEEDED(backend.create_buffer(&constants_desc, nullptr, &frame_constants)));
+        constants_desc.ByteWidth = sizeof(Transform);
+        constants_desc.Usage = D3D11_USAGE_DYNAMIC;
+        constants_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        CHECK(SUCCEEDED(backend.create_buffer(&constants_desc, nullptr, &draw_constants)));
+
+        D3D11_TEXTURE2D_DESC texture_desc{};
+        texture_desc.Width = 256;
+        texture_desc.Height = 256;
+        texture_desc.MipLevels = 1;
+        texture_desc.ArraySize = 1;
+        texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texture_desc.SampleDesc.Count = 1;
+        texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        for (uint32_t i = 0; i < material_count; ++i)
+        {
+            CHECK(SUCCEEDED(backend.create_texture_2d(&texture_desc, nullptr, &textures[i])));
+            CHECK(SUCCEEDED(backend.create_shader_resource_view(textures[i], nullptr, &texture_views[i])));
+        }
+        texture_desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+        CHECK(SUCCEEDED(backend.create_texture_2d(&texture_desc, nullptr, &target)));
+        CHECK(SUCCEEDED(backend.create_render_target_view(target, nullptr, &target_view)));
+        texture_desc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        texture_desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+        CHECK(SUCCEEDED(backend.create_texture_2d(&texture_desc, nullptr, &depth)));
+        CHECK(SUCCEEDED(backend.create_depth_stencil_view(depth, nullptr, &depth_view)));
+
+        const uint8_t bytecode[16]{};
+        CHECK(SUCCEEDED(backend.create_vertex_shader(bytecode, sizeof(bytecode), &vertex_shader)));
+        CHECK(SUCCEEDED(backend.create_pixel_shader(bytecode, sizeof(bytecode), &pixel_shader)));
+        const D3D11_INPUT_ELEMENT_DESC inputs[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        };
+        CHECK(SUCCEEDED(backend.create_input_layout(inputs, 2, bytecode, sizeof(bytecode), &input_layout)));
+
+        D3D11_RASTERIZER_DESC rasterizer_desc{};
+        rasterizer_desc.FillMode = D3D11_FILL_SOLID;
+        rasterizer_desc.CullMode = D3D11_CULL_BACK;
+        CHECK(SUCCEEDED(backend.create_rasterizer_state(&rasterizer_desc, &rasterizer_state)));
+        D3D11_SAMPLER_DESC sampler_desc{};
+        sampler_desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        sampler_desc.AddressU = sampler_desc.AddressV = sampler_desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+        CHECK(SUCCEEDED(backend.create_sampler_state(&sampler_desc, &sampler_state)));
+    }
+
+    void release()
+    {
+        std::vector<IUnknown*> objects = {
+            frame_constants, draw_constants, target, target_view, depth, depth_view,
+            vertex_shader, pixel_shader, input_layout, rasterizer_state, sampler_state,
+        };
+        for (uint32_t i = 0; i < mesh_count; ++i)
+        {
+            objects.push_back(vertex_buffers[i]);
+            objects.push_back(index_buffers[i]);
+        }
+        for (uint32_t i = 0; i < material_count; ++i)
+        {
+            objects.push_back(texture_views[i]);
+            objects.push_back(textures[i]);
+        }
+        for (auto object : objects) {
+            object->Release();
+        }
+    }
+};
+
+// targets and frame state, again in every command list
+void bind_targets(RenderBackend& context, const Resources& resources)
+{
+    context.om_set_render_targets(1, &resources.target_view, resources.depth_view);
+    D3D11_VIEWPORT viewport{ 0.f, 0.f, 256.f, 256.f, 0.f, 1.f };
+    context.rs_set_viewports(1, &viewport);
+    context.rs_set_state(resources.rasterizer_state);
+    context.vs_set_constant_buffers(0, 1, &resources.frame_constants);
+    context.ps_set_constant_buffers(0, 1, &resources.frame_constants);
+}
+
+// draws sorted by mesh and material, as draw bucket submits them: every draw binds
+// its whole state, start index of draw is its number
+void draw_range(RenderBackend& context, const Resources& resources, uint32_t begin, uint32_t end)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const uint32_t mesh = i * mesh_count / draw_count;
+        const uint32_t material = i * material_count / draw_count;
+        context.ia_set_input_layout(resources.input_layout);
+        context.ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        context.vs_set_shader(resources.vertex_shader);
+        context.ps_set_shader(resources.pixel_shader);
+        const UINT stride = 24;
+        const UINT offset = 0;
+        context.ia_set_vertex_buffers(0, 1, &resources.vertex_buffers[mesh], &stride, &offset);
+        context.ia_set_index_buffer(resources.index_buffers[mesh], DXGI_FORMAT_R32_UINT, 0);
+        context.ps_set_shader_resources(0, 1, &resources.texture_views[material]);
+        context.ps_set_samplers(0, 1, &resources.sampler_state);
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (SUCCEEDED(context.map(resources.draw_constants, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        {
+            Transform transform{};
+            transform.m[0] = transform.m[5] = transform.m[10] = transform.m[15] = 1.f;
+            transform.m[12] = float(i);
+            std::memcpy(mapped.pData, &transform, sizeof(transform));
+            context.unmap(resources.draw_constants, 0);
+        }
+        context.vs_set_constant_buffers(1, 1, &resources.draw_constants);
+        context.draw_indexed(index_count, i, 0);
+    }
+}
+
+void frame(RenderBackend& context, const Resources& resources)
+{
+    context.clear_state();
+    const float clear_color[4] = { 0.f, 0.f, 0.f, 1.f };
+    context.clear_render_target_view(resources.target_view, clear_color);
+    context.clear_depth_stencil_view(resources.depth_view, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+    bind_targets(context, resources);
+    draw_range(context, resources, 0, draw_count);
+    context.present(1, 0);
+}
+
+// same draws recorded by deferred contexts on threads, executed in order
+void frame_with_command_lists(RenderBackend& context, const Resources& resources, uint32_t list_count)
+{
+    context.clear_state();
+    const float clear_color[4] = { 0.f, 0.f, 0.f, 1.f };
+    context.clear_render_target_view(resources.target_view, clear_color);
+    context.clear_depth_stencil_view(resources.depth_view, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+
+    std::vector<std::unique_ptr<RenderBackend>> lists;
+    for (uint32_t i = 0; i < list_count; ++i) {
+        lists.push_back(context.create_deferred_context());
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < list_count; ++i)
+    {
+        threads.emplace_back([&, i] {
+            bind_targets(*lists[i], resources);
+            draw_range(*lists[i], resources, draw_count * i / list_count, draw_count * (i + 1) / list_count);
+            lists[i]->finish_command_list();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& list : lists) {
+        context.execute_command_list(list.get());
+    }
+    context.present(1, 0);
+}
+
+uint64_t issued(const StateCache& cache, StateCache::State state)
+{
+    return cache.total_counters().issued[size_t(state)];
+}
+
+uint64_t elided(const StateCache& cache, StateCache::State state)
+{
+    return cache.total_counters().elided[size_t(state)];
+}
+
+void test_state_elision()
+{
+    StateCache cache(std::make_unique<NullBackend>());
+    auto backend = static_cast<NullBackend*>(cache.backend());
+    Resources resources;
+    resources.create(cache);
+
+    backend->reset();
+    cache.reset_counters();
+    frame(cache, resources);
+    cache.end_frame();
+
+    using Call = NullBackend::Call;
+    CHECK(backend->counter(Call::draw_indexed) == draw_count);
+    CHECK(backend->counter(Call::map) == draw_count);
+    CHECK(backend->counter(Call::unmap) == draw_count);
+    CHECK(backend->mapped_bytes() == uint64_t(draw_count) * sizeof(Transform));
+    // state which changes with sorted draws only
+    CHECK(backend->counter(Call::ia_set_input_layout) == 1);
+    CHECK(backend->counter(Call::ia_set_primitive_topology) == 1);
+    CHECK(backend->counter(Call::vs_set_shader) == 1);
+    CHECK(backend->counter(Call::ps_set_shader) == 1);
+    CHECK(backend->counter(Call::ia_set_vertex_buffers) == mesh_count);
+    CHECK(backend->counter(Call::ia_set_index_buffer) == mesh_count);
+    CHECK(backend->counter(Call::ps_set_shader_resources) == material_count);
+    CHECK(backend->counter(Call::ps_set_samplers) == 1);
+    // frame constants at slot 0, draw constants at slot 1
+    CHECK(backend->counter(Call::vs_set_constant_buffers) == 2);
+    CHECK(backend->counter(Call::ps_set_constant_buffers) == 1);
+    CHECK(backend->counter(Call::present) == 1);
+
+    CHECK(issued(cache, StateCache::State::input_layout) == 1);
+    CHECK(elided(cache, StateCache::State::input_layout) == draw_count - 1);
+    CHECK(issued(cache, StateCache::State::vertex_buffers) == mesh_count);
+    CHECK(elided(cache, StateCache::State::vertex_buffers) == draw_count - mesh_count);
+    CHECK(issued(cache, StateCache::State::shader_resources) == material_count);
+
+    // disabled cache forwards everything
+    backend->reset();
+    cache.reset_counters();
+    cache.set_enabled(false);
+    frame(cache, resources);
+    cache.end_frame();
+    CHECK(backend->counter(Call::ia_set_input_layout) == draw_count);
+    CHECK(backend->counter(Call::ia_set_vertex_buffers) == draw_count);
+    CHECK(backend->counter(Call::ps_set_shader_resources) == draw_count);
+    CHECK(elided(cache, StateCache::State::input_layout) == 0);
+
+    resources.release();
+}
+
+void test_command_log()
+{
+    NullBackend backend;
+    Resources resources;
+    resources.create(backend);
+
+    backend.reset();
+    backend.set_recording(true);
+    frame(backend, resources);
+    backend.set_recording(false);
+
+    using Call = NullBackend::Call;
+    auto commands = backend.commands();
+    CHECK(!commands.empty());
+    CHECK(commands.front().call == Call::clear_state);
+    CHECK(commands.back().call == Call::present);
+
+    // draws in order, each after its index buffer bind
+    uint32_t next_draw = 0;
+    uint64_t bound_index_buffer = 0;
+    for (const auto& command : commands)
+    {
+        if (command.call == Call::ia_set_index_buffer) {
+            bound_index_buffer = command.args[0];
+        }
+        if (command.call == Call::draw_indexed)
+        {
+            CHECK(command.args[0] == index_count);
+            CHECK(command.args[1] == next_draw);
+            CHECK(bound_index_buffer != 0);
+            ++next_draw;
+        }
+    }
+    CHECK(next_draw == draw_count);
+
+    // buffer contents follow updates
+    const uint32_t values[4] = { 1, 2, 3, 4 };
+    D3D11_BOX box{ 8, 0, 0, 8 + sizeof(values), 1, 1 };
+    backend.update_subresource1(resources.frame_constants, 0, &box, values, 0, 0, D3D11_COPY_NO_OVERWRITE);
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    CHECK(SUCCEEDED(backend.map(resources.frame_constants, 0, D3D11_MAP_READ, 0, &mapped)));
+    CHECK(std::memcmp(static_cast<uint8_t*>(mapped.pData) + 8, values, sizeof(values)) == 0);
+    backend.unmap(resources.frame_constants, 0);
+
+    resources.release();
+}
+
+void test_command_lists()
+{
+    constexpr uint32_t list_count = 4;
+    StateCache cache(std::make_unique<NullBackend>());
+    auto backend = static_cast<NullBackend*>(cache.backend());
+    Resources resources;
+    resources.create(cache);
+
+    backend->reset();
+    backend->set_recording(true);
+    frame_with_command_lists(cache, resources, list_count);
+    backend->set_recording(false);
+    cache.end_frame();
+
+    using Call = NullBackend::Call;
+    CHECK(backend->counter(Call::draw_indexed) == draw_count);
+    CHECK(backend->counter(Call::execute_command_list) == list_count);
+    CHECK(backend->counter(Call::finish_command_list) == list_count);
+    CHECK(backend->mapped_bytes() == uint64_t(draw_count) * sizeof(Transform));
+    // every list starts from default state: binds again what it uses
+    CHECK(backend->counter(Call::ia_set_input_layout) == list_count);
+    CHECK(backend->counter(Call::om_set_render_targets) == list_count);
+
+    // lists are executed in submission order, whatever thread finished first
+    uint32_t next_draw = 0;
+    for (const auto& command : backend->commands())
+    {
+        if (command.call == Call::draw_indexed)
+        {
+            CHECK(command.args[1] == next_draw);
+            ++next_draw;
+        }
+    }
+    CHECK(next_draw == draw_count);
+
+    resources.release();
+}
+
+double benchmark(uint32_t frame_count)
+{
+    StateCache cache(std::make_unique<NullBackend>());
+    Resources resources;
+    resources.create(cache);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        frame(cache, resources);
+        cache.end_frame();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    resources.release();
+    return ms / frame_count;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t frame_count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 200;
+
+    test_state_elision();
+    test_command_log();
+    test_command_lists();
+
+    std::printf("frames: %u, draws per frame: %u, ms per frame: %.4f\n", frame_count, draw_count, benchmark(frame_count));
+    if (failures != 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "core/path.h"
+#include "render/resource/shader_dependencies.h"
+
+// Checks of the shader include graph used by hot reload: which shaders recompile when a file
+// changes on disk, and how spellings of one file are matched.
+
+namespace
+{
+int failures = 0;
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);           \
+            ++failures;                                                                         \
+        }                                                                                       \
+    } while (0)
+
+// dependents() order is breadth first, not fixed within a level
+std::vector<std::string> sorted(std::vector<std::string> files)
+{
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void test_normalize_path()
+{
+    CHECK(normalize_path("Shaders\\Common\\Light.hlsli") == "shaders/common/light.hlsli");
+    CHECK(normalize_path("shaders/./common//light.hlsli") == "shaders/common/light.hlsli");
+    CHECK(normalize_path("shaders/deferred/../common/light.hlsli") == "shaders/common/light.hlsli");
+    CHECK(normalize_path("../shaders/light.hlsli") == "../shaders/light.hlsli");
+    CHECK(normalize_path("/shaders/../../light.hlsli") == "/light.hlsli");
+    CHECK(directory_of("shaders/common/light.hlsli") == "shaders/common/");
+    CHECK(directory_of("shaders\\light.hlsli") == "shaders\\");
+    CHECK(directory_of("light.hlsli").empty());
+}
+
+void test_transitive_dependents()
+{
+    // opaque.hlsl -> gbuffer.hlsli -> common.hlsli <- light.hlsl
+    ShaderDependencies dependencies;
+    dependencies.set_includes("shaders/opaque.hlsl", { "shaders/gbuffer.hlsli" });
+    dependencies.set_includes("shaders/gbuffer.hlsli", { "shaders/common.hlsli" });
+    dependencies.set_includes("shaders/light.hlsl", { "shaders/common.hlsli" });
+
+    CHECK(sorted(dependencies.dependents("shaders/common.hlsli")) ==
+          sorted({ "shaders/common.hlsli", "shaders/gbuffer.hlsli", "shaders/opaque.hlsl", "shaders/light.hlsl" }));
+    CHECK(sorted(dependencies.dependents("shaders/gbuffer.hlsli")) ==
+          sorted({ "shaders/gbuffer.hlsli", "shaders/opaque.hlsl" }));
+    CHECK(dependencies.dependents("shaders/opaque.hlsl") == std::vector<std::string>{ "shaders/opaque.hlsl" });
+    // unknown file depends on nothing but itself
+    CHECK(dependencies.dependents("shaders/unused.hlsli") == std::vector<std::string>{ "shaders/unused.hlsli" });
+    CHECK(dependencies.file_count() == 4);
+}
+
+void test_include_cycle()
+{
+    // a -> b -> c -> a, guarded includes of each other
+    ShaderDependencies dependencies;
+    dependencies.set_includes("a.hlsli", { "b.hlsli" });
+    dependencies.set_includes("b.hlsli", { "c.hlsli" });
+    dependencies.set_includes("c.hlsli", { "a.hlsli" });
+    dependencies.set_includes("main.hlsl", { "a.hlsli" });
+
+    CHECK(sorted(dependencies.dependents("c.hlsli")) == sorted({ "a.hlsli", "b.hlsli", "c.hlsli", "main.hlsl" }));
+    // self include
+    dependencies.set_includes("self.hlsli", { "self.hlsli" });
+    CHECK(dependencies.dependents("self.hlsli") == std::vector<std::string>{ "self.hlsli" });
+}
+
+void test_set_includes_replaces_edges()
+{
+    ShaderDependencies dependencies;
+    dependencies.set_includes("main.hlsl", { "old.hlsli", "shared.hlsli" });
+    CHECK(sorted(dependencies.dependents("old.hlsli")) == sorted({ "old.hlsli", "main.hlsl" }));
+
+    // recompiled file no longer includes old.hlsli
+    dependencies.set_includes("main.hlsl", { "new.hlsli", "shared.hlsli" });
+    CHECK(dependencies.includes("main.hlsl") == (std::vector<std::string>{ "new.hlsli", "shared.hlsli" }));
+    CHECK(dependencies.dependents("old.hlsli") == std::vector<std::string>{ "old.hlsli" });
+    CHECK(!dependencies.contains("old.hlsli"));
+    CHECK(sorted(dependencies.dependents("new.hlsli")) == sorted({ "new.hlsli", "main.hlsl" }));
+    CHECK(sorted(dependencies.dependents("shared.hlsli")) == sorted({ "shared.hlsli", "main.hlsl" }));
+
+    // no includes at all, file itself stays known
+    dependencies.set_includes("main.hlsl", {});
+    CHECK(dependencies.includes("main.hlsl").empty());
+    CHECK(dependencies.dependents("shared.hlsli") == std::vector<std::string>{ "shared.hlsli" });
+    CHECK(dependencies.contains("main.hlsl"));
+    CHECK(dependencies.file_count() == 1);
+
+    dependencies.clear();
+    CHECK(dependencies.file_count() == 0);
+}
+
+void test_spellings()
+{
+    // compiler and file watcher spell the same file differently
+    ShaderDependencies dependencies;
+    dependencies.set_includes("Shaders\\Opaque.hlsl",
+                              { "Shaders\\Deferred\\..\\Common.hlsli", "shaders/common.hlsli", "./Shaders/GBuffer.hlsli" });
+    CHECK(dependencies.includes("shaders/opaque.hlsl") ==
+          (std::vector<std::string>{ "shaders/common.hlsli", "shaders/gbuffer.hlsli" }));
+    CHECK(sorted(dependencies.dependents("SHADERS/common.hlsli")) == sorted({ "shaders/common.hlsli", "shaders/opaque.hlsl" }));
+    CHECK(dependencies.contains("shaders\\gbuffer.hlsli"));
+    CHECK(dependencies.file_count() == 3);
+}
+}
+
+int main()
+{
+    test_normalize_path();
+    test_transitive_dependents();
+    test_include_cycle();
+    test_set_includes_replaces_edges();
+    test_spellings();
+
+    if (failures != 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}